@@ -8,6 +8,7 @@
 #include "harddisk.h"
 #include "artwork.h"
 #include "bootstrap.h"
+#include "unzip.h"
 #include <stdarg.h>
 #include <ctype.h>
 #include <string/stdstring.h>
@@ -194,6 +195,17 @@ static struct chd_file *disk_handle[4];
 /* system BIOS */
 static int system_bios;
 
+/* ROM files of the current region, opened ahead of time by the workers */
+struct rom_prefetch
+{
+	const struct RomModule *romp;	/* the ROM_LOAD entry */
+	mame_file *file;				/* the file, inflated and hashed, or NULL if missing */
+};
+
+static struct osd_work_queue *rom_work_queue;
+static struct rom_prefetch *rom_prefetch_list;
+static struct rom_prefetch *rom_prefetch_next;
+
 
 /***************************************************************************
 	Functions
@@ -1465,24 +1477,125 @@ static void region_post_process(struct rom_load_data *romdata, const struct RomM
 
 
 /*-------------------------------------------------
-	open_rom_file - open a ROM file, searching
+	find_rom_file - open a ROM file, searching
 	up the parent and loading by checksum
 -------------------------------------------------*/
 
-static int open_rom_file(struct rom_load_data *romdata, const struct RomModule *romp)
+static mame_file *find_rom_file(const struct RomModule *romp)
 {
 	const struct GameDriver *drv;
-
-	++romdata->romsloaded;
+	mame_file *file = NULL;
 
 	/* Attempt reading up the chain through the parents. It automatically also
 	   attempts any kind of load by checksum supported by the archives. */
-	romdata->file = NULL;
-	for (drv = Machine->gamedrv; !romdata->file && drv; drv = drv->clone_of)
-  {
+	for (drv = Machine->gamedrv; !file && drv; drv = drv->clone_of)
+	{
 		if (drv->name && *drv->name)
-			romdata->file = mame_fopen_rom(drv->name, ROM_GETNAME(romp), ROM_GETHASHDATA(romp));
-  }
+			file = mame_fopen_rom(drv->name, ROM_GETNAME(romp), ROM_GETHASHDATA(romp));
+	}
+
+	return file;
+}
+
+
+/*-------------------------------------------------
+	rom_file_wanted - is this ROM_LOAD loaded for
+	the selected BIOS
+-------------------------------------------------*/
+
+static INLINE int rom_file_wanted(const struct RomModule *romp)
+{
+	return !ROM_GETBIOSFLAGS(romp) || (ROM_GETBIOSFLAGS(romp) == (system_bios+1)); /* alternate bios sets */
+}
+
+
+/*-------------------------------------------------
+	prefetch_rom_file - work item opening one
+	ROM file; the zip is inflated and hashed on
+	the worker
+-------------------------------------------------*/
+
+static void prefetch_rom_file(void *param)
+{
+	struct rom_prefetch *prefetch = param;
+	prefetch->file = find_rom_file(prefetch->romp);
+}
+
+
+/*-------------------------------------------------
+	prefetch_rom_files - open all the files of a
+	region on the workers, so that only placing
+	the data is left for process_rom_entries
+-------------------------------------------------*/
+
+static void prefetch_rom_files(const struct RomModule *romp)
+{
+	const struct RomModule *rom;
+	int count = 0;
+
+	if (!rom_work_queue)
+		return;
+
+	/* count the files; a single one isn't worth the handoff */
+	for (rom = romp; !ROMENTRY_ISREGIONEND(rom); rom++)
+		if (ROMENTRY_ISFILE(rom) && rom_file_wanted(rom))
+			count++;
+	if (count < 2)
+		return;
+
+	rom_prefetch_list = calloc(count + 1, sizeof(*rom_prefetch_list));
+	if (!rom_prefetch_list)
+		return;
+
+	/* queue them in order; the list ends with a NULL romp */
+	count = 0;
+	for (rom = romp; !ROMENTRY_ISREGIONEND(rom); rom++)
+		if (ROMENTRY_ISFILE(rom) && rom_file_wanted(rom))
+		{
+			rom_prefetch_list[count].romp = rom;
+			osd_work_item_queue(rom_work_queue, prefetch_rom_file, &rom_prefetch_list[count]);
+			count++;
+		}
+
+	osd_work_queue_wait(rom_work_queue);
+	rom_prefetch_next = rom_prefetch_list;
+}
+
+
+/*-------------------------------------------------
+	release_prefetched_files - close whatever
+	process_rom_entries didn't use
+-------------------------------------------------*/
+
+static void release_prefetched_files(void)
+{
+	struct rom_prefetch *prefetch;
+
+	if (!rom_prefetch_list)
+		return;
+
+	for (prefetch = rom_prefetch_next; prefetch->romp; prefetch++)
+		if (prefetch->file)
+			mame_fclose(prefetch->file);
+
+	free(rom_prefetch_list);
+	rom_prefetch_list = rom_prefetch_next = NULL;
+}
+
+
+/*-------------------------------------------------
+	open_rom_file - open a ROM file, taking the
+	prefetched one if there is one
+-------------------------------------------------*/
+
+static int open_rom_file(struct rom_load_data *romdata, const struct RomModule *romp)
+{
+	++romdata->romsloaded;
+
+	if (rom_prefetch_next && rom_prefetch_next->romp == romp)
+		romdata->file = (rom_prefetch_next++)->file;
+	else
+		romdata->file = find_rom_file(romp);
 
 	/* return the result */
 	return (romdata->file != NULL);
@@ -1711,6 +1824,9 @@ static int process_rom_entries(struct rom_load_data *romdata, const struct RomMo
 {
 	UINT32 lastflags = 0;
 
+	/* inflate and hash the files up front, in parallel where we can */
+	prefetch_rom_files(romp);
+
 	/* loop until we hit the end of this region */
 	while (!ROMENTRY_ISREGIONEND(romp))
 	{
@@ -1745,7 +1861,7 @@ static int process_rom_entries(struct rom_load_data *romdata, const struct RomMo
 		/* handle files */
 		else if (ROMENTRY_ISFILE(romp))
 		{
-			if (!ROM_GETBIOSFLAGS(romp) || (ROM_GETBIOSFLAGS(romp) == (system_bios+1))) /* alternate bios sets */
+			if (rom_file_wanted(romp))
 			{
 				const struct RomModule *baserom = romp;
 				int explength = 0;
@@ -1809,6 +1925,7 @@ static int process_rom_entries(struct rom_load_data *romdata, const struct RomMo
 			}
 		}
 	}
+	release_prefetched_files();
 	return 1;
 
 	/* error case */
@@ -1816,6 +1933,7 @@ fatalerror:
 	if (romdata->file)
 		mame_fclose(romdata->file);
 	romdata->file = NULL;
+	release_prefetched_files();
 	return 0;
 }
 
@@ -1932,6 +2050,23 @@ static int process_disk_entries(struct rom_load_data *romdata, const struct RomM
 }
 
 
+/*-------------------------------------------------
+	rom_load_finish - shut down the ROM loading
+	work queue and save what was verified
+-------------------------------------------------*/
+
+static void rom_load_finish(void)
+{
+	if (rom_work_queue)
+	{
+		osd_work_queue_free(rom_work_queue);
+		rom_work_queue = NULL;
+		unzip_set_threaded(0);
+	}
+	mame_verify_cache_close();
+}
+
+
 /*-------------------------------------------------
 	rom_load - new, more flexible ROM
 	loading system
@@ -1958,6 +2093,14 @@ int rom_load(const struct RomModule *romp)
 	/* determine the correct biosset to load based on options.bios string */
 	system_bios = determine_bios_rom(Machine->gamedrv->bios);
 
+	/* hashes from previous loads of unchanged files */
+	mame_verify_cache_open(Machine->gamedrv->name);
+
+	/* start the workers that inflate and hash the ROM files */
+	rom_work_queue = osd_work_queue_alloc(osd_num_processors());
+	if (rom_work_queue)
+		unzip_set_threaded(1);
+
 	/* loop until we hit the end */
 	for (region = romp, regnum = 0; region; region = rom_next_region(region), regnum++)
 	{
@@ -1969,6 +2112,7 @@ int rom_load(const struct RomModule *romp)
 		if (!ROMENTRY_ISREGION(region))
 		{
 			log_cb(RETRO_LOG_ERROR, LOGPRE "Error: missing ROM_REGION header\n");
+			rom_load_finish();
 			return 1;
 		}
 
@@ -1980,6 +2124,7 @@ int rom_load(const struct RomModule *romp)
 		if (new_memory_region(regiontype, ROMREGION_GETLENGTH(region), ROMREGION_GETFLAGS(region)))
 		{
 			log_cb(RETRO_LOG_ERROR, LOGPRE "Error: unable to allocate memory for region %d\n", regiontype);
+			rom_load_finish();
 			return 1;
 		}
 
@@ -2006,12 +2151,18 @@ int rom_load(const struct RomModule *romp)
 		if (ROMREGION_ISROMDATA(region))
 		{
 			if (!process_rom_entries(&romdata, region + 1))
+			{
+				rom_load_finish();
 				return 1;
+			}
 		}
 		else if (ROMREGION_ISDISKDATA(region))
 		{
 			if (!process_disk_entries(&romdata, region + 1))
+			{
+				rom_load_finish();
 				return 1;
+			}
 		}
 
 		/* add this region to the list */
@@ -2019,6 +2170,8 @@ int rom_load(const struct RomModule *romp)
 			regionlist[regiontype] = region;
 	}
 
+	rom_load_finish();
+
 	/* post-process the regions */
 	for (regnum = 0; regnum < REGION_MAX; regnum++)
 		if (regionlist[regnum])
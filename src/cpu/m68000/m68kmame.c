@@ -14,16 +14,58 @@ struct m68k_memory_interface m68k_memory_intf;
  * 24-bit address, 16-bit data memory interface
  ****************************************************************************/
 
+/* RAM, ROM and banks are reached through the direct data runs; only a */
+/* miss, or memory with handlers, goes through the lookup tables */
+static data16_t readword_a24_d16(offs_t address)
+{
+	UINT8 *base;
+
+	address &= mem_amask & ~1;
+	if ((base = memory_direct_lookup(memory_direct_read, address)) != NULL ||
+			(base = cpu_setdirectread24bew(address)) != NULL)
+		return *(data16_t *)&base[address];
+	return cpu_readmem24bew_word(address);
+}
+
 static data32_t readlong_a24_d16(offs_t address)
 {
-	data32_t result = cpu_readmem24bew_word(address) << 16;
-	return result | cpu_readmem24bew_word(address + 2);
+	data32_t result;
+	UINT8 *base;
+
+	address &= mem_amask & ~1;
+	if ((base = memory_direct_lookup(memory_direct_read, address)) != NULL)
+		return (*(data16_t *)&base[address] << 16) | *(data16_t *)&base[address + 2];
+
+	result = readword_a24_d16(address) << 16;
+	return result | readword_a24_d16(address + 2);
+}
+
+static void writeword_a24_d16(offs_t address, data16_t data)
+{
+	UINT8 *base;
+
+	address &= mem_amask & ~1;
+	if ((base = memory_direct_lookup(memory_direct_write, address)) != NULL ||
+			(base = cpu_setdirectwrite24bew(address)) != NULL)
+		*(data16_t *)&base[address] = data;
+	else
+		cpu_writemem24bew_word(address, data);
 }
 
 static void writelong_a24_d16(offs_t address, data32_t data)
 {
-	cpu_writemem24bew_word(address, data >> 16);
-	cpu_writemem24bew_word(address + 2, data);
+	UINT8 *base;
+
+	address &= mem_amask & ~1;
+	if ((base = memory_direct_lookup(memory_direct_write, address)) != NULL)
+	{
+		*(data16_t *)&base[address] = data >> 16;
+		*(data16_t *)&base[address + 2] = data;
+		return;
+	}
+
+	writeword_a24_d16(address, data >> 16);
+	writeword_a24_d16(address + 2, data);
 }
 
 static void changepc_a24_d16(offs_t pc)
@@ -36,10 +78,10 @@ static const struct m68k_memory_interface interface_a24_d16 =
 {
 	0,
 	cpu_readmem24bew,
-	cpu_readmem24bew_word,
+	readword_a24_d16,
 	readlong_a24_d16,
 	cpu_writemem24bew,
-	cpu_writemem24bew_word,
+	writeword_a24_d16,
 	writelong_a24_d16,
 	changepc_a24_d16
 };
@@ -263,7 +263,10 @@ static void writemem32ledw_double(offs_t offset, UINT64 data);
 **	PUBLIC GLOBAL VARIABLES
 **#################################################################################################*/
 
+/* when built as the DRC's fallback (mips3int.c) the icount is mips3drc.c's */
+#ifndef MIPS3_DRC_FALLBACK
 int	mips3_icount=50000;
+#endif
 
 
 
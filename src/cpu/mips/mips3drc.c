@@ -190,6 +190,7 @@ typedef struct
 
 	/* internal stuff */
 	struct drccore *drc;
+	UINT8		interpreted;	/* the recompiler couldn't start; mips3int.c runs this CPU */
 	UINT32		drcoptions;
 	UINT32		nextpc;
 	int 		(*irq_callback)(int irqline);
@@ -243,6 +244,28 @@ static UINT32 recompile_cop1x(struct drccore *drc, UINT32 pc, UINT32 op);
 
 static void update_cycle_counting(void);
 
+/* the interpreter, built from mips3.c by mips3int.c; an interpreted CPU's */
+/* context follows the mips3_regs holding the interpreted flag */
+#define INTERP_CONTEXT(c)	((c) ? (void *)((UINT8 *)(c) + sizeof(mips3_regs)) : NULL)
+
+extern void mips3int_init(void);
+extern void mips3int_exit(void);
+extern int mips3int_execute(int cycles);
+extern unsigned mips3int_get_context(void *dst);
+extern void mips3int_set_context(void *src);
+extern unsigned mips3int_get_reg(int regnum);
+extern void mips3int_set_reg(int regnum, unsigned val);
+extern void mips3int_set_irq_line(int irqline, int state);
+extern void mips3int_set_irq_callback(int (*callback)(int irqline));
+extern unsigned mips3int_dasm(char *buffer, unsigned pc);
+extern const char *mips3int_info(void *context, int regnum);
+extern const char *mips3int_r4600_info(void *context, int regnum);
+extern void mips3int_r4600be_reset(void *param);
+extern void mips3int_r4600le_reset(void *param);
+extern const char *mips3int_r5000_info(void *context, int regnum);
+extern void mips3int_r5000be_reset(void *param);
+extern void mips3int_r5000le_reset(void *param);
+
 
 
 /*###################################################################################################
@@ -296,6 +319,12 @@ static const memory_handlers le_memory =
 
 void mips3_set_irq_line(int irqline, int state)
 {
+	if (mips3.interpreted)
+	{
+		mips3int_set_irq_line(irqline, state);
+		return;
+	}
+
 	if (state != CLEAR_LINE)
 		mips3.cpr[0][COP0_Cause] |= 0x400 << irqline;
 	else
@@ -305,6 +334,12 @@ void mips3_set_irq_line(int irqline, int state)
 
 void mips3_set_irq_callback(int (*callback)(int irqline))
 {
+	if (mips3.interpreted)
+	{
+		mips3int_set_irq_callback(callback);
+		return;
+	}
+
 	mips3.irq_callback = callback;
 }
 
@@ -318,10 +353,14 @@ unsigned mips3_get_context(void *dst)
 {
 	/* copy the context */
 	if (dst)
+	{
 		*(mips3_regs *)dst = mips3;
+		if (mips3.interpreted)
+			mips3int_get_context(INTERP_CONTEXT(dst));
+	}
 
-	/* return the context size */
-	return sizeof(mips3_regs);
+	/* return the context size, with room for the interpreter's */
+	return sizeof(mips3_regs) + mips3int_get_context(NULL);
 }
 
 
@@ -329,7 +368,11 @@ void mips3_set_context(void *src)
 {
 	/* copy the context */
 	if (src)
+	{
 		mips3 = *(mips3_regs *)src;
+		if (mips3.interpreted)
+			mips3int_set_context(INTERP_CONTEXT(src));
+	}
 }
 
 
@@ -363,8 +406,15 @@ void mips3_init(void)
 	drconfig.cb_recompile     = mips3drc_recompile;
 	drconfig.cb_entrygen      = mips3drc_entrygen;
 	
-	/* initialize the compiler */
+	/* initialize the compiler, or leave the CPU to the interpreter */
 	mips3.drc = drc_init(cpu_getactivecpu(), &drconfig);
+	mips3.interpreted = (mips3.drc == NULL);
+	if (mips3.interpreted)
+	{
+		log_cb(RETRO_LOG_WARN, LOGPRE "mips3_init: couldn't initialize the recompiler, using the interpreter\n");
+		mips3int_init();
+		return;
+	}
 	mips3.drcoptions = MIPS3DRC_FASTEST_OPTIONS;
 
 	/* allocate a timer */
@@ -413,6 +463,12 @@ static void mips3_reset(void *param, int bigendian)
 #if HAS_R4600
 void r4600be_reset(void *param)
 {
+	if (mips3.interpreted)
+	{
+		mips3int_r4600be_reset(param);
+		return;
+	}
+
 	mips3_reset(param, 1);
 	mips3.cpr[0][COP0_PRId] = 0x2000;
 	mips3.is_mips4 = 0;
@@ -420,6 +476,12 @@ void r4600be_reset(void *param)
 
 void r4600le_reset(void *param)
 {
+	if (mips3.interpreted)
+	{
+		mips3int_r4600le_reset(param);
+		return;
+	}
+
 	mips3_reset(param, 0);
 	mips3.cpr[0][COP0_PRId] = 0x2000;
 	mips3.is_mips4 = 0;
@@ -430,6 +492,12 @@ void r4600le_reset(void *param)
 #if HAS_R5000
 void r5000be_reset(void *param)
 {
+	if (mips3.interpreted)
+	{
+		mips3int_r5000be_reset(param);
+		return;
+	}
+
 	mips3_reset(param, 1);
 	mips3.cpr[0][COP0_PRId] = 0x2300;
 	mips3.is_mips4 = 1;
@@ -437,6 +505,12 @@ void r5000be_reset(void *param)
 
 void r5000le_reset(void *param)
 {
+	if (mips3.interpreted)
+	{
+		mips3int_r5000le_reset(param);
+		return;
+	}
+
 	mips3_reset(param, 0);
 	mips3.cpr[0][COP0_PRId] = 0x2300;
 	mips3.is_mips4 = 1;
@@ -453,6 +527,9 @@ void mips3drc_set_options(UINT8 cpunum, UINT32 opts)
 
 int mips3_execute(int cycles)
 {
+	if (mips3.interpreted)
+		return mips3int_execute(cycles);
+
 	/* update the cycle timing */
 	update_cycle_counting();
 
@@ -465,6 +542,12 @@ int mips3_execute(int cycles)
 
 void mips3_exit(void)
 {
+	if (mips3.interpreted)
+	{
+		mips3int_exit();
+		return;
+	}
+
 	/* free cache memory */
 	if (mips3.icache)
 		free(mips3.icache);
@@ -540,6 +623,20 @@ static void update_cycle_counting(void)
 
 
 
+/*------------------------------------------------------------------
+	invalidate_icache_line
+------------------------------------------------------------------*/
+
+static void invalidate_icache_line(UINT32 address)
+{
+	/* the code the line held may have changed; lines are at most 32 bytes */
+	address &= ~31;
+	memory_invalidate_opcodes(cpu_getactivecpu(), address, address + 31);
+	drc_sync_opcodes(mips3.drc);
+}
+
+
+
 /*------------------------------------------------------------------
 	logtlbentry
 ------------------------------------------------------------------*/
@@ -624,8 +721,8 @@ static void mips3drc_recompile(struct drccore *drc)
 	if (remaining == 0)
 		drc_append_dispatcher(drc);
 	
-	/* end the sequence */
-	drc_end_sequence(drc);
+	/* end the sequence; a final branch leaves pc on itself, so count its delay slot */
+	drc_end_sequence(drc, pc + 7);
 
 #if LOG_CODE
 {
@@ -947,7 +1044,7 @@ static UINT32 recompile_lui(struct drccore *drc, UINT32 pc, UINT32 op)
 					memory = memory_get_read_ptr(cpu_getactivecpu(), BYTE4_XOR_BE(address + nextsimm));
 				else
 					memory = memory_get_read_ptr(cpu_getactivecpu(), address + nextsimm);
-				if (!memory)
+				if (!memory || !drc_in_reach(drc, memory))
 					break;
 				
 				/* do the LUI anyway if we're not reading to the same register */
@@ -967,7 +1064,7 @@ static UINT32 recompile_lui(struct drccore *drc, UINT32 pc, UINT32 op)
 					memory = memory_get_read_ptr(cpu_getactivecpu(), BYTE4_XOR_BE(address + nextsimm));
 				else
 					memory = memory_get_read_ptr(cpu_getactivecpu(), address + nextsimm);
-				if (!memory)
+				if (!memory || !drc_in_reach(drc, memory))
 					break;
 				
 				/* do the LUI anyway if we're not reading to the same register */
@@ -984,7 +1081,7 @@ static UINT32 recompile_lui(struct drccore *drc, UINT32 pc, UINT32 op)
 
 				/* see if this points to a RAM-like area */
 				memory = memory_get_read_ptr(cpu_getactivecpu(), address + nextsimm);
-				if (!memory)
+				if (!memory || !drc_in_reach(drc, memory))
 					break;
 				
 				/* do the LUI anyway if we're not reading to the same register */
@@ -1004,7 +1101,7 @@ static UINT32 recompile_lui(struct drccore *drc, UINT32 pc, UINT32 op)
 					memory = memory_get_read_ptr(cpu_getactivecpu(), BYTE4_XOR_BE(address + nextsimm));
 				else
 					memory = memory_get_read_ptr(cpu_getactivecpu(), address + nextsimm);
-				if (!memory)
+				if (!memory || !drc_in_reach(drc, memory))
 					break;
 				
 				/* do the LUI anyway if we're not reading to the same register */
@@ -1024,7 +1121,7 @@ static UINT32 recompile_lui(struct drccore *drc, UINT32 pc, UINT32 op)
 					memory = memory_get_read_ptr(cpu_getactivecpu(), BYTE4_XOR_BE(address + nextsimm));
 				else
 					memory = memory_get_read_ptr(cpu_getactivecpu(), address + nextsimm);
-				if (!memory)
+				if (!memory || !drc_in_reach(drc, memory))
 					break;
 				
 				/* do the LUI anyway if we're not reading to the same register */
@@ -1041,7 +1138,7 @@ static UINT32 recompile_lui(struct drccore *drc, UINT32 pc, UINT32 op)
 
 				/* see if this points to a RAM-like area */
 				memory = memory_get_read_ptr(cpu_getactivecpu(), address + nextsimm);
-				if (!memory)
+				if (!memory || !drc_in_reach(drc, memory))
 					break;
 				
 				/* do the LUI anyway if we're not reading to the same register */
@@ -1058,7 +1155,7 @@ static UINT32 recompile_lui(struct drccore *drc, UINT32 pc, UINT32 op)
 
 				/* see if this points to a RAM-like area */
 				memory = memory_get_read_ptr(cpu_getactivecpu(), address + nextsimm);
-				if (!memory)
+				if (!memory || !drc_in_reach(drc, memory))
 					break;
 				
 				/* do the LUI anyway */
@@ -1073,7 +1170,7 @@ static UINT32 recompile_lui(struct drccore *drc, UINT32 pc, UINT32 op)
 
 				/* see if this points to a RAM-like area */
 				memory = memory_get_read_ptr(cpu_getactivecpu(), address + nextsimm);
-				if (!memory)
+				if (!memory || !drc_in_reach(drc, memory))
 					break;
 				
 				/* do the LUI anyway */
@@ -1088,7 +1185,7 @@ static UINT32 recompile_lui(struct drccore *drc, UINT32 pc, UINT32 op)
 
 				/* see if this points to a RAM-like area */
 				memory = memory_get_read_ptr(cpu_getactivecpu(), address + nextsimm);
-				if (!memory)
+				if (!memory || !drc_in_reach(drc, memory))
 					break;
 				
 				/* do the LUI anyway */
@@ -1103,7 +1200,7 @@ static UINT32 recompile_lui(struct drccore *drc, UINT32 pc, UINT32 op)
 
 				/* see if this points to a RAM-like area */
 				memory = memory_get_read_ptr(cpu_getactivecpu(), address + nextsimm);
-				if (!memory)
+				if (!memory || !drc_in_reach(drc, memory))
 					break;
 				
 				/* do the LUI anyway */
@@ -1118,7 +1215,7 @@ static UINT32 recompile_lui(struct drccore *drc, UINT32 pc, UINT32 op)
 
 				/* see if this points to a RAM-like area */
 				memory = memory_get_read_ptr(cpu_getactivecpu(), address + nextsimm);
-				if (!memory)
+				if (!memory || !drc_in_reach(drc, memory))
 					break;
 				
 				/* do the LUI anyway if we're not reading to the same register */
@@ -1137,7 +1234,7 @@ static UINT32 recompile_lui(struct drccore *drc, UINT32 pc, UINT32 op)
 					memory = memory_get_write_ptr(cpu_getactivecpu(), BYTE4_XOR_BE(address + nextsimm));
 				else
 					memory = memory_get_write_ptr(cpu_getactivecpu(), address + nextsimm);
-				if (!memory)
+				if (!memory || !drc_in_reach(drc, memory))
 					break;
 				
 				/* do the LUI anyway */
@@ -1160,7 +1257,7 @@ static UINT32 recompile_lui(struct drccore *drc, UINT32 pc, UINT32 op)
 					memory = memory_get_write_ptr(cpu_getactivecpu(), BYTE4_XOR_BE(address + nextsimm));
 				else
 					memory = memory_get_write_ptr(cpu_getactivecpu(), address + nextsimm);
-				if (!memory)
+				if (!memory || !drc_in_reach(drc, memory))
 					break;
 				
 				/* do the LUI anyway */
@@ -1180,7 +1277,7 @@ static UINT32 recompile_lui(struct drccore *drc, UINT32 pc, UINT32 op)
 
 				/* see if this points to a RAM-like area */
 				memory = memory_get_write_ptr(cpu_getactivecpu(), address + nextsimm);
-				if (!memory)
+				if (!memory || !drc_in_reach(drc, memory))
 					break;
 				
 				/* do the LUI anyway */
@@ -1200,7 +1297,7 @@ static UINT32 recompile_lui(struct drccore *drc, UINT32 pc, UINT32 op)
 
 				/* see if this points to a RAM-like area */
 				memory = memory_get_write_ptr(cpu_getactivecpu(), address + nextsimm);
-				if (!memory)
+				if (!memory || !drc_in_reach(drc, memory))
 					break;
 				
 				/* do the LUI anyway */
@@ -1215,7 +1312,7 @@ static UINT32 recompile_lui(struct drccore *drc, UINT32 pc, UINT32 op)
 
 				/* see if this points to a RAM-like area */
 				memory = memory_get_write_ptr(cpu_getactivecpu(), address + nextsimm);
-				if (!memory)
+				if (!memory || !drc_in_reach(drc, memory))
 					break;
 				
 				/* do the LUI anyway */
@@ -1230,7 +1327,7 @@ static UINT32 recompile_lui(struct drccore *drc, UINT32 pc, UINT32 op)
 
 				/* see if this points to a RAM-like area */
 				memory = memory_get_write_ptr(cpu_getactivecpu(), address + nextsimm);
-				if (!memory)
+				if (!memory || !drc_in_reach(drc, memory))
 					break;
 				
 				/* do the LUI anyway */
@@ -1245,7 +1342,7 @@ static UINT32 recompile_lui(struct drccore *drc, UINT32 pc, UINT32 op)
 
 				/* see if this points to a RAM-like area */
 				memory = memory_get_write_ptr(cpu_getactivecpu(), address + nextsimm);
-				if (!memory)
+				if (!memory || !drc_in_reach(drc, memory))
 					break;
 				
 				/* do the LUI anyway */
@@ -1260,7 +1357,7 @@ static UINT32 recompile_lui(struct drccore *drc, UINT32 pc, UINT32 op)
 
 				/* see if this points to a RAM-like area */
 				memory = memory_get_write_ptr(cpu_getactivecpu(), address + nextsimm);
-				if (!memory)
+				if (!memory || !drc_in_reach(drc, memory))
 					break;
 				
 				/* do the LUI anyway */
@@ -1871,10 +1968,10 @@ static UINT32 recompile_instruction(struct drccore *drc, UINT32 pc)
 				_shld_r32_r32_cl(REG_EDX, REG_EAX);									/* shld	edx,eax,cl*/
 				_shl_r32_cl(REG_EAX);												/* shl	eax,cl*/
 				_mov_r32_m32abs(REG_EBX, LO(&mips3.r[RTREG]));						/* mov	ebx,[rtreg].lo*/
-				_and_r32_m32bd(REG_EBX, REG_ECX, ldl_mask + 1);						/* and	ebx,[ldl_mask + ecx + 4]*/
+				_and_r32_m32tbl(REG_EBX, REG_ECX, ldl_mask + 1);					/* and	ebx,[ldl_mask + ecx + 4]*/
 				_or_r32_r32(REG_EAX, REG_EBX);										/* or	eax,ebx*/
 				_mov_r32_m32abs(REG_EBX, HI(&mips3.r[RTREG]));						/* mov	ebx,[rtreg].hi*/
-				_and_r32_m32bd(REG_EBX, REG_ECX, ldl_mask);							/* and	ebx,[ldl_mask + ecx]*/
+				_and_r32_m32tbl(REG_EBX, REG_ECX, ldl_mask);						/* and	ebx,[ldl_mask + ecx]*/
 				_or_r32_r32(REG_EDX, REG_EBX);										/* or	edx,ebx*/
 				_mov_m64abs_r64(&mips3.r[RTREG], REG_EDX, REG_EAX);					/* mov	[rtreg],edx:eax*/
 			}
@@ -1928,10 +2025,10 @@ static UINT32 recompile_instruction(struct drccore *drc, UINT32 pc)
 				_shrd_r32_r32_cl(REG_EAX, REG_EDX);									/* shrd	eax,edx,cl*/
 				_shr_r32_cl(REG_EDX);												/* shr	edx,cl*/
 				_mov_r32_m32abs(REG_EBX, LO(&mips3.r[RTREG]));						/* mov	ebx,[rtreg].lo*/
-				_and_r32_m32bd(REG_EBX, REG_ECX, ldr_mask + 1);						/* and	ebx,[ldr_mask + ecx + 4]*/
+				_and_r32_m32tbl(REG_EBX, REG_ECX, ldr_mask + 1);					/* and	ebx,[ldr_mask + ecx + 4]*/
 				_or_r32_r32(REG_EAX, REG_EBX);										/* or	eax,ebx*/
 				_mov_r32_m32abs(REG_EBX, HI(&mips3.r[RTREG]));						/* mov	ebx,[rtreg].hi*/
-				_and_r32_m32bd(REG_EBX, REG_ECX, ldr_mask);							/* and	ebx,[ldr_mask + ecx]*/
+				_and_r32_m32tbl(REG_EBX, REG_ECX, ldr_mask);						/* and	ebx,[ldr_mask + ecx]*/
 				_or_r32_r32(REG_EDX, REG_EBX);										/* or	edx,ebx*/
 				_mov_m64abs_r64(&mips3.r[RTREG], REG_EDX, REG_EAX);					/* mov	[rtreg],edx:eax*/
 			}
@@ -2012,7 +2109,7 @@ static UINT32 recompile_instruction(struct drccore *drc, UINT32 pc)
 					_xor_r32_imm(REG_ECX, 0x18);									/* xor	ecx,0x18*/
 				_shl_r32_cl(REG_EAX);												/* shl	eax,cl*/
 				_mov_r32_m32abs(REG_EBX, LO(&mips3.r[RTREG]));						/* mov	ebx,[rtreg].lo*/
-				_and_r32_m32bd(REG_EBX, REG_ECX, ldl_mask + 1);						/* and	ebx,[ldl_mask + ecx + 4]*/
+				_and_r32_m32tbl(REG_EBX, REG_ECX, ldl_mask + 1);					/* and	ebx,[ldl_mask + ecx + 4]*/
 				_or_r32_r32(REG_EAX, REG_EBX);										/* or	eax,ebx*/
 				_cdq();																/* cdq*/
 				_mov_m64abs_r64(&mips3.r[RTREG], REG_EDX, REG_EAX);					/* mov	[rtreg],edx:eax*/
@@ -2116,7 +2213,7 @@ static UINT32 recompile_instruction(struct drccore *drc, UINT32 pc)
 					_xor_r32_imm(REG_ECX, 0x18);									/* xor	ecx,0x18*/
 				_shr_r32_cl(REG_EAX);												/* shr	eax,cl*/
 				_mov_r32_m32abs(REG_EBX, LO(&mips3.r[RTREG]));						/* mov	ebx,[rtreg].lo*/
-				_and_r32_m32bd(REG_EBX, REG_ECX, ldr_mask);							/* and	ebx,[ldr_mask + ecx]*/
+				_and_r32_m32tbl(REG_EBX, REG_ECX, ldr_mask);						/* and	ebx,[ldr_mask + ecx]*/
 				_or_r32_r32(REG_EAX, REG_EBX);										/* or	eax,ebx*/
 				_cdq();																/* cdq*/
 				_mov_m64abs_r64(&mips3.r[RTREG], REG_EDX, REG_EAX);					/* mov	[rtreg],edx:eax*/
@@ -2212,7 +2309,7 @@ if ((nextop >> 26) == 0x2e &&
 			if (!mips3.bigendian)
 				_xor_r32_imm(REG_ECX, 0x18);										/* xor	ecx,0x18*/
 			
-			_and_r32_m32bd(REG_EAX, REG_ECX, sdl_mask);								/* and	eax,[sdl_mask + ecx]*/
+			_and_r32_m32tbl(REG_EAX, REG_ECX, sdl_mask);							/* and	eax,[sdl_mask + ecx]*/
 
 			if (RTREG != 0)
 			{
@@ -2315,8 +2412,8 @@ if ((nextop >> 26) == 0x2d &&
 			if (!mips3.bigendian)
 				_xor_r32_imm(REG_ECX, 0x38);										/* xor	ecx,0x38*/
 			
-			_and_r32_m32bd(REG_EAX, REG_ECX, sdl_mask + 1);							/* and	eax,[sdl_mask + ecx + 4]*/
-			_and_r32_m32bd(REG_EDX, REG_ECX, sdl_mask);								/* and	eax,[sdl_mask + ecx]*/
+			_and_r32_m32tbl(REG_EAX, REG_ECX, sdl_mask + 1);						/* and	eax,[sdl_mask + ecx + 4]*/
+			_and_r32_m32tbl(REG_EDX, REG_ECX, sdl_mask);							/* and	eax,[sdl_mask + ecx]*/
 
 			if (RTREG != 0)
 			{
@@ -2384,8 +2481,8 @@ if ((nextop >> 26) == 0x2c &&
 			if (mips3.bigendian)
 				_xor_r32_imm(REG_ECX, 0x38);										/* xor	ecx,0x38*/
 			
-			_and_r32_m32bd(REG_EAX, REG_ECX, sdr_mask + 1);							/* and	eax,[sdr_mask + ecx + 4]*/
-			_and_r32_m32bd(REG_EDX, REG_ECX, sdr_mask);								/* and	eax,[sdr_mask + ecx]*/
+			_and_r32_m32tbl(REG_EAX, REG_ECX, sdr_mask + 1);						/* and	eax,[sdr_mask + ecx + 4]*/
+			_and_r32_m32tbl(REG_EDX, REG_ECX, sdr_mask);							/* and	eax,[sdr_mask + ecx]*/
 
 			if (RTREG != 0)
 			{
@@ -2440,7 +2537,7 @@ if ((nextop >> 26) == 0x2a &&
 			if (mips3.bigendian)
 				_xor_r32_imm(REG_ECX, 0x18);										/* xor	ecx,0x18*/
 			
-			_and_r32_m32bd(REG_EAX, REG_ECX, sdr_mask + 1);							/* and	eax,[sdr_mask + ecx + 4]*/
+			_and_r32_m32tbl(REG_EAX, REG_ECX, sdr_mask + 1);						/* and	eax,[sdr_mask + ecx + 4]*/
 
 			if (RTREG != 0)
 			{
@@ -2460,6 +2557,14 @@ if ((nextop >> 26) == 0x2a &&
 			return RECOMPILE_SUCCESSFUL_CP(1,4);
 
 		case 0x2f:	/* CACHE */
+			if (RTREG == 0x10 || RTREG == 0x14)	/* Hit_Invalidate_I, Fill_I */
+			{
+				_mov_r32_m32abs(REG_EAX, &mips3.r[RSREG]);							/* mov	eax,[rsreg]*/
+				if (SIMMVAL != 0)
+					_add_r32_imm(REG_EAX, SIMMVAL);									/* add	eax,SIMMVAL*/
+				_push_r32(REG_EAX);													/* push	eax*/
+				drc_append_save_call_restore(drc, (void *)invalidate_icache_line, 4);	/* call	invalidate_icache_line*/
+			}
 			return RECOMPILE_SUCCESSFUL_CP(1,4);
 #if 0
 
@@ -3134,11 +3239,13 @@ static UINT32 recompile_special(struct drccore *drc, UINT32 pc, UINT32 op)
 			_add_r32_r32(REG_ECX, REG_EAX);											/* add	ecx,eax*/
 			_adc_r32_r32(REG_EBX, REG_EDX);											/* adc	ebx,edx*/
 			_mov_m32abs_r32(HI(&mips3.lo), REG_ECX);								/* mov	[lo].hi,ecx*/
+			_mov_r32_imm(REG_ECX, 0);												/* mov	ecx,0*/
+			_adc_r32_imm(REG_ECX, 0);												/* adc	ecx,0*/
 			
 			_mov_r32_m32abs(REG_EAX, HI(&dmult_temp1));								/* mov	eax,[dmult_temp1].hi*/
 			_mul_m32abs(HI(&dmult_temp2));											/* mul	[dmult_temp2].hi*/
 			_add_r32_r32(REG_EBX, REG_EAX);											/* add	ebx,eax*/
-			_adc_r32_imm(REG_EDX, 0);												/* adc	edx,0*/
+			_adc_r32_r32(REG_EDX, REG_ECX);											/* adc	edx,ecx*/
 			_mov_m32abs_r32(LO(&mips3.hi), REG_EBX);								/* mov	[hi].lo,ebx*/
 			_mov_m32abs_r32(HI(&mips3.hi), REG_EDX);								/* mov	[hi].hi,edx*/
 			
@@ -3175,25 +3282,27 @@ static UINT32 recompile_special(struct drccore *drc, UINT32 pc, UINT32 op)
 			_add_r32_r32(REG_ECX, REG_EAX);											/* add	ecx,eax*/
 			_adc_r32_r32(REG_EBX, REG_EDX);											/* adc	ebx,edx*/
 			_mov_m32abs_r32(HI(&mips3.lo), REG_ECX);								/* mov	[lo].hi,ecx*/
+			_mov_r32_imm(REG_ECX, 0);												/* mov	ecx,0*/
+			_adc_r32_imm(REG_ECX, 0);												/* adc	ecx,0*/
 			
 			_mov_r32_m32abs(REG_EAX, HI(&mips3.r[RSREG]));							/* mov	eax,[rsreg].hi*/
 			_mul_m32abs(HI(&mips3.r[RTREG]));										/* mul	[rtreg].hi*/
 			_add_r32_r32(REG_EBX, REG_EAX);											/* add	ebx,eax*/
-			_adc_r32_imm(REG_EDX, 0);												/* adc	edx,0*/
+			_adc_r32_r32(REG_EDX, REG_ECX);											/* adc	edx,ecx*/
 			_mov_m32abs_r32(LO(&mips3.hi), REG_EBX);								/* mov	[hi].lo,ebx*/
 			_mov_m32abs_r32(HI(&mips3.hi), REG_EDX);								/* mov	[hi].hi,edx*/
 			return RECOMPILE_SUCCESSFUL_CP(8,4);
 					
 		case 0x1e:	/* DDIV */
-			_push_imm(&mips3.r[RTREG]);												/* push	[rtreg]*/
-			_push_imm(&mips3.r[RSREG]);												/* push	[rsreg]*/
+			_push_ptr(&mips3.r[RTREG]);												/* push	[rtreg]*/
+			_push_ptr(&mips3.r[RSREG]);												/* push	[rsreg]*/
 			_call((void *)ddiv);													/* call ddiv*/
 			_add_r32_imm(REG_ESP, 8);												/* add	esp,8*/
 			return RECOMPILE_SUCCESSFUL_CP(68,4);
 
 		case 0x1f:	/* DDIVU */
-			_push_imm(&mips3.r[RTREG]);												/* push	[rtreg]*/
-			_push_imm(&mips3.r[RSREG]);												/* push	[rsreg]*/
+			_push_ptr(&mips3.r[RTREG]);												/* push	[rtreg]*/
+			_push_ptr(&mips3.r[RSREG]);												/* push	[rsreg]*/
 			_call((void *)ddivu);													/* call ddivu*/
 			_add_r32_imm(REG_ESP, 8);												/* add	esp,8*/
 			return RECOMPILE_SUCCESSFUL_CP(68,4);
@@ -5384,6 +5493,9 @@ static UINT32 recompile_cop1x(struct drccore *drc, UINT32 pc, UINT32 op)
 
 unsigned mips3_get_reg(int regnum)
 {
+	if (mips3.interpreted)
+		return mips3int_get_reg(regnum);
+
 	switch (regnum)
 	{
 		case REG_PC:
@@ -5521,6 +5633,12 @@ unsigned mips3_get_reg(int regnum)
 
 void mips3_set_reg(int regnum, unsigned val)
 {
+	if (mips3.interpreted)
+	{
+		mips3int_set_reg(regnum, val);
+		return;
+	}
+
 	switch (regnum)
 	{
 		case REG_PC:
@@ -5703,6 +5821,8 @@ const char *mips3_info(void *context, int regnum)
 
 	if (!context)
 		r = &mips3;
+	if (r->interpreted)
+		return mips3int_info(INTERP_CONTEXT(context), regnum);
 
     switch( regnum )
 	{
@@ -5772,6 +5892,8 @@ const char *r4600_info(void *context, int regnum)
 
 	if (!context)
 		r = &mips3;
+	if (r->interpreted)
+		return mips3int_r4600_info(INTERP_CONTEXT(context), regnum);
 
     switch( regnum )
 	{
@@ -5794,6 +5916,8 @@ const char *r5000_info(void *context, int regnum)
 
 	if (!context)
 		r = &mips3;
+	if (r->interpreted)
+		return mips3int_r5000_info(INTERP_CONTEXT(context), regnum);
 
     switch( regnum )
 	{
@@ -5815,6 +5939,8 @@ unsigned mips3_dasm(char *buffer, unsigned pc)
 #ifdef MAME_DEBUG
 	extern unsigned dasmmips3(char *, unsigned);
 	unsigned result;
+	if (mips3.interpreted)
+		return mips3int_dasm(buffer, pc);
 	if (mips3.bigendian)
 		change_pc32bedw(pc);
 	else
@@ -5826,6 +5952,8 @@ unsigned mips3_dasm(char *buffer, unsigned pc)
 		change_pc32ledw(mips3.pc);
     return result;
 #else
+	if (mips3.interpreted)
+		return mips3int_dasm(buffer, pc);
 	sprintf(buffer, "$%04X", cpu_readop32(pc));
 	return 4;
 #endif
@@ -0,0 +1,34 @@
+/*###################################################################################################
+**
+**
+**		mips3int.c
+**		The portable MIPS III/IV interpreter, built under its own names
+**		next to the x86 DRC. mips3drc.c hands a CPU over to it when the
+**		recompiler can't be started, e.g. when the host refuses to map
+**		executable memory.
+**
+**
+**#################################################################################################*/
+
+#define MIPS3_DRC_FALLBACK
+
+#define mips3_init				mips3int_init
+#define mips3_exit				mips3int_exit
+#define mips3_execute			mips3int_execute
+#define mips3_get_context		mips3int_get_context
+#define mips3_set_context		mips3int_set_context
+#define mips3_get_reg			mips3int_get_reg
+#define mips3_set_reg			mips3int_set_reg
+#define mips3_set_irq_line		mips3int_set_irq_line
+#define mips3_set_irq_callback	mips3int_set_irq_callback
+#define mips3_dasm				mips3int_dasm
+#define mips3_info				mips3int_info
+#define r4600_info				mips3int_r4600_info
+#define r4600be_reset			mips3int_r4600be_reset
+#define r4600le_reset			mips3int_r4600le_reset
+#define r5000_info				mips3int_r5000_info
+#define r5000be_reset			mips3int_r5000be_reset
+#define r5000le_reset			mips3int_r5000le_reset
+#define mips3drc_set_options	mips3int_set_options
+
+#include "mips3.c"
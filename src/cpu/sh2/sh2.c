@@ -205,6 +205,16 @@ static INLINE data16_t RW(offs_t A)
 	return cpu_readmem32bedw_word(A & AM);
 }
 
+/* opcode fetch; pc is already masked, so straight from the opcode base */
+/* when it is inside it, the same memory cpu_readmem32bedw_word would read */
+static INLINE data16_t ROP(offs_t A)
+{
+	if (A - OP_MEM_MIN < OP_MEM_MAX - OP_MEM_MIN)
+		return *(data16_t *)&OP_RAM[WORD_XOR_BE(A)];
+
+	return cpu_readmem32bedw_word(A);
+}
+
 static INLINE data32_t RL(offs_t A)
 {
 	if (A >= 0xe0000000)
@@ -1972,316 +1982,303 @@ static INLINE void XTRCT(UINT32 m, UINT32 n)
 }
 
 /*****************************************************************************
- *	OPCODE DISPATCHERS
+ *	OPCODE HANDLERS
+ *
+ *	One small handler per instruction form, taking the raw opcode. The
+ *	decoders below map every opcode to its handler once, into sh2_optable,
+ *	so executing an instruction is a single indirect call instead of two
+ *	levels of switch. The table is keyed on the opcode itself, not on the
+ *	address it was fetched from, so nothing has to be invalidated when code
+ *	is rewritten, whichever CPU or DMA does the writing.
+ *****************************************************************************/
+
+typedef void (*sh2_ophandler)(UINT16 opcode);
+
+static sh2_ophandler sh2_optable[0x10000];
+
+#define OP(name)		static void op_##name(UINT16 opcode) { name(); }
+#define OP_N(name)		static void op_##name(UINT16 opcode) { name(Rn); }
+#define OP_MN(name)		static void op_##name(UINT16 opcode) { name(Rm, Rn); }
+#define OP_I(name)		static void op_##name(UINT16 opcode) { name(opcode & 0xff); }
+#define OP_IN(name)		static void op_##name(UINT16 opcode) { name(opcode & 0xff, Rn); }
+
+OP(NOP)			OP(CLRT)		OP(SETT)		OP(CLRMAC)		OP(DIV0U)
+OP(RTS)			OP(RTE)			OP(SLEEP)
+
+OP_N(STCSR)		OP_N(STCGBR)	OP_N(STCVBR)	OP_N(STSMACH)	OP_N(STSMACL)
+OP_N(STSPR)		OP_N(BSRF)		OP_N(BRAF)		OP_N(MOVT)		OP_N(JSR)
+OP_N(JMP)		OP_N(SHLL)		OP_N(SHLR)		OP_N(SHAL)		OP_N(SHAR)
+OP_N(SHLL2)		OP_N(SHLR2)		OP_N(SHLL8)		OP_N(SHLR8)		OP_N(SHLL16)
+OP_N(SHLR16)	OP_N(ROTL)		OP_N(ROTR)		OP_N(ROTCL)		OP_N(ROTCR)
+OP_N(DT)		OP_N(CMPPZ)		OP_N(CMPPL)		OP_N(TAS)		OP_N(STSMMACH)
+OP_N(STSMMACL)	OP_N(STSMPR)	OP_N(STCMSR)	OP_N(STCMGBR)	OP_N(STCMVBR)
+OP_N(LDSMMACH)	OP_N(LDSMMACL)	OP_N(LDSMPR)	OP_N(LDCMSR)	OP_N(LDCMGBR)
+OP_N(LDCMVBR)	OP_N(LDSMACH)	OP_N(LDSMACL)	OP_N(LDSPR)		OP_N(LDCSR)
+OP_N(LDCGBR)	OP_N(LDCVBR)
+
+OP_MN(MOVBS0)	OP_MN(MOVWS0)	OP_MN(MOVLS0)	OP_MN(MOVBL0)	OP_MN(MOVWL0)
+OP_MN(MOVLL0)	OP_MN(MOVBS)	OP_MN(MOVWS)	OP_MN(MOVLS)	OP_MN(MOVBL)
+OP_MN(MOVWL)	OP_MN(MOVLL)	OP_MN(MOVBM)	OP_MN(MOVWM)	OP_MN(MOVLM)
+OP_MN(MOVBP)	OP_MN(MOVWP)	OP_MN(MOVLP)	OP_MN(MOV)		OP_MN(MULL)
+OP_MN(MULU)		OP_MN(MULS)		OP_MN(DMULU)	OP_MN(DMULS)	OP_MN(MAC_L)
+OP_MN(MAC_W)	OP_MN(DIV0S)	OP_MN(DIV1)		OP_MN(TST)		OP_MN(AND)
+OP_MN(XOR)		OP_MN(OR)		OP_MN(NOT)		OP_MN(CMPSTR)	OP_MN(XTRCT)
+OP_MN(CMPEQ)	OP_MN(CMPHS)	OP_MN(CMPGE)	OP_MN(CMPHI)	OP_MN(CMPGT)
+OP_MN(SUB)		OP_MN(SUBC)		OP_MN(SUBV)		OP_MN(ADD)		OP_MN(ADDC)
+OP_MN(ADDV)		OP_MN(NEG)		OP_MN(NEGC)		OP_MN(SWAPB)	OP_MN(SWAPW)
+OP_MN(EXTUB)	OP_MN(EXTUW)	OP_MN(EXTSB)	OP_MN(EXTSW)
+
+OP_I(CMPIM)		OP_I(BT)		OP_I(BF)		OP_I(BTS)		OP_I(BFS)
+OP_I(MOVBSG)	OP_I(MOVWSG)	OP_I(MOVLSG)	OP_I(MOVBLG)	OP_I(MOVWLG)
+OP_I(MOVLLG)	OP_I(TRAPA)		OP_I(MOVA)		OP_I(TSTI)		OP_I(ANDI)
+OP_I(XORI)		OP_I(ORI)		OP_I(TSTM)		OP_I(ANDM)		OP_I(XORM)
+OP_I(ORM)
+
+OP_IN(ADDI)		OP_IN(MOVWI)	OP_IN(MOVLI)	OP_IN(MOVI)
+
+static void op_MOVLS4(UINT16 opcode)	{ MOVLS4(Rm, opcode & 0x0f, Rn); }
+static void op_MOVLL4(UINT16 opcode)	{ MOVLL4(Rm, opcode & 0x0f, Rn); }
+static void op_MOVBS4(UINT16 opcode)	{ MOVBS4(opcode & 0x0f, Rm); }
+static void op_MOVWS4(UINT16 opcode)	{ MOVWS4(opcode & 0x0f, Rm); }
+static void op_MOVBL4(UINT16 opcode)	{ MOVBL4(Rm, opcode & 0x0f); }
+static void op_MOVWL4(UINT16 opcode)	{ MOVWL4(Rm, opcode & 0x0f); }
+static void op_BRA(UINT16 opcode)		{ BRA(opcode & 0xfff); }
+static void op_BSR(UINT16 opcode)		{ BSR(opcode & 0xfff); }
+
+#undef OP
+#undef OP_N
+#undef OP_MN
+#undef OP_I
+#undef OP_IN
+
+/*****************************************************************************
+ *	OPCODE DECODERS
  *****************************************************************************/
 
-static INLINE void op0000(UINT16 opcode)
+static sh2_ophandler op0000(UINT16 opcode)
 {
 	switch (opcode & 0x3F)
 	{
-	case 0x00: NOP();						break;
-	case 0x01: NOP();						break;
-	case 0x02: STCSR(Rn);					break;
-	case 0x03: BSRF(Rn);					break;
-	case 0x04: MOVBS0(Rm, Rn);				break;
-	case 0x05: MOVWS0(Rm, Rn);				break;
-	case 0x06: MOVLS0(Rm, Rn);				break;
-	case 0x07: MULL(Rm, Rn);				break;
-	case 0x08: CLRT();						break;
-	case 0x09: NOP();						break;
-	case 0x0a: STSMACH(Rn); 				break;
-	case 0x0b: RTS();						break;
-	case 0x0c: MOVBL0(Rm, Rn);				break;
-	case 0x0d: MOVWL0(Rm, Rn);				break;
-	case 0x0e: MOVLL0(Rm, Rn);				break;
-	case 0x0f: MAC_L(Rm, Rn);				break;
-
-	case 0x10: NOP();						break;
-	case 0x11: NOP();						break;
-	case 0x12: STCGBR(Rn);					break;
-	case 0x13: NOP();						break;
-	case 0x14: MOVBS0(Rm, Rn);				break;
-	case 0x15: MOVWS0(Rm, Rn);				break;
-	case 0x16: MOVLS0(Rm, Rn);				break;
-	case 0x17: MULL(Rm, Rn);				break;
-	case 0x18: SETT();						break;
-	case 0x19: DIV0U(); 					break;
-	case 0x1a: STSMACL(Rn); 				break;
-	case 0x1b: SLEEP(); 					break;
-	case 0x1c: MOVBL0(Rm, Rn);				break;
-	case 0x1d: MOVWL0(Rm, Rn);				break;
-	case 0x1e: MOVLL0(Rm, Rn);				break;
-	case 0x1f: MAC_L(Rm, Rn);				break;
-
-	case 0x20: NOP();						break;
-	case 0x21: NOP();						break;
-	case 0x22: STCVBR(Rn);					break;
-	case 0x23: BRAF(Rn);					break;
-	case 0x24: MOVBS0(Rm, Rn);				break;
-	case 0x25: MOVWS0(Rm, Rn);				break;
-	case 0x26: MOVLS0(Rm, Rn);				break;
-	case 0x27: MULL(Rm, Rn);				break;
-	case 0x28: CLRMAC();					break;
-	case 0x29: MOVT(Rn);					break;
-	case 0x2a: STSPR(Rn);					break;
-	case 0x2b: RTE();						break;
-	case 0x2c: MOVBL0(Rm, Rn);				break;
-	case 0x2d: MOVWL0(Rm, Rn);				break;
-	case 0x2e: MOVLL0(Rm, Rn);				break;
-	case 0x2f: MAC_L(Rm, Rn);				break;
-
-	case 0x30: NOP();						break;
-	case 0x31: NOP();						break;
-	case 0x32: NOP();						break;
-	case 0x33: NOP();						break;
-	case 0x34: MOVBS0(Rm, Rn);				break;
-	case 0x35: MOVWS0(Rm, Rn);				break;
-	case 0x36: MOVLS0(Rm, Rn);				break;
-	case 0x37: MULL(Rm, Rn);				break;
-	case 0x38: NOP();						break;
-	case 0x39: NOP();						break;
-	case 0x3c: MOVBL0(Rm, Rn);				break;
-	case 0x3d: MOVWL0(Rm, Rn);				break;
-	case 0x3e: MOVLL0(Rm, Rn);				break;
-	case 0x3f: MAC_L(Rm, Rn);				break;
-	case 0x3a: NOP();						break;
-	case 0x3b: NOP();						break;
+	case 0x02: return op_STCSR;
+	case 0x03: return op_BSRF;
+	case 0x04: case 0x14: case 0x24: case 0x34: return op_MOVBS0;
+	case 0x05: case 0x15: case 0x25: case 0x35: return op_MOVWS0;
+	case 0x06: case 0x16: case 0x26: case 0x36: return op_MOVLS0;
+	case 0x07: case 0x17: case 0x27: case 0x37: return op_MULL;
+	case 0x08: return op_CLRT;
+	case 0x0a: return op_STSMACH;
+	case 0x0b: return op_RTS;
+	case 0x0c: case 0x1c: case 0x2c: case 0x3c: return op_MOVBL0;
+	case 0x0d: case 0x1d: case 0x2d: case 0x3d: return op_MOVWL0;
+	case 0x0e: case 0x1e: case 0x2e: case 0x3e: return op_MOVLL0;
+	case 0x0f: case 0x1f: case 0x2f: case 0x3f: return op_MAC_L;
+
+	case 0x12: return op_STCGBR;
+	case 0x18: return op_SETT;
+	case 0x19: return op_DIV0U;
+	case 0x1a: return op_STSMACL;
+	case 0x1b: return op_SLEEP;
+
+	case 0x22: return op_STCVBR;
+	case 0x23: return op_BRAF;
+	case 0x28: return op_CLRMAC;
+	case 0x29: return op_MOVT;
+	case 0x2a: return op_STSPR;
+	case 0x2b: return op_RTE;
 	}
+	return op_NOP;
 }
 
-static INLINE void op0001(UINT16 opcode)
-{
-	MOVLS4(Rm, opcode & 0x0f, Rn);
-}
-
-static INLINE void op0010(UINT16 opcode)
+static sh2_ophandler op0010(UINT16 opcode)
 {
 	switch (opcode & 15)
 	{
-	case  0: MOVBS(Rm, Rn); 				break;
-	case  1: MOVWS(Rm, Rn); 				break;
-	case  2: MOVLS(Rm, Rn); 				break;
-	case  3: NOP(); 						break;
-	case  4: MOVBM(Rm, Rn); 				break;
-	case  5: MOVWM(Rm, Rn); 				break;
-	case  6: MOVLM(Rm, Rn); 				break;
-	case  7: DIV0S(Rm, Rn); 				break;
-	case  8: TST(Rm, Rn);					break;
-	case  9: AND(Rm, Rn);					break;
-	case 10: XOR(Rm, Rn);					break;
-	case 11: OR(Rm, Rn);					break;
-	case 12: CMPSTR(Rm, Rn);				break;
-	case 13: XTRCT(Rm, Rn); 				break;
-	case 14: MULU(Rm, Rn);					break;
-	case 15: MULS(Rm, Rn);					break;
+	case  0: return op_MOVBS;
+	case  1: return op_MOVWS;
+	case  2: return op_MOVLS;
+	case  3: return op_NOP;
+	case  4: return op_MOVBM;
+	case  5: return op_MOVWM;
+	case  6: return op_MOVLM;
+	case  7: return op_DIV0S;
+	case  8: return op_TST;
+	case  9: return op_AND;
+	case 10: return op_XOR;
+	case 11: return op_OR;
+	case 12: return op_CMPSTR;
+	case 13: return op_XTRCT;
+	case 14: return op_MULU;
+	default: return op_MULS;
 	}
 }
 
-static INLINE void op0011(UINT16 opcode)
+static sh2_ophandler op0011(UINT16 opcode)
 {
 	switch (opcode & 15)
 	{
-	case  0: CMPEQ(Rm, Rn); 				break;
-	case  1: NOP(); 						break;
-	case  2: CMPHS(Rm, Rn); 				break;
-	case  3: CMPGE(Rm, Rn); 				break;
-	case  4: DIV1(Rm, Rn);					break;
-	case  5: DMULU(Rm, Rn); 				break;
-	case  6: CMPHI(Rm, Rn); 				break;
-	case  7: CMPGT(Rm, Rn); 				break;
-	case  8: SUB(Rm, Rn);					break;
-	case  9: NOP(); 						break;
-	case 10: SUBC(Rm, Rn);					break;
-	case 11: SUBV(Rm, Rn);					break;
-	case 12: ADD(Rm, Rn);					break;
-	case 13: DMULS(Rm, Rn); 				break;
-	case 14: ADDC(Rm, Rn);					break;
-	case 15: ADDV(Rm, Rn);					break;
+	case  0: return op_CMPEQ;
+	case  1: return op_NOP;
+	case  2: return op_CMPHS;
+	case  3: return op_CMPGE;
+	case  4: return op_DIV1;
+	case  5: return op_DMULU;
+	case  6: return op_CMPHI;
+	case  7: return op_CMPGT;
+	case  8: return op_SUB;
+	case  9: return op_NOP;
+	case 10: return op_SUBC;
+	case 11: return op_SUBV;
+	case 12: return op_ADD;
+	case 13: return op_DMULS;
+	case 14: return op_ADDC;
+	default: return op_ADDV;
 	}
 }
 
-static INLINE void op0100(UINT16 opcode)
+static sh2_ophandler op0100(UINT16 opcode)
 {
 	switch (opcode & 0x3F)
 	{
-	case 0x00: SHLL(Rn);					break;
-	case 0x01: SHLR(Rn);					break;
-	case 0x02: STSMMACH(Rn);				break;
-	case 0x03: STCMSR(Rn);					break;
-	case 0x04: ROTL(Rn);					break;
-	case 0x05: ROTR(Rn);					break;
-	case 0x06: LDSMMACH(Rn);				break;
-	case 0x07: LDCMSR(Rn);					break;
-	case 0x08: SHLL2(Rn);					break;
-	case 0x09: SHLR2(Rn);					break;
-	case 0x0a: LDSMACH(Rn); 				break;
-	case 0x0b: JSR(Rn); 					break;
-	case 0x0c: NOP();						break;
-	case 0x0d: NOP();						break;
-	case 0x0e: LDCSR(Rn);					break;
-	case 0x0f: MAC_W(Rm, Rn);				break;
-
-	case 0x10: DT(Rn);						break;
-	case 0x11: CMPPZ(Rn);					break;
-	case 0x12: STSMMACL(Rn);				break;
-	case 0x13: STCMGBR(Rn); 				break;
-	case 0x14: NOP();						break;
-	case 0x15: CMPPL(Rn);					break;
-	case 0x16: LDSMMACL(Rn);				break;
-	case 0x17: LDCMGBR(Rn); 				break;
-	case 0x18: SHLL8(Rn);					break;
-	case 0x19: SHLR8(Rn);					break;
-	case 0x1a: LDSMACL(Rn); 				break;
-	case 0x1b: TAS(Rn); 					break;
-	case 0x1c: NOP();						break;
-	case 0x1d: NOP();						break;
-	case 0x1e: LDCGBR(Rn);					break;
-	case 0x1f: MAC_W(Rm, Rn);				break;
-
-	case 0x20: SHAL(Rn);					break;
-	case 0x21: SHAR(Rn);					break;
-	case 0x22: STSMPR(Rn);					break;
-	case 0x23: STCMVBR(Rn); 				break;
-	case 0x24: ROTCL(Rn);					break;
-	case 0x25: ROTCR(Rn);					break;
-	case 0x26: LDSMPR(Rn);					break;
-	case 0x27: LDCMVBR(Rn); 				break;
-	case 0x28: SHLL16(Rn);					break;
-	case 0x29: SHLR16(Rn);					break;
-	case 0x2a: LDSPR(Rn);					break;
-	case 0x2b: JMP(Rn); 					break;
-	case 0x2c: NOP();						break;
-	case 0x2d: NOP();						break;
-	case 0x2e: LDCVBR(Rn);					break;
-	case 0x2f: MAC_W(Rm, Rn);				break;
-
-	case 0x30: NOP();						break;
-	case 0x31: NOP();						break;
-	case 0x32: NOP();						break;
-	case 0x33: NOP();						break;
-	case 0x34: NOP();						break;
-	case 0x35: NOP();						break;
-	case 0x36: NOP();						break;
-	case 0x37: NOP();						break;
-	case 0x38: NOP();						break;
-	case 0x39: NOP();						break;
-	case 0x3a: NOP();						break;
-	case 0x3b: NOP();						break;
-	case 0x3c: NOP();						break;
-	case 0x3d: NOP();						break;
-	case 0x3e: NOP();						break;
-	case 0x3f: MAC_W(Rm, Rn);				break;
+	case 0x00: return op_SHLL;
+	case 0x01: return op_SHLR;
+	case 0x02: return op_STSMMACH;
+	case 0x03: return op_STCMSR;
+	case 0x04: return op_ROTL;
+	case 0x05: return op_ROTR;
+	case 0x06: return op_LDSMMACH;
+	case 0x07: return op_LDCMSR;
+	case 0x08: return op_SHLL2;
+	case 0x09: return op_SHLR2;
+	case 0x0a: return op_LDSMACH;
+	case 0x0b: return op_JSR;
+	case 0x0e: return op_LDCSR;
+	case 0x0f: case 0x1f: case 0x2f: case 0x3f: return op_MAC_W;
+
+	case 0x10: return op_DT;
+	case 0x11: return op_CMPPZ;
+	case 0x12: return op_STSMMACL;
+	case 0x13: return op_STCMGBR;
+	case 0x15: return op_CMPPL;
+	case 0x16: return op_LDSMMACL;
+	case 0x17: return op_LDCMGBR;
+	case 0x18: return op_SHLL8;
+	case 0x19: return op_SHLR8;
+	case 0x1a: return op_LDSMACL;
+	case 0x1b: return op_TAS;
+	case 0x1e: return op_LDCGBR;
+
+	case 0x20: return op_SHAL;
+	case 0x21: return op_SHAR;
+	case 0x22: return op_STSMPR;
+	case 0x23: return op_STCMVBR;
+	case 0x24: return op_ROTCL;
+	case 0x25: return op_ROTCR;
+	case 0x26: return op_LDSMPR;
+	case 0x27: return op_LDCMVBR;
+	case 0x28: return op_SHLL16;
+	case 0x29: return op_SHLR16;
+	case 0x2a: return op_LDSPR;
+	case 0x2b: return op_JMP;
+	case 0x2e: return op_LDCVBR;
 	}
+	return op_NOP;
 }
 
-static INLINE void op0101(UINT16 opcode)
-{
-	MOVLL4(Rm, opcode & 0x0f, Rn);
-}
-
-static INLINE void op0110(UINT16 opcode)
+static sh2_ophandler op0110(UINT16 opcode)
 {
 	switch (opcode & 15)
 	{
-	case  0: MOVBL(Rm, Rn); 				break;
-	case  1: MOVWL(Rm, Rn); 				break;
-	case  2: MOVLL(Rm, Rn); 				break;
-	case  3: MOV(Rm, Rn);					break;
-	case  4: MOVBP(Rm, Rn); 				break;
-	case  5: MOVWP(Rm, Rn); 				break;
-	case  6: MOVLP(Rm, Rn); 				break;
-	case  7: NOT(Rm, Rn);					break;
-	case  8: SWAPB(Rm, Rn); 				break;
-	case  9: SWAPW(Rm, Rn); 				break;
-	case 10: NEGC(Rm, Rn);					break;
-	case 11: NEG(Rm, Rn);					break;
-	case 12: EXTUB(Rm, Rn); 				break;
-	case 13: EXTUW(Rm, Rn); 				break;
-	case 14: EXTSB(Rm, Rn); 				break;
-	case 15: EXTSW(Rm, Rn); 				break;
+	case  0: return op_MOVBL;
+	case  1: return op_MOVWL;
+	case  2: return op_MOVLL;
+	case  3: return op_MOV;
+	case  4: return op_MOVBP;
+	case  5: return op_MOVWP;
+	case  6: return op_MOVLP;
+	case  7: return op_NOT;
+	case  8: return op_SWAPB;
+	case  9: return op_SWAPW;
+	case 10: return op_NEGC;
+	case 11: return op_NEG;
+	case 12: return op_EXTUB;
+	case 13: return op_EXTUW;
+	case 14: return op_EXTSB;
+	default: return op_EXTSW;
 	}
 }
 
-static INLINE void op0111(UINT16 opcode)
-{
-	ADDI(opcode & 0xff, Rn);
-}
-
-static INLINE void op1000(UINT16 opcode)
+static sh2_ophandler op1000(UINT16 opcode)
 {
 	switch ((opcode >> 8) & 15)
 	{
-	case  0: MOVBS4(opcode & 0x0f, Rm); 	break;
-	case  1: MOVWS4(opcode & 0x0f, Rm); 	break;
-	case  2: NOP(); 						break;
-	case  3: NOP(); 						break;
-	case  4: MOVBL4(Rm, opcode & 0x0f); 	break;
-	case  5: MOVWL4(Rm, opcode & 0x0f); 	break;
-	case  6: NOP(); 						break;
-	case  7: NOP(); 						break;
-	case  8: CMPIM(opcode & 0xff);			break;
-	case  9: BT(opcode & 0xff); 			break;
-	case 10: NOP(); 						break;
-	case 11: BF(opcode & 0xff); 			break;
-	case 12: NOP(); 						break;
-	case 13: BTS(opcode & 0xff);			break;
-	case 14: NOP(); 						break;
-	case 15: BFS(opcode & 0xff);			break;
+	case  0: return op_MOVBS4;
+	case  1: return op_MOVWS4;
+	case  4: return op_MOVBL4;
+	case  5: return op_MOVWL4;
+	case  8: return op_CMPIM;
+	case  9: return op_BT;
+	case 11: return op_BF;
+	case 13: return op_BTS;
+	case 15: return op_BFS;
 	}
+	return op_NOP;
 }
 
-
-static INLINE void op1001(UINT16 opcode)
-{
-	MOVWI(opcode & 0xff, Rn);
-}
-
-static INLINE void op1010(UINT16 opcode)
-{
-	BRA(opcode & 0xfff);
-}
-
-static INLINE void op1011(UINT16 opcode)
-{
-	BSR(opcode & 0xfff);
-}
-
-static INLINE void op1100(UINT16 opcode)
+static sh2_ophandler op1100(UINT16 opcode)
 {
 	switch ((opcode >> 8) & 15)
 	{
-	case  0: MOVBSG(opcode & 0xff); 		break;
-	case  1: MOVWSG(opcode & 0xff); 		break;
-	case  2: MOVLSG(opcode & 0xff); 		break;
-	case  3: TRAPA(opcode & 0xff);			break;
-	case  4: MOVBLG(opcode & 0xff); 		break;
-	case  5: MOVWLG(opcode & 0xff); 		break;
-	case  6: MOVLLG(opcode & 0xff); 		break;
-	case  7: MOVA(opcode & 0xff);			break;
-	case  8: TSTI(opcode & 0xff);			break;
-	case  9: ANDI(opcode & 0xff);			break;
-	case 10: XORI(opcode & 0xff);			break;
-	case 11: ORI(opcode & 0xff);			break;
-	case 12: TSTM(opcode & 0xff);			break;
-	case 13: ANDM(opcode & 0xff);			break;
-	case 14: XORM(opcode & 0xff);			break;
-	case 15: ORM(opcode & 0xff);			break;
+	case  0: return op_MOVBSG;
+	case  1: return op_MOVWSG;
+	case  2: return op_MOVLSG;
+	case  3: return op_TRAPA;
+	case  4: return op_MOVBLG;
+	case  5: return op_MOVWLG;
+	case  6: return op_MOVLLG;
+	case  7: return op_MOVA;
+	case  8: return op_TSTI;
+	case  9: return op_ANDI;
+	case 10: return op_XORI;
+	case 11: return op_ORI;
+	case 12: return op_TSTM;
+	case 13: return op_ANDM;
+	case 14: return op_XORM;
+	default: return op_ORM;
 	}
 }
 
-static INLINE void op1101(UINT16 opcode)
+static sh2_ophandler sh2_decode(UINT16 opcode)
 {
-	MOVLI(opcode & 0xff, Rn);
+	switch ((opcode >> 12) & 15)
+	{
+	case  0: return op0000(opcode);
+	case  1: return op_MOVLS4;
+	case  2: return op0010(opcode);
+	case  3: return op0011(opcode);
+	case  4: return op0100(opcode);
+	case  5: return op_MOVLL4;
+	case  6: return op0110(opcode);
+	case  7: return op_ADDI;
+	case  8: return op1000(opcode);
+	case  9: return op_MOVWI;
+	case 10: return op_BRA;
+	case 11: return op_BSR;
+	case 12: return op1100(opcode);
+	case 13: return op_MOVLI;
+	case 14: return op_MOVI;
+	default: return op_NOP;
+	}
 }
 
-static INLINE void op1110(UINT16 opcode)
+/* fill the opcode table; it is shared by all the SH-2s and built once */
+static void sh2_build_optable(void)
 {
-	MOVI(opcode & 0xff, Rn);
-}
+	int opcode;
 
-static INLINE void op1111(UINT16 opcode)
-{
-	NOP();
+	if (sh2_optable[0])
+		return;
+	for (opcode = 0; opcode < 0x10000; opcode++)
+		sh2_optable[opcode] = sh2_decode(opcode);
 }
 
 /*****************************************************************************
@@ -2348,7 +2345,7 @@ int sh2_execute(int cycles)
 			sh2.pc -= 2;
 		}
 		else
-			opcode = RW(sh2.pc & AM);
+			opcode = ROP(sh2.pc & AM);
 
 		CALL_MAME_DEBUG;
 
@@ -2356,25 +2353,7 @@ int sh2_execute(int cycles)
 		sh2.pc += 2;
 		sh2.ppc = sh2.pc;
 
-		switch ((opcode >> 12) & 15)
-		{
-		case  0: op0000(opcode); break;
-		case  1: op0001(opcode); break;
-		case  2: op0010(opcode); break;
-		case  3: op0011(opcode); break;
-		case  4: op0100(opcode); break;
-		case  5: op0101(opcode); break;
-		case  6: op0110(opcode); break;
-		case  7: op0111(opcode); break;
-		case  8: op1000(opcode); break;
-		case  9: op1001(opcode); break;
-		case 10: op1010(opcode); break;
-		case 11: op1011(opcode); break;
-		case 12: op1100(opcode); break;
-		case 13: op1101(opcode); break;
-		case 14: op1110(opcode); break;
-		default: op1111(opcode); break;
-		}
+		(*sh2_optable[opcode])(opcode);
 
 		if(sh2.test_irq && !sh2.delay)
 		{
@@ -3075,6 +3054,8 @@ void sh2_init(void)
 {
 	int cpu = cpu_getactivecpu();
 
+	sh2_build_optable();
+
 	sh2.timer = timer_alloc(sh2_timer_callback);
 	timer_adjust(sh2.timer, TIME_NEVER, 0, 0);
 
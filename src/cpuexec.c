@@ -13,6 +13,7 @@
 #include "mamedbg.h"
 #include "cpuexec.h"
 #include "log.h"
+#include "libretro_perf.h"
 
 
 #if (HAS_M68000 || HAS_M68010 || HAS_M68020 || HAS_M68EC020)
@@ -125,7 +126,7 @@ struct cpuinfo
 	int 	iloops; 				/* number of interrupts remaining this frame */
 
 	UINT64 	totalcycles;			/* total CPU cycles executed */
-	double	localtime;				/* local time, relative to the timer system's global time */
+	mame_time localtime;			/* local time, in the timer system's absolute time base */
 	double	clockscale;				/* current active clock scale factor */
 	
 	int 	vblankint_countdown;	/* number of vblank callbacks left until we interrupt */
@@ -239,8 +240,7 @@ int cpu_init(void)
 		cpu[cpunum].clockscale = cputype_get_interface(cputype)->overclock;
 
 		/* compute the cycle times */
-		sec_to_cycles[cpunum] = cpu[cpunum].clockscale * Machine->drv->cpu[cpunum].cpu_clock;
-		cycles_to_sec[cpunum] = 1.0 / sec_to_cycles[cpunum];
+		timer_set_cpu_clock(cpunum, cpu[cpunum].clockscale * Machine->drv->cpu[cpunum].cpu_clock);
 
 		/* initialize this CPU */
 		if (cpuintrf_init_cpu(cpunum, cputype))
@@ -302,7 +302,7 @@ static void cpu_pre_run(void)
 
 		/* reset the total number of cycles */
 		cpu[cpunum].totalcycles = 0;
-		cpu[cpunum].localtime = 0;
+		mame_timer_get_time(&cpu[cpunum].localtime);
 	}
 
 	vblank = 0;
@@ -358,10 +358,12 @@ void mame_frame(void)
     {    
         extern int gotFrame;
         
+        profiler_frame_begin();
         while(!gotFrame)
         {
             cpu_timeslice();
         }
+        profiler_frame_end();
         
         gotFrame = 0;
         
@@ -380,6 +382,7 @@ void mame_frame(void)
 
 void cpu_run_done(void)
 {
+	profiler_stop();
 	cpu_post_run();
 }
 
@@ -576,17 +579,22 @@ void cpunum_set_halt_line(int cpunum, int state)
 
 static void cpu_timeslice(void)
 {
-	double target = timer_time_until_next_timer();
+	mame_time base, target;
 	int cpunum, ran;
+
+	mame_timer_get_time(&base);
+	mame_timer_next_fire_time(&target);
 	
-	log_cb(RETRO_LOG_DEBUG, LOGPRE "------------------\n");
-	log_cb(RETRO_LOG_DEBUG, LOGPRE "cpu_timeslice: target = %.9f\n", target);
+	RETRO_PERFORMANCE_INIT(perf_cb, emulate_cpus);
+
+	log_trace(CPUEXEC, (RETRO_LOG_DEBUG, LOGPRE "------------------\n"));
+	log_trace(CPUEXEC, (RETRO_LOG_DEBUG, LOGPRE "cpu_timeslice: target = %.9f\n", mame_time_to_double(sub_mame_times(target, base))));
 	
 	/* process any pending suspends */
 	for (cpunum = 0; Machine->drv->cpu[cpunum].cpu_type != CPU_DUMMY; cpunum++)
 	{
 		if (cpu[cpunum].suspend != cpu[cpunum].nextsuspend)
-			log_cb(RETRO_LOG_DEBUG, LOGPRE "--> updated CPU%d suspend from %X to %X\n", cpunum, cpu[cpunum].suspend, cpu[cpunum].nextsuspend);
+			log_trace(CPUEXEC, (RETRO_LOG_DEBUG, LOGPRE "--> updated CPU%d suspend from %X to %X\n", cpunum, cpu[cpunum].suspend, cpu[cpunum].nextsuspend));
 		cpu[cpunum].suspend = cpu[cpunum].nextsuspend;
 		cpu[cpunum].eatcycles = cpu[cpunum].nexteatcycles;
 	}
@@ -598,28 +606,30 @@ static void cpu_timeslice(void)
 		if (!cpu[cpunum].suspend)
 		{
 			/* compute how long to run */
-			cycles_running = TIME_TO_CYCLES(cpunum, target - cpu[cpunum].localtime);
-			log_cb(RETRO_LOG_DEBUG, LOGPRE "  cpu %d: %d cycles\n", cpunum, cycles_running);
+			cycles_running = mame_time_to_cycles(cpunum, sub_mame_times(target, cpu[cpunum].localtime));
+			log_trace(CPUEXEC, (RETRO_LOG_DEBUG, LOGPRE "  cpu %d: %d cycles\n", cpunum, cycles_running));
 		
 			/* run for the requested number of cycles */
 			if (cycles_running > 0)
 			{
 				profiler_mark(PROFILER_CPU1 + cpunum);
 				cycles_stolen = 0;
+				RETRO_PERFORMANCE_START(perf_cb, emulate_cpus);
 				ran = cpunum_execute(cpunum, cycles_running);
+				RETRO_PERFORMANCE_STOP(perf_cb, emulate_cpus);
 				ran -= cycles_stolen;
 				profiler_mark(PROFILER_END);
 				
 				/* account for these cycles */
 				cpu[cpunum].totalcycles += ran;
-				cpu[cpunum].localtime += TIME_IN_CYCLES(ran, cpunum);
-				log_cb(RETRO_LOG_DEBUG, LOGPRE "         %d ran, %d total, time = %.9f\n", ran, (INT32)cpu[cpunum].totalcycles, cpu[cpunum].localtime);
+				cpu[cpunum].localtime = add_mame_times(cpu[cpunum].localtime, cycles_to_mame_time(cpunum, ran));
+				log_trace(CPUEXEC, (RETRO_LOG_DEBUG, LOGPRE "         %d ran, %d total, time = %.9f\n", ran, (INT32)cpu[cpunum].totalcycles, mame_time_to_double(sub_mame_times(cpu[cpunum].localtime, base))));
 				
 				/* if the new local CPU time is less than our target, move the target up */
-				if (cpu[cpunum].localtime < target && cpu[cpunum].localtime > 0)
+				if (compare_mame_times(cpu[cpunum].localtime, target) < 0 && compare_mame_times(cpu[cpunum].localtime, base) > 0)
 				{
 					target = cpu[cpunum].localtime;
-					log_cb(RETRO_LOG_DEBUG, LOGPRE "         (new target)\n");
+					log_trace(CPUEXEC, (RETRO_LOG_DEBUG, LOGPRE "         (new target)\n"));
 				}
 			}
 		}
@@ -629,29 +639,26 @@ static void cpu_timeslice(void)
 	for (cpunum = 0; Machine->drv->cpu[cpunum].cpu_type != CPU_DUMMY; cpunum++)
 	{
 		/* if we're suspended and counting, process */
-		if (cpu[cpunum].suspend && cpu[cpunum].eatcycles && cpu[cpunum].localtime < target)
+		if (cpu[cpunum].suspend && cpu[cpunum].eatcycles && compare_mame_times(cpu[cpunum].localtime, target) < 0)
 		{
 			/* compute how long to run */
-			cycles_running = TIME_TO_CYCLES(cpunum, target - cpu[cpunum].localtime);
-			log_cb(RETRO_LOG_DEBUG, LOGPRE "  cpu %d: %d cycles (suspended)\n", cpunum, cycles_running);
+			cycles_running = mame_time_to_cycles(cpunum, sub_mame_times(target, cpu[cpunum].localtime));
+			log_trace(CPUEXEC, (RETRO_LOG_DEBUG, LOGPRE "  cpu %d: %d cycles (suspended)\n", cpunum, cycles_running));
 
 			cpu[cpunum].totalcycles += cycles_running;
-			cpu[cpunum].localtime += TIME_IN_CYCLES(cycles_running, cpunum);
-			log_cb(RETRO_LOG_DEBUG, LOGPRE "         %d skipped, %d total, time = %.9f\n", cycles_running, (INT32)cpu[cpunum].totalcycles, cpu[cpunum].localtime);
+			cpu[cpunum].localtime = add_mame_times(cpu[cpunum].localtime, cycles_to_mame_time(cpunum, cycles_running));
+			log_trace(CPUEXEC, (RETRO_LOG_DEBUG, LOGPRE "         %d skipped, %d total, time = %.9f\n", cycles_running, (INT32)cpu[cpunum].totalcycles, mame_time_to_double(sub_mame_times(cpu[cpunum].localtime, base))));
 		}
 		
 		/* update the suspend state */
 		if (cpu[cpunum].suspend != cpu[cpunum].nextsuspend)
-			log_cb(RETRO_LOG_DEBUG, LOGPRE "--> updated CPU%d suspend from %X to %X\n", cpunum, cpu[cpunum].suspend, cpu[cpunum].nextsuspend);
+			log_trace(CPUEXEC, (RETRO_LOG_DEBUG, LOGPRE "--> updated CPU%d suspend from %X to %X\n", cpunum, cpu[cpunum].suspend, cpu[cpunum].nextsuspend));
 		cpu[cpunum].suspend = cpu[cpunum].nextsuspend;
 		cpu[cpunum].eatcycles = cpu[cpunum].nexteatcycles;
-
-		/* adjust to be relative to the global time */
-		cpu[cpunum].localtime -= target;
 	}
 	
 	/* update the global time */
-	timer_adjust_global_time(target);
+	mame_timer_set_global_time(target);
 
 	/* huh? something for the debugger */
 	#ifdef MAME_DEBUG
@@ -676,7 +683,7 @@ void activecpu_abort_timeslice(void)
 	int current_icount;
 	
 	VERIFY_EXECUTINGCPU_VOID(activecpu_abort_timeslice);
-	log_cb(RETRO_LOG_DEBUG, LOGPRE "activecpu_abort_timeslice (CPU=%d, cycles_left=%d)\n", cpu_getexecutingcpu(), activecpu_get_icount() + 1);
+	log_trace(CPUEXEC, (RETRO_LOG_DEBUG, LOGPRE "activecpu_abort_timeslice (CPU=%d, cycles_left=%d)\n", cpu_getexecutingcpu(), activecpu_get_icount() + 1));
 	
 	/* swallow the remaining cycles */
 	current_icount = activecpu_get_icount() + 1;
@@ -690,25 +697,23 @@ void activecpu_abort_timeslice(void)
 /*************************************
  *
  *	Return the current local time for
- *	a CPU, relative to the current
- *	timeslice
+ *	a CPU, in the timer system's
+ *	absolute time base
  *
  *************************************/
 
-double cpunum_get_localtime(int cpunum)
+void cpunum_get_localtime(int cpunum, mame_time *result)
 {
-	double result;
-	
-	VERIFY_CPUNUM(0, cpunum_get_localtime);
+	*result = time_zero;
+	VERIFY_CPUNUM_VOID(cpunum_get_localtime);
 
 	/* if we're active, add in the time from the current slice */
-	result = cpu[cpunum].localtime;
+	*result = cpu[cpunum].localtime;
 	if (cpunum == cpu_getexecutingcpu())
 	{
 		int cycles = cycles_currently_ran();
-		result += TIME_IN_CYCLES(cycles, cpunum);
+		*result = add_mame_times(*result, cycles_to_mame_time(cpunum, cycles));
 	}
-	return result;
 }
 
 
@@ -723,7 +728,7 @@ double cpunum_get_localtime(int cpunum)
 void cpunum_suspend(int cpunum, int reason, int eatcycles)
 {
 	VERIFY_CPUNUM_VOID(cpunum_suspend);
-	log_cb(RETRO_LOG_DEBUG, LOGPRE "cpunum_suspend (CPU=%d, r=%X, eat=%d)\n", cpunum, reason, eatcycles);
+	log_trace(CPUEXEC, (RETRO_LOG_DEBUG, LOGPRE "cpunum_suspend (CPU=%d, r=%X, eat=%d)\n", cpunum, reason, eatcycles));
 	
 	/* set the pending suspend bits, and force a resync */
 	cpu[cpunum].nextsuspend |= reason;
@@ -744,7 +749,7 @@ void cpunum_suspend(int cpunum, int reason, int eatcycles)
 void cpunum_resume(int cpunum, int reason)
 {
 	VERIFY_CPUNUM_VOID(cpunum_resume);
-	log_cb(RETRO_LOG_DEBUG, LOGPRE "cpunum_resume (CPU=%d, r=%X)\n", cpunum, reason);
+	log_trace(CPUEXEC, (RETRO_LOG_DEBUG, LOGPRE "cpunum_resume (CPU=%d, r=%X)\n", cpunum, reason));
 
 	/* clear the pending suspend bits, and force a resync */
 	cpu[cpunum].nextsuspend &= ~reason;
@@ -796,8 +801,7 @@ void cpunum_set_clockscale(int cpunum, double clockscale)
 	VERIFY_CPUNUM_VOID(cpunum_set_clockscale);
 
 	cpu[cpunum].clockscale = clockscale;
-	sec_to_cycles[cpunum] = cpu[cpunum].clockscale * Machine->drv->cpu[cpunum].cpu_clock;
-	cycles_to_sec[cpunum] = 1.0 / sec_to_cycles[cpunum];
+	timer_set_cpu_clock(cpunum, cpu[cpunum].clockscale * Machine->drv->cpu[cpunum].cpu_clock);
 
 	/* re-compute the perfect interleave factor */
 	compute_perfect_interleave();
@@ -818,7 +822,7 @@ void cpu_boost_interleave(double timeslice_time, double boost_duration)
 	if (timeslice_time < perfect_interleave)
 		timeslice_time = perfect_interleave;
 	
-	log_cb(RETRO_LOG_DEBUG, LOGPRE "cpu_boost_interleave(%.9f, %.9f)\n", timeslice_time, boost_duration);
+	log_trace(CPUEXEC, (RETRO_LOG_DEBUG, LOGPRE "cpu_boost_interleave(%.9f, %.9f)\n", timeslice_time, boost_duration));
 
 	/* adjust the interleave timer */
 	timer_adjust(interleave_boost_timer, timeslice_time, 0, timeslice_time);		
@@ -1546,7 +1550,7 @@ static void cpu_timeslicecallback(int param)
 static void end_interleave_boost(int param)
 {
 	timer_adjust(interleave_boost_timer, TIME_NEVER, 0, TIME_NEVER);		
-	log_cb(RETRO_LOG_DEBUG, LOGPRE "end_interleave_boost\n");
+	log_trace(CPUEXEC, (RETRO_LOG_DEBUG, LOGPRE "end_interleave_boost\n"));
 }
 
 
@@ -1581,7 +1585,7 @@ static void compute_perfect_interleave(void)
 	if (perfect_interleave == 1.0)
 		perfect_interleave = cycles_to_sec[0];
 
-	log_cb(RETRO_LOG_DEBUG, LOGPRE "Perfect interleave = %.9f, smallest = %.9f\n", perfect_interleave, smallest);
+	log_trace(CPUEXEC, (RETRO_LOG_DEBUG, LOGPRE "Perfect interleave = %.9f, smallest = %.9f\n", perfect_interleave, smallest));
 }
 
 
@@ -162,8 +162,8 @@ int cpunum_is_suspended(int cpunum, int reason);
 /* Aborts the timeslice for the active CPU */
 void activecpu_abort_timeslice(void);
 
-/* Returns the current local time for a CPU, relative to the current timeslice */
-double cpunum_get_localtime(int cpunum);
+/* Returns the current local time for a CPU, in the timer system's absolute time base */
+void cpunum_get_localtime(int cpunum, mame_time *result);
 
 /* Returns the current scaling factor for a CPU's clock speed */
 double cpunum_get_clockscale(int cpunum);
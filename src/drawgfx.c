@@ -26,6 +26,10 @@ UINT8 gfx_alpharange_table[256];
 
 static UINT8 is_raw[TRANSPARENCY_MODES];
 
+/* scratch copy of one packed element, for the modes without packed blitters */
+static UINT8 *unpacked_gfxdata;
+static int unpacked_size;
+
 
 #ifdef ALIGN_INTS /* GSL 980108 read/write nonaligned dword routine for ARM processor etc */
 
@@ -202,12 +206,350 @@ void decodechar(struct GfxElement *gfx,int num,const UINT8 *src,const struct Gfx
 	}
 
 	calc_penusage(gfx,num);
+
+	/* drivers redecoding a lazy set's element don't want it decoded again */
+	if (gfx->flags & GFX_LAZY)
+		gfx->valid[num >> 5] |= 1 << (num & 31);
 }
 
 
-struct GfxElement *decodegfx(const UINT8 *src,const struct GfxLayout *gl)
+/*-------------------------------------------------
+	gfx decode plans
+
+	decodegfx() compiles the layout once into a
+	list of the source bytes that feed each span
+	of up to 8 pixels of a row. Each byte is
+	looked up in a table that spreads its bits
+	into the span's pixels, so a span costs one
+	lookup per source byte rather than a readbit()
+	per plane and pixel. For GFX_PACKED sets the
+	tables hold the span already packed into
+	nibbles. Layouts that can't be
+	compiled (elements not starting on a byte,
+	or too many distinct tables) are decoded with
+	decodechar() as before.
+-------------------------------------------------*/
+
+#define GFX_DECODE_SPAN			8
+#define GFX_DECODE_MAX_TABLES	32
+
+struct gfx_decode_op
+{
+	UINT32 offset;			/* byte offset from the start of the element */
+	UINT32 table;			/* table spreading that byte into the span */
+};
+
+struct gfx_decode_plan
+{
+	int rowspans;			/* spans in a row */
+	int *first_op;			/* first op of each span, height * rowspans + 1 entries */
+	struct gfx_decode_op *ops;
+	UINT64 (*tables)[256];	/* pixels of a span, in memory order, for each byte value */
+};
+
+
+static void gfx_decode_plan_free(struct gfx_decode_plan *plan)
+{
+	if (plan)
+	{
+		free(plan->first_op);
+		free(plan->ops);
+		free(plan->tables);
+		free(plan);
+	}
+}
+
+
+static struct gfx_decode_plan *gfx_decode_plan_alloc(const struct GfxElement *gfx, const struct GfxLayout *gl)
+{
+	UINT8 contrib[GFX_DECODE_MAX_TABLES][8][GFX_DECODE_SPAN];	/* pixel bits set by each bit of the byte */
+	UINT32 offsets[MAX_GFX_PLANES * GFX_DECODE_SPAN];
+	UINT8 bytecontrib[8][GFX_DECODE_SPAN];
+	struct gfx_decode_plan *plan;
+	int table_count = 0;
+	int spans, span, op = 0;
+	int i, j, b;
+
+	if ((gl->charincrement & 7) || gl->planes > MAX_GFX_PLANES || gfx->width == 0)
+		return NULL;
+
+	plan = calloc(1, sizeof(*plan));
+	if (!plan)
+		return NULL;
+
+	plan->rowspans = (gfx->width + GFX_DECODE_SPAN - 1) / GFX_DECODE_SPAN;
+	spans = gfx->height * plan->rowspans;
+	plan->first_op = malloc((spans + 1) * sizeof(plan->first_op[0]));
+	plan->ops = malloc(spans * gl->planes * GFX_DECODE_SPAN * sizeof(plan->ops[0]));
+	if (!plan->first_op || !plan->ops)
+	{
+		gfx_decode_plan_free(plan);
+		return NULL;
+	}
+
+	for (span = 0; span < spans; span++)
+	{
+		int y = span / plan->rowspans;
+		int x0 = (span % plan->rowspans) * GFX_DECODE_SPAN;
+		int count = 0;
+
+		plan->first_op[span] = op;
+
+		/* the distinct source bytes read by this span */
+		for (i = 0; i < GFX_DECODE_SPAN && x0 + i < gfx->width; i++)
+			for (j = 0; j < gl->planes; j++)
+			{
+				UINT32 offset = (gl->planeoffset[j] + gl->yoffset[y] + gl->xoffset[x0 + i]) / 8;
+				for (b = 0; b < count && offsets[b] != offset; b++) ;
+				if (b == count)
+					offsets[count++] = offset;
+			}
+
+		for (b = 0; b < count; b++)
+		{
+			/* which pixels each bit of the byte lands in */
+			memset(bytecontrib, 0, sizeof(bytecontrib));
+			for (i = 0; i < GFX_DECODE_SPAN && x0 + i < gfx->width; i++)
+				for (j = 0; j < gl->planes; j++)
+				{
+					UINT32 bit = gl->planeoffset[j] + gl->yoffset[y] + gl->xoffset[x0 + i];
+					if (bit / 8 == offsets[b])
+						bytecontrib[bit % 8][i] |= 1 << (gl->planes - 1 - j);
+				}
+
+			/* share the table with any byte that spreads the same way */
+			for (j = 0; j < table_count && memcmp(contrib[j], bytecontrib, sizeof(bytecontrib)); j++) ;
+			if (j == table_count)
+			{
+				if (table_count == GFX_DECODE_MAX_TABLES)
+				{
+					gfx_decode_plan_free(plan);
+					return NULL;
+				}
+				memcpy(contrib[table_count++], bytecontrib, sizeof(bytecontrib));
+			}
+
+			plan->ops[op].offset = offsets[b];
+			plan->ops[op].table = j;
+			op++;
+		}
+	}
+	plan->first_op[spans] = op;
+
+	/* build the tables */
+	plan->tables = malloc(table_count * sizeof(plan->tables[0]));
+	if (!plan->tables)
+	{
+		gfx_decode_plan_free(plan);
+		return NULL;
+	}
+	for (j = 0; j < table_count; j++)
+		for (i = 0; i < 256; i++)
+		{
+			UINT8 pixels[GFX_DECODE_SPAN];
+			int x;
+
+			memset(pixels, 0, sizeof(pixels));
+			for (b = 0; b < 8; b++)
+				if (i & (0x80 >> b))
+					for (x = 0; x < GFX_DECODE_SPAN; x++)
+						pixels[x] |= contrib[j][b][x];
+
+			/* even pixels in the low nibble, as decodechar() packs them */
+			if (gfx->flags & GFX_PACKED)
+				for (x = 0; x < GFX_DECODE_SPAN; x += 2)
+				{
+					pixels[x / 2] = pixels[x] | (pixels[x + 1] << 4);
+					pixels[x + 1] = 0;
+				}
+			memcpy(&plan->tables[j][i], pixels, sizeof(pixels));
+		}
+
+	return plan;
+}
+
+
+static void gfx_decode_plan_run(const struct gfx_decode_plan *plan, struct GfxElement *gfx, int num, const UINT8 *src, const struct GfxLayout *gl)
 {
+	const UINT8 *base = src + (size_t)num * (gl->charincrement / 8);
+	const struct gfx_decode_op *op = plan->ops;
+	int packed = (gfx->flags & GFX_PACKED) ? 1 : 0;
+	int spanbytes = GFX_DECODE_SPAN >> packed;
+	int rowbytes = gfx->width >> packed;
+	UINT32 usage = 0;
+	int x, y, i;
+
+	for (y = 0; y < gfx->height; y++)
+	{
+		UINT8 *row = gfx->gfxdata + num * gfx->char_modulo + y * gfx->line_modulo;
+		UINT8 *dp = row;
+		const int *first_op = &plan->first_op[y * plan->rowspans];
+
+		for (x = 0; x < plan->rowspans; x++)
+		{
+			const struct gfx_decode_op *end = &plan->ops[first_op[x + 1]];
+			UINT64 pixels = 0;
+
+			for ( ; op < end; op++)
+				pixels |= plan->tables[op->table][base[op->offset]];
+
+			if (rowbytes - x * spanbytes >= spanbytes)
+				memcpy(dp, &pixels, spanbytes);
+			else
+				memcpy(dp, &pixels, rowbytes - x * spanbytes);
+			dp += spanbytes;
+		}
+
+		/* gather the pen usage while the row is still in the cache */
+		if (gfx->pen_usage)
+		{
+			if (packed)
+				for (i = 0; i < rowbytes; i++)
+					usage |= (1 << (row[i] & 0x0f)) | (1 << (row[i] >> 4));
+			else
+				for (i = 0; i < rowbytes; i++)
+					usage |= 1 << row[i];
+		}
+	}
+
+	if (gfx->pen_usage)
+		gfx->pen_usage[num] = usage;
+}
+
+
+
+/*-------------------------------------------------
+	decodegfx workers - decode a range of the
+	elements; big sets are split across threads
+-------------------------------------------------*/
+
+#define GFX_DECODE_THREAD_MIN	0x100000	/* decoded bytes worth starting threads for */
+#define GFX_DECODE_MAX_CHUNKS	64
+
+struct gfx_decode_work
+{
+	struct GfxElement *gfx;
+	const UINT8 *src;
+	const struct GfxLayout *gl;
+	const struct gfx_decode_plan *plan;
+	int start, end;
+};
+
+
+static void gfx_decode_range(void *param)
+{
+	struct gfx_decode_work *work = param;
 	int c;
+
+	for (c = work->start; c < work->end; c++)
+	{
+		if (work->gl->planeoffset[0] == GFX_RAW)
+			calc_penusage(work->gfx, c);
+		else if (work->plan)
+			gfx_decode_plan_run(work->plan, work->gfx, c, work->src, work->gl);
+		else
+			decodechar(work->gfx, c, work->src, work->gl);
+	}
+}
+
+
+static void gfx_decode_all(struct GfxElement *gfx, const UINT8 *src, const struct GfxLayout *gl)
+{
+	struct gfx_decode_work work[GFX_DECODE_MAX_CHUNKS];
+	struct osd_work_queue *queue = NULL;
+	int threads = osd_num_processors();
+	int chunks = 1, i;
+
+	if (threads > 1 && (UINT64)gfx->total_elements * gfx->char_modulo >= GFX_DECODE_THREAD_MIN)
+		queue = osd_work_queue_alloc(threads);
+	if (queue)
+	{
+		/* a few chunks per thread, to even out sparse and dense areas */
+		chunks = threads * 4;
+		if (chunks > GFX_DECODE_MAX_CHUNKS)
+			chunks = GFX_DECODE_MAX_CHUNKS;
+		if (chunks > gfx->total_elements)
+			chunks = gfx->total_elements;
+	}
+
+	work[0].gfx = gfx;
+	work[0].src = src;
+	work[0].gl = gl;
+	work[0].plan = (gl->planeoffset[0] == GFX_RAW) ? NULL : gfx_decode_plan_alloc(gfx, gl);
+
+	for (i = 0; i < chunks; i++)
+	{
+		work[i] = work[0];
+		work[i].start = (UINT64)gfx->total_elements * i / chunks;
+		work[i].end = (UINT64)gfx->total_elements * (i + 1) / chunks;
+		osd_work_item_queue(queue, gfx_decode_range, &work[i]);
+	}
+
+	osd_work_queue_free(queue);
+	gfx_decode_plan_free((struct gfx_decode_plan *)work[0].plan);
+}
+
+
+/*-------------------------------------------------
+	lazy decoding - with DECODEGFX_LAZY, decodegfx()
+	only allocates the set; each element is
+	decoded, and its pen usage computed, the first
+	time gfx_element_decode() is asked for it.
+	The source data and the compiled layout are
+	kept until the set is freed.
+-------------------------------------------------*/
+
+struct GfxLazyDecode
+{
+	const UINT8 *src;
+	struct GfxLayout gl;			/* a copy, the caller's is usually on the stack */
+	struct gfx_decode_plan *plan;	/* NULL if the layout couldn't be compiled */
+};
+
+
+void gfx_element_decode(const struct GfxElement *gfx,int code)
+{
+	struct GfxElement *element = (struct GfxElement *)gfx;
+	const struct GfxLazyDecode *lazy = gfx->lazy;
+
+	if (lazy->gl.planeoffset[0] == GFX_RAW)
+		calc_penusage(element,code);
+	else if (lazy->plan)
+		gfx_decode_plan_run(lazy->plan,element,code,lazy->src,&lazy->gl);
+	else
+		decodechar(element,code,lazy->src,&lazy->gl);
+
+	element->valid[code >> 5] |= 1 << (code & 31);
+}
+
+
+static int gfx_lazy_alloc(struct GfxElement *gfx,const UINT8 *src,const struct GfxLayout *gl)
+{
+	struct GfxLazyDecode *lazy;
+
+	lazy = calloc(1, sizeof(*lazy));
+	gfx->valid = calloc((gfx->total_elements + 31) / 32, sizeof(gfx->valid[0]));
+	if (!lazy || !gfx->valid)
+	{
+		free(lazy);
+		free(gfx->valid);
+		gfx->valid = NULL;
+		return 0;
+	}
+
+	lazy->src = src;
+	lazy->gl = *gl;
+	if (gl->planeoffset[0] != GFX_RAW)
+		lazy->plan = gfx_decode_plan_alloc(gfx,gl);
+
+	gfx->lazy = lazy;
+	gfx->flags |= GFX_LAZY;
+	return 1;
+}
+
+
+struct GfxElement *decodegfx_ex(const UINT8 *src,const struct GfxLayout *gl,int flags)
+{
 	struct GfxElement *gfx;
 
 
@@ -236,13 +578,13 @@ struct GfxElement *decodegfx(const UINT8 *src,const struct GfxLayout *gl)
 		gfx->gfxdata = (UINT8 *)src + gl->xoffset[0] / 8;
 		gfx->flags |= GFX_DONT_FREE_GFXDATA;
 
-		for (c = 0;c < gfx->total_elements;c++)
-			calc_penusage(gfx,c);
+		/* there's nothing to decode, only the pen usage to compute */
+		if (gfx->pen_usage && !((flags & DECODEGFX_LAZY) && gfx_lazy_alloc(gfx,src,gl)))
+			gfx_decode_all(gfx,src,gl);
 	}
 	else
 	{
-		if (0 && gl->planes <= 4 && !(gfx->width & 1))
-/*		if (gl->planes <= 4 && !(gfx->width & 1))*/
+		if ((flags & DECODEGFX_PACKED) && gl->planes <= 4 && !(gfx->width & 1))
 		{
 			gfx->flags |= GFX_PACKED;
 			gfx->line_modulo = gfx->width/2;
@@ -258,21 +600,41 @@ struct GfxElement *decodegfx(const UINT8 *src,const struct GfxLayout *gl)
 			return 0;
 		}
 
-		for (c = 0;c < gfx->total_elements;c++)
-			decodechar(gfx,c,src,gl);
+		if (!((flags & DECODEGFX_LAZY) && gfx_lazy_alloc(gfx,src,gl)))
+			gfx_decode_all(gfx,src,gl);
 	}
 
 	return gfx;
 }
 
 
+struct GfxElement *decodegfx(const UINT8 *src,const struct GfxLayout *gl)
+{
+	return decodegfx_ex(src,gl,0);
+}
+
+
 void freegfx(struct GfxElement *gfx)
 {
 	if (gfx)
 	{
 		free(gfx->pen_usage);
-		if (!(gfx->flags & GFX_DONT_FREE_GFXDATA))
+		if (gfx->flags & GFX_MAPPED_GFXDATA)
+			osd_unmap_file(gfx->gfxdata, (UINT64)gfx->total_elements * gfx->char_modulo);
+		else if (!(gfx->flags & GFX_DONT_FREE_GFXDATA))
 			free(gfx->gfxdata);
+		if (gfx->lazy)
+			gfx_decode_plan_free(gfx->lazy->plan);
+		free(gfx->lazy);
+		free(gfx->valid);
+
+		/* the unpack scratch buffer goes with the packed sets it served */
+		if (gfx->flags & GFX_PACKED)
+		{
+			free(unpacked_gfxdata);
+			unpacked_gfxdata = NULL;
+			unpacked_size = 0;
+		}
 		free(gfx);
 	}
 }
@@ -837,11 +1199,74 @@ static INLINE UINT32 SHADOW32(UINT32 c) {
 
 ***************************************************************************/
 
+/*-------------------------------------------------
+	packed elements - the common modes have
+	blitters that read GFX_PACKED data two pixels
+	to the byte; the rest draw from a copy of the
+	one element unpacked to a byte per pixel
+-------------------------------------------------*/
+
+static INLINE int drawgfx_packed_mode(int transparency)
+{
+	switch (transparency)
+	{
+		case TRANSPARENCY_NONE:
+		case TRANSPARENCY_NONE_RAW:
+		case TRANSPARENCY_PEN:
+		case TRANSPARENCY_PEN_RAW:
+		case TRANSPARENCY_PENS:
+		case TRANSPARENCY_PENS_RAW:
+		case TRANSPARENCY_COLOR:
+			return 1;
+	}
+	return 0;
+}
+
+static const struct GfxElement *unpack_element(const struct GfxElement *gfx,unsigned int code,struct GfxElement *unpacked)
+{
+	const UINT8 *src = gfx->gfxdata + code * gfx->char_modulo;
+	int size = gfx->width * gfx->height;
+	UINT8 *dst;
+	int x, y;
+
+	if (size > unpacked_size)
+	{
+		dst = realloc(unpacked_gfxdata, size);
+		if (!dst)
+			return NULL;
+		unpacked_gfxdata = dst;
+		unpacked_size = size;
+	}
+
+	*unpacked = *gfx;
+	unpacked->flags &= ~(GFX_PACKED | GFX_LAZY);
+	unpacked->line_modulo = gfx->width;
+	unpacked->char_modulo = size;
+	unpacked->total_elements = 1;
+	unpacked->pen_usage = NULL;
+	unpacked->gfxdata = dst = unpacked_gfxdata;
+
+	for (y = 0; y < gfx->height; y++)
+	{
+		for (x = 0; x < gfx->width / 2; x++)
+		{
+			dst[2*x] = src[x] & 0x0f;
+			dst[2*x+1] = src[x] >> 4;
+		}
+		src += gfx->line_modulo;
+		dst += gfx->width;
+	}
+	return unpacked;
+}
+
+
 static INLINE void common_drawgfx(struct mame_bitmap *dest,const struct GfxElement *gfx,
 		unsigned int code,unsigned int color,int flipx,int flipy,int sx,int sy,
 		const struct rectangle *clip,int transparency,int transparent_color,
 		struct mame_bitmap *pri_buffer,UINT32 pri_mask)
 {
+	struct GfxElement unpacked;
+
 	if (!gfx)
 	{
 		usrintf_showmessage("drawgfx() gfx == 0");
@@ -857,6 +1282,8 @@ static INLINE void common_drawgfx(struct mame_bitmap *dest,const struct GfxEleme
 	if (!is_raw[transparency])
 		color %= gfx->total_colors;
 
+	gfx_element_get_data(gfx,code);
+
 	if (!alpha_active && (transparency == TRANSPARENCY_ALPHAONE || transparency == TRANSPARENCY_ALPHA || transparency == TRANSPARENCY_ALPHARANGE))
 	{
 		if (transparency == TRANSPARENCY_ALPHAONE && (cpu_getcurrentframe() & 1))
@@ -892,6 +1319,13 @@ static INLINE void common_drawgfx(struct mame_bitmap *dest,const struct GfxEleme
 			transparency = TRANSPARENCY_NONE;
 	}
 
+	if ((gfx->flags & GFX_PACKED) && !drawgfx_packed_mode(transparency))
+	{
+		if ((gfx = unpack_element(gfx,code,&unpacked)) == NULL)
+			return;
+		code = 0;
+	}
+
 	if (dest->depth == 8)
 		drawgfx_core8(dest,gfx,code,color,flipx,flipy,sx,sy,clip,transparency,transparent_color,pri_buffer,pri_mask);
 	else if(dest->depth == 15 || dest->depth == 16)
@@ -1345,6 +1779,7 @@ static INLINE void common_drawgfxzoom( struct mame_bitmap *dest_bmp,const struct
 		const struct rectangle *clip,int transparency,int transparent_color,
 		int scalex, int scaley,struct mame_bitmap *pri_buffer,UINT32 pri_mask)
 {
+	struct GfxElement unpacked;
 	struct rectangle myclip;
 	int alphapen = 0;
 
@@ -1386,6 +1821,17 @@ static INLINE void common_drawgfxzoom( struct mame_bitmap *dest_bmp,const struct
 	if (transparency == TRANSPARENCY_COLOR)
 		transparent_color = Machine->pens[transparent_color];
 
+	if (gfx)
+		gfx_element_get_data(gfx,code % gfx->total_elements);
+
+	/* only the opaque and single pen loops read packed data */
+	if (gfx && (gfx->flags & GFX_PACKED) && transparency != TRANSPARENCY_NONE && transparency != TRANSPARENCY_PEN)
+	{
+		if ((gfx = unpack_element(gfx,code % gfx->total_elements,&unpacked)) == NULL)
+			return;
+		code = 0;
+	}
+
 
 	/*
 	scalex and scaley are 16.16 fixed point numbers
@@ -2840,39 +3286,82 @@ static INLINE void common_drawgfxzoom( struct mame_bitmap *dest_bmp,const struct
 					{
 						if (pri_buffer)
 						{
-							for( y=sy; y<ey; y++ )
+							if (gfx->flags & GFX_PACKED)
 							{
-								UINT8 *source = source_base + (y_index>>16) * gfx->line_modulo;
-								UINT32 *dest = (UINT32 *)dest_bmp->line[y];
-								UINT8 *pri = pri_buffer->line[y];
-
-								int x, x_index = x_index_base;
-								for( x=sx; x<ex; x++ )
+								for( y=sy; y<ey; y++ )
 								{
-									if (((1 << pri[x]) & pri_mask) == 0)
-										dest[x] = pal[source[x_index>>16]];
-									pri[x] = 31;
-									x_index += dx;
+									UINT8 *source = source_base + (y_index>>16) * gfx->line_modulo;
+									UINT32 *dest = (UINT32 *)dest_bmp->line[y];
+									UINT8 *pri = pri_buffer->line[y];
+
+									int x, x_index = x_index_base;
+									for( x=sx; x<ex; x++ )
+									{
+										if (((1 << pri[x]) & pri_mask) == 0)
+											dest[x] = pal[(source[x_index>>17] >> ((x_index & 0x10000) >> 14)) & 0x0f];
+										pri[x] = 31;
+										x_index += dx;
+									}
+
+									y_index += dy;
 								}
+							}
+							else
+							{
+								for( y=sy; y<ey; y++ )
+								{
+									UINT8 *source = source_base + (y_index>>16) * gfx->line_modulo;
+									UINT32 *dest = (UINT32 *)dest_bmp->line[y];
+									UINT8 *pri = pri_buffer->line[y];
 
-								y_index += dy;
+									int x, x_index = x_index_base;
+									for( x=sx; x<ex; x++ )
+									{
+										if (((1 << pri[x]) & pri_mask) == 0)
+											dest[x] = pal[source[x_index>>16]];
+										pri[x] = 31;
+										x_index += dx;
+									}
+
+									y_index += dy;
+								}
 							}
 						}
 						else
 						{
-							for( y=sy; y<ey; y++ )
+							if (gfx->flags & GFX_PACKED)
 							{
-								UINT8 *source = source_base + (y_index>>16) * gfx->line_modulo;
-								UINT32 *dest = (UINT32 *)dest_bmp->line[y];
-
-								int x, x_index = x_index_base;
-								for( x=sx; x<ex; x++ )
+								for( y=sy; y<ey; y++ )
 								{
-									dest[x] = pal[source[x_index>>16]];
-									x_index += dx;
+									UINT8 *source = source_base + (y_index>>16) * gfx->line_modulo;
+									UINT32 *dest = (UINT32 *)dest_bmp->line[y];
+
+									int x, x_index = x_index_base;
+									for( x=sx; x<ex; x++ )
+									{
+										dest[x] = pal[(source[x_index>>17] >> ((x_index & 0x10000) >> 14)) & 0x0f];
+										x_index += dx;
+									}
+
+									y_index += dy;
 								}
+							}
+							else
+							{
+								for( y=sy; y<ey; y++ )
+								{
+									UINT8 *source = source_base + (y_index>>16) * gfx->line_modulo;
+									UINT32 *dest = (UINT32 *)dest_bmp->line[y];
 
-								y_index += dy;
+									int x, x_index = x_index_base;
+									for( x=sx; x<ex; x++ )
+									{
+										dest[x] = pal[source[x_index>>16]];
+										x_index += dx;
+									}
+
+									y_index += dy;
+								}
 							}
 						}
 					}
@@ -2882,44 +3371,92 @@ static INLINE void common_drawgfxzoom( struct mame_bitmap *dest_bmp,const struct
 					{
 						if (pri_buffer)
 						{
-							for( y=sy; y<ey; y++ )
+							if (gfx->flags & GFX_PACKED)
 							{
-								UINT8 *source = source_base + (y_index>>16) * gfx->line_modulo;
-								UINT32 *dest = (UINT32 *)dest_bmp->line[y];
-								UINT8 *pri = pri_buffer->line[y];
-
-								int x, x_index = x_index_base;
-								for( x=sx; x<ex; x++ )
+								for( y=sy; y<ey; y++ )
 								{
-									int c = source[x_index>>16];
-									if( c != transparent_color )
+									UINT8 *source = source_base + (y_index>>16) * gfx->line_modulo;
+									UINT32 *dest = (UINT32 *)dest_bmp->line[y];
+									UINT8 *pri = pri_buffer->line[y];
+
+									int x, x_index = x_index_base;
+									for( x=sx; x<ex; x++ )
 									{
-										if (((1 << pri[x]) & pri_mask) == 0)
-											dest[x] = pal[c];
-										pri[x] = 31;
+										int c = (source[x_index>>17] >> ((x_index & 0x10000) >> 14)) & 0x0f;
+										if( c != transparent_color )
+										{
+											if (((1 << pri[x]) & pri_mask) == 0)
+												dest[x] = pal[c];
+											pri[x] = 31;
+										}
+										x_index += dx;
 									}
-									x_index += dx;
+
+									y_index += dy;
 								}
+							}
+							else
+							{
+								for( y=sy; y<ey; y++ )
+								{
+									UINT8 *source = source_base + (y_index>>16) * gfx->line_modulo;
+									UINT32 *dest = (UINT32 *)dest_bmp->line[y];
+									UINT8 *pri = pri_buffer->line[y];
 
-								y_index += dy;
+									int x, x_index = x_index_base;
+									for( x=sx; x<ex; x++ )
+									{
+										int c = source[x_index>>16];
+										if( c != transparent_color )
+										{
+											if (((1 << pri[x]) & pri_mask) == 0)
+												dest[x] = pal[c];
+											pri[x] = 31;
+										}
+										x_index += dx;
+									}
+
+									y_index += dy;
+								}
 							}
 						}
 						else
 						{
-							for( y=sy; y<ey; y++ )
+							if (gfx->flags & GFX_PACKED)
 							{
-								UINT8 *source = source_base + (y_index>>16) * gfx->line_modulo;
-								UINT32 *dest = (UINT32 *)dest_bmp->line[y];
-
-								int x, x_index = x_index_base;
-								for( x=sx; x<ex; x++ )
+								for( y=sy; y<ey; y++ )
 								{
-									int c = source[x_index>>16];
-									if( c != transparent_color ) dest[x] = pal[c];
-									x_index += dx;
+									UINT8 *source = source_base + (y_index>>16) * gfx->line_modulo;
+									UINT32 *dest = (UINT32 *)dest_bmp->line[y];
+
+									int x, x_index = x_index_base;
+									for( x=sx; x<ex; x++ )
+									{
+										int c = (source[x_index>>17] >> ((x_index & 0x10000) >> 14)) & 0x0f;
+										if( c != transparent_color ) dest[x] = pal[c];
+										x_index += dx;
+									}
+
+									y_index += dy;
 								}
+							}
+							else
+							{
+								for( y=sy; y<ey; y++ )
+								{
+									UINT8 *source = source_base + (y_index>>16) * gfx->line_modulo;
+									UINT32 *dest = (UINT32 *)dest_bmp->line[y];
 
-								y_index += dy;
+									int x, x_index = x_index_base;
+									for( x=sx; x<ex; x++ )
+									{
+										int c = source[x_index>>16];
+										if( c != transparent_color ) dest[x] = pal[c];
+										x_index += dx;
+									}
+
+									y_index += dy;
+								}
 							}
 						}
 					}
@@ -4155,6 +4692,79 @@ DECLARE_SWAP_RAW_PRI(blockmove_8toN_transmask,(COMMON_ARGS,
 	}
 })
 
+DECLARE_SWAP_RAW_PRI(blockmove_4toN_transmask,(COMMON_ARGS,
+		COLOR_ARG,int transmask),
+{
+	ADJUST_4
+
+	if (flipx)
+	{
+		DATA_TYPE *end;
+
+		while (dstheight)
+		{
+			int col;
+
+			end = dstdata - dstwidth*HMODULO;
+			if (leftskip)
+			{
+				col = *(srcdata++)>>4;
+				if (PEN_IS_OPAQUE) SETPIXELCOLOR(0,LOOKUP(col))
+				INCREMENT_DST(-HMODULO)
+			}
+			while (dstdata > end)
+			{
+				col = *(srcdata)&0x0f;
+				if (PEN_IS_OPAQUE) SETPIXELCOLOR(0,LOOKUP(col))
+				INCREMENT_DST(-HMODULO)
+				if (dstdata > end)
+				{
+					col = *(srcdata++)>>4;
+					if (PEN_IS_OPAQUE) SETPIXELCOLOR(0,LOOKUP(col))
+					INCREMENT_DST(-HMODULO)
+				}
+			}
+
+			srcdata += srcmodulo;
+			INCREMENT_DST(ydir*VMODULO + dstwidth*HMODULO)
+			dstheight--;
+		}
+	}
+	else
+	{
+		DATA_TYPE *end;
+
+		while (dstheight)
+		{
+			int col;
+
+			end = dstdata + dstwidth*HMODULO;
+			if (leftskip)
+			{
+				col = *(srcdata++)>>4;
+				if (PEN_IS_OPAQUE) SETPIXELCOLOR(0,LOOKUP(col))
+				INCREMENT_DST(HMODULO)
+			}
+			while (dstdata < end)
+			{
+				col = *(srcdata)&0x0f;
+				if (PEN_IS_OPAQUE) SETPIXELCOLOR(0,LOOKUP(col))
+				INCREMENT_DST(HMODULO)
+				if (dstdata < end)
+				{
+					col = *(srcdata++)>>4;
+					if (PEN_IS_OPAQUE) SETPIXELCOLOR(0,LOOKUP(col))
+					INCREMENT_DST(HMODULO)
+				}
+			}
+
+			srcdata += srcmodulo;
+			INCREMENT_DST(ydir*VMODULO - dstwidth*HMODULO)
+			dstheight--;
+		}
+	}
+})
+
 DECLARE_SWAP_RAW_PRI(blockmove_8toN_transcolor,(COMMON_ARGS,
 		COLOR_ARG,const UINT16 *colortable,int transcolor),
 {
@@ -5209,17 +5819,37 @@ DECLARE(drawgfx_core,(
 				break;
 
 			case TRANSPARENCY_PENS:
-				if (pribuf)
-					BLOCKMOVEPRI(8toN_transmask,(sd,sw,sh,sm,ls,ts,flipx,flipy,dd,dw,dh,dm,paldata,pribuf,pri_mask,transparent_color));
+				if (gfx->flags & GFX_PACKED)
+				{
+					if (pribuf)
+						BLOCKMOVEPRI(4toN_transmask,(sd,sw,sh,sm,ls,ts,flipx,flipy,dd,dw,dh,dm,paldata,pribuf,pri_mask,transparent_color));
+					else
+						BLOCKMOVELU(4toN_transmask,(sd,sw,sh,sm,ls,ts,flipx,flipy,dd,dw,dh,dm,paldata,transparent_color));
+				}
 				else
-					BLOCKMOVELU(8toN_transmask,(sd,sw,sh,sm,ls,ts,flipx,flipy,dd,dw,dh,dm,paldata,transparent_color));
+				{
+					if (pribuf)
+						BLOCKMOVEPRI(8toN_transmask,(sd,sw,sh,sm,ls,ts,flipx,flipy,dd,dw,dh,dm,paldata,pribuf,pri_mask,transparent_color));
+					else
+						BLOCKMOVELU(8toN_transmask,(sd,sw,sh,sm,ls,ts,flipx,flipy,dd,dw,dh,dm,paldata,transparent_color));
+				}
 				break;
 
 			case TRANSPARENCY_PENS_RAW:
-				if (pribuf)
-					BLOCKMOVERAWPRI(8toN_transmask,(sd,sw,sh,sm,ls,ts,flipx,flipy,dd,dw,dh,dm,color,pribuf,pri_mask,transparent_color));
+				if (gfx->flags & GFX_PACKED)
+				{
+					if (pribuf)
+						BLOCKMOVERAWPRI(4toN_transmask,(sd,sw,sh,sm,ls,ts,flipx,flipy,dd,dw,dh,dm,color,pribuf,pri_mask,transparent_color));
+					else
+						BLOCKMOVERAW(4toN_transmask,(sd,sw,sh,sm,ls,ts,flipx,flipy,dd,dw,dh,dm,color,transparent_color));
+				}
 				else
-					BLOCKMOVERAW(8toN_transmask,(sd,sw,sh,sm,ls,ts,flipx,flipy,dd,dw,dh,dm,color,transparent_color));
+				{
+					if (pribuf)
+						BLOCKMOVERAWPRI(8toN_transmask,(sd,sw,sh,sm,ls,ts,flipx,flipy,dd,dw,dh,dm,color,pribuf,pri_mask,transparent_color));
+					else
+						BLOCKMOVERAW(8toN_transmask,(sd,sw,sh,sm,ls,ts,flipx,flipy,dd,dw,dh,dm,color,transparent_color));
+				}
 				break;
 
 			case TRANSPARENCY_COLOR:
@@ -74,11 +74,17 @@ struct GfxElement
 	UINT32 line_modulo;	/* amount to add to get to the next line (usually = width) */
 	UINT32 char_modulo;	/* = line_modulo * height */
 	UINT32 flags;
+
+	/* with GFX_LAZY, elements are decoded the first time they are drawn */
+	UINT32 *valid;		/* a bit per element, set once it has been decoded */
+	struct GfxLazyDecode *lazy;	/* what's needed to decode it */
 };
 
-#define GFX_PACKED				1	/* two 4bpp pixels are packed in one byte of gfxdata */
+#define GFX_PACKED				1	/* two 4bpp pixels are packed in one byte of gfxdata, the left one in the low nibble */
 #define GFX_SWAPXY				2	/* characters are mirrored along the top-left/bottom-right diagonal */
 #define GFX_DONT_FREE_GFXDATA	4	/* gfxdata was not malloc()ed, so don't free it on exit */
+#define GFX_MAPPED_GFXDATA		8	/* gfxdata is mapped from the gfx cache, unmap it on exit */
+#define GFX_LAZY				16	/* gfxdata and pen_usage are only valid for elements marked in valid */
 
 
 struct GfxDecodeInfo
@@ -150,8 +156,31 @@ extern int pdrawgfx_shadow_lowpri;
 
 void decodechar(struct GfxElement *gfx,int num,const unsigned char *src,const struct GfxLayout *gl);
 struct GfxElement *decodegfx(const unsigned char *src,const struct GfxLayout *gl);
+struct GfxElement *decodegfx_ex(const unsigned char *src,const struct GfxLayout *gl,int flags);
+void gfx_element_decode(const struct GfxElement *gfx,int code);
 void set_pixel_functions(struct mame_bitmap *bitmap);
 void freegfx(struct GfxElement *gfx);
+
+/* decodegfx_ex() flags */
+#define DECODEGFX_PACKED	1	/* 4bpp layouts of even width are stored two pixels to a byte */
+#define DECODEGFX_LAZY		2	/* each element is decoded the first time it's asked for */
+
+/* code that reads an element's pixels or pen usage itself, rather than */
+/* through drawgfx() or SET_TILE_INFO, must fetch them with these */
+static INLINE const UINT8 *gfx_element_get_data(const struct GfxElement *gfx,int code)
+{
+	if ((gfx->flags & GFX_LAZY) && !(gfx->valid[code >> 5] & (1 << (code & 31))))
+		gfx_element_decode(gfx,code);
+	return gfx->gfxdata + code * gfx->char_modulo;
+}
+
+static INLINE UINT32 gfx_element_get_pen_usage(const struct GfxElement *gfx,int code)
+{
+	if ((gfx->flags & GFX_LAZY) && !(gfx->valid[code >> 5] & (1 << (code & 31))))
+		gfx_element_decode(gfx,code);
+	return gfx->pen_usage[code];
+}
+
 void drawgfx(struct mame_bitmap *dest,const struct GfxElement *gfx,
 		unsigned int code,unsigned int color,int flipx,int flipy,int sx,int sy,
 		const struct rectangle *clip,int transparency,int transparent_color);
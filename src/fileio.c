@@ -10,6 +10,14 @@
 
 #include <streams/file_stream.h>
 
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifndef _WIN32
+#include <memmap.h>		/* defines HAVE_MMAN where there is mmap() */
+#include <unistd.h>
+#endif
+
 #include "driver.h"
 #include "unzip.h"
 #include "fileio.h"
@@ -24,6 +32,7 @@
 #define RAM_FILE				1
 #define ZIPPED_FILE				2
 #define UNLOADED_ZIPPED_FILE	3
+#define MAPPED_FILE				4	/* data is mapped from a plain file or a stored zip entry */
 
 #define FILEFLAG_OPENREAD		0x01
 #define FILEFLAG_OPENWRITE		0x02
@@ -61,7 +70,7 @@ struct _mame_file
 ***************************************************************************/
 
 static mame_file *generic_fopen(int pathtype, const char *gamename, const char *filename, const char* hash, UINT32 flags);
-static int checksum_file(int pathtype, int pathindex, const char *file, UINT8 **p, UINT64 *size, char* hash);
+static int checksum_file(int pathtype, int pathindex, const char *file, UINT8 **p, UINT64 *size, char* hash, int *mapped);
 
 
 /***************************************************************************
@@ -152,6 +161,14 @@ mame_file *mame_fopen(const char *gamename, const char *filename, int filetype,
 		case FILETYPE_CTRLR:
 			return generic_fopen(filetype, gamename, filename, 0, openforwrite ? FILEFLAG_OPENWRITE : FILEFLAG_OPENREAD);
 
+		/* profiler traces */
+		case FILETYPE_PROFILE:
+			return generic_fopen(filetype, NULL, filename, 0, FILEFLAG_OPENWRITE);
+
+		/* ROM verification cache */
+		case FILETYPE_VERIFY_CACHE:
+			return generic_fopen(filetype, NULL, gamename, 0, openforwrite ? FILEFLAG_OPENWRITE : FILEFLAG_OPENREAD);
+
 		/* anything else */
 		default:
 			log_cb(RETRO_LOG_ERROR, LOGPRE "mame_fopen(): unknown filetype %02x\n", filetype);
@@ -241,6 +258,15 @@ void osd_get_path(int pathtype, char* path)
       case FILETYPE_XML_DAT:
          snprintf(path, PATH_MAX_LENGTH, "%s", save_path_buffer);
          break;
+      case FILETYPE_PROFILE:
+         snprintf(path, PATH_MAX_LENGTH, "%s%c%s", save_path_buffer, PATH_DEFAULT_SLASH_C(), "profile");
+         break;
+      case FILETYPE_VERIFY_CACHE:
+         snprintf(path, PATH_MAX_LENGTH, "%s%c%s", save_path_buffer, PATH_DEFAULT_SLASH_C(), "verify");
+         break;
+      case FILETYPE_GFX_CACHE:
+         snprintf(path, PATH_MAX_LENGTH, "%s%c%s", save_path_buffer, PATH_DEFAULT_SLASH_C(), "gfxcache");
+         break;
 
          /* static, pregenerated content goes in mam2003 system directory subfolders */
       case FILETYPE_ARTWORK:
@@ -260,9 +286,9 @@ void osd_get_path(int pathtype, char* path)
    }
    /* Create path if it doesn't exist and log create failures */
    if (!path_is_directory(path))
-     if (!path_mkdir(path)) log_cb(RETRO_LOG_DEBUG, LOGPRE "osd_get_path() failed to create path:  %s\n", path);
+     if (!path_mkdir(path)) log_trace(FILEIO, (RETRO_LOG_DEBUG, LOGPRE "osd_get_path() failed to create path:  %s\n", path));
 
-   log_cb(RETRO_LOG_DEBUG, LOGPRE "osd_get_path() return path=  %s\n", path);
+   log_trace(FILEIO, (RETRO_LOG_DEBUG, LOGPRE "osd_get_path() return path=  %s\n", path));
 }
 
 int osd_get_path_info(int pathtype, int pathindex, const char *filename)
@@ -273,19 +299,19 @@ int osd_get_path_info(int pathtype, int pathindex, const char *filename)
    osd_get_path(pathtype, currDir);
    snprintf(buffer, PATH_MAX_LENGTH, "%s%c%s", currDir, PATH_DEFAULT_SLASH_C(), filename);
 
-   log_cb(RETRO_LOG_DEBUG, "(osd_get_path_info) buffer=  %s\n", buffer);
+   log_trace(FILEIO, (RETRO_LOG_DEBUG, "(osd_get_path_info) buffer=  %s\n", buffer));
 
    if (path_is_directory(buffer))
    {
-       log_cb(RETRO_LOG_DEBUG, "(osd_get_path_info) path is directory _-_ %s\n",buffer);
+       log_trace(FILEIO, (RETRO_LOG_DEBUG, "(osd_get_path_info) path is directory _-_ %s\n",buffer));
       return PATH_IS_DIRECTORY;
    }
    else if (filestream_exists(buffer))
    {
-      log_cb(RETRO_LOG_DEBUG, "(osd_get_path_info) path is file _-_ %s\n",buffer);
+      log_trace(FILEIO, (RETRO_LOG_DEBUG, "(osd_get_path_info) path is file _-_ %s\n",buffer));
       return PATH_IS_FILE;
    }
-   log_cb(RETRO_LOG_DEBUG, "(osd_get_path_info) path not found _-_ %s\n",buffer);
+   log_trace(FILEIO, (RETRO_LOG_DEBUG, "(osd_get_path_info) path not found _-_ %s\n",buffer));
    return PATH_NOT_FOUND;
 }
 
@@ -299,12 +325,68 @@ FILE* osd_fopen(int pathtype, int pathindex, const char *filename, const char *m
    snprintf(buffer, PATH_MAX_LENGTH, "%s%c%s", currDir, PATH_DEFAULT_SLASH_C(), filename);
 
    out = fopen(buffer, mode);
-   if (out)  log_cb(RETRO_LOG_DEBUG, "(osd_fopen) opened the file:  %s\n", buffer);
-   else  log_cb(RETRO_LOG_DEBUG, "(osd_fopen) failed to open file:  %s\n", buffer);
+   if (out)  log_trace(FILEIO, (RETRO_LOG_DEBUG, "(osd_fopen) opened the file:  %s\n", buffer));
+   else  log_trace(FILEIO, (RETRO_LOG_DEBUG, "(osd_fopen) failed to open file:  %s\n", buffer));
 
    return out;
 }
 
+int osd_get_file_stamp(int pathtype, int pathindex, const char *filename, UINT64 *size, INT64 *mtime)
+{
+   char buffer[PATH_MAX_LENGTH]= {0};
+   char currDir[PATH_MAX_LENGTH]= {0};
+   struct stat st;
+
+   osd_get_path(pathtype, currDir);
+   snprintf(buffer, PATH_MAX_LENGTH, "%s%c%s", currDir, PATH_DEFAULT_SLASH_C(), filename);
+
+   if (stat(buffer, &st) != 0)
+      return -1;
+
+   *size = st.st_size;
+   *mtime = st.st_mtime;
+   return 0;
+}
+
+
+
+/***************************************************************************
+	osd_map_file
+***************************************************************************/
+
+UINT8 *osd_map_file(FILE *file, UINT64 offset, UINT64 length)
+{
+#ifdef HAVE_MMAN
+	long pagesize = sysconf(_SC_PAGESIZE);
+	UINT64 start, delta;
+	void *map;
+
+	if (length == 0 || pagesize <= 0)
+		return NULL;
+
+	/* mappings start on a page boundary */
+	start = offset & ~(UINT64)(pagesize - 1);
+	delta = offset - start;
+
+	map = mmap(NULL, length + delta, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileno(file), start);
+	if (map == MAP_FAILED)
+		return NULL;
+	return (UINT8 *)map + delta;
+#else
+	return NULL;
+#endif
+}
+
+
+void osd_unmap_file(UINT8 *data, UINT64 length)
+{
+#ifdef HAVE_MMAN
+	/* the mapping is page aligned, so the offset into it is the data's offset into its page */
+	UINT64 delta = (FPTR)data & (sysconf(_SC_PAGESIZE) - 1);
+	munmap(data - delta, length + delta);
+#endif
+}
+
 
 
 /***************************************************************************
@@ -342,6 +424,10 @@ void mame_fclose(mame_file *file)
 			if (file->data)
 				free(file->data);
 			break;
+
+		case MAPPED_FILE:
+			osd_unmap_file(file->data, file->length);
+			break;
 	}
 
 	/* free the file data */
@@ -382,19 +468,19 @@ int mame_faccess(const char *filename, int filetype)
 
 		/* first check the raw filename, in case we're looking for a directory */
 		sprintf(name, "%s", filename);
-		log_cb(RETRO_LOG_DEBUG, LOGPRE "mame_faccess: trying %s\n", name);
+		log_trace(FILEIO, (RETRO_LOG_DEBUG, LOGPRE "mame_faccess: trying %s\n", name));
 		if (osd_get_path_info(filetype, pathindex, name) != PATH_NOT_FOUND)
 			return 1;
 
 		/* try again with a .zip extension */
 		sprintf(name, "%s.zip", filename);
-		log_cb(RETRO_LOG_DEBUG, LOGPRE "mame_faccess: trying %s\n", name);
+		log_trace(FILEIO, (RETRO_LOG_DEBUG, LOGPRE "mame_faccess: trying %s\n", name));
 		if (osd_get_path_info(filetype, pathindex, name) != PATH_NOT_FOUND)
 			return 1;
 
 		/* does such a directory (or file) exist? */
 		sprintf(name, "%s", modified_filename);
-		log_cb(RETRO_LOG_DEBUG, LOGPRE "mame_faccess: trying %s\n", name);
+		log_trace(FILEIO, (RETRO_LOG_DEBUG, LOGPRE "mame_faccess: trying %s\n", name));
 		if (osd_get_path_info(filetype, pathindex, name) != PATH_NOT_FOUND)
 			return 1;
 	}
@@ -419,6 +505,7 @@ UINT32 mame_fread(mame_file *file, void *buffer, UINT32 length)
 
 		case ZIPPED_FILE:
 		case RAM_FILE:
+		case MAPPED_FILE:
 			if (file->data)
 			{
 				if (file->offset + length > file->length)
@@ -476,6 +563,7 @@ int mame_fseek(mame_file *file, INT64 offset, int whence)
 
 		case ZIPPED_FILE:
 		case RAM_FILE:
+		case MAPPED_FILE:
 			switch (whence)
 			{
 				case SEEK_SET:
@@ -543,6 +631,7 @@ UINT64 mame_fsize(mame_file *file)
 
 		case RAM_FILE:
 		case ZIPPED_FILE:
+		case MAPPED_FILE:
 			return file->length;
 	}
 
@@ -580,6 +669,7 @@ int mame_fgetc(mame_file *file)
 
 		case RAM_FILE:
 		case ZIPPED_FILE:
+		case MAPPED_FILE:
 			if (file->offset < file->length)
 				return file->data[file->offset++];
 			else
@@ -615,6 +705,7 @@ int mame_ungetc(int c, mame_file *file)
 
 		case RAM_FILE:
 		case ZIPPED_FILE:
+		case MAPPED_FILE:
 			if (file->eof)
 				file->eof = 0;
 			else if (file->offset > 0)
@@ -693,6 +784,7 @@ int mame_feof(mame_file *file)
 
 		case RAM_FILE:
 		case ZIPPED_FILE:
+		case MAPPED_FILE:
 			return (file->eof);
 	}
 
@@ -715,6 +807,7 @@ UINT64 mame_ftell(mame_file *file)
 
 		case RAM_FILE:
 		case ZIPPED_FILE:
+		case MAPPED_FILE:
 			return file->offset;
 	}
 
@@ -883,12 +976,269 @@ const char *get_extension_for_filetype(int filetype)
 			extension = "ini";
 			break;
 
+		case FILETYPE_VERIFY_CACHE:	/* ROM verification cache */
+			extension = "vfy";
+			break;
+
 	}
 	return extension;
 }
 
 
 
+/***************************************************************************
+	verification cache
+
+	A ROM whose computed CRC matched the one its zip directory records
+	(or any ROM found as a plain file) has its hash remembered, together
+	with the size and modification time of the archive it came from. As
+	long as those don't change, the next load takes the hash from here
+	rather than running CRC and SHA1 over the whole file again. Each set
+	keeps its own file in the save folder, rewritten only when something
+	had to be hashed.
+***************************************************************************/
+
+#define VERIFY_CACHE_HEADER		"# " APPNAME " ROM verification cache v1"
+
+struct verify_entry
+{
+	struct verify_entry *next;
+	char *path;							/* zip or plain file, relative to the ROM path */
+	UINT32 crc;							/* CRC from the zip directory, 0 for plain files */
+	UINT32 length;						/* uncompressed length of the ROM */
+	UINT64 file_size;					/* size of path when the hash was computed */
+	INT64 file_time;					/* modification time of path, likewise */
+	int used;							/* looked up or stored during this load */
+	char hash[HASH_BUF_SIZE];
+};
+
+static char verify_gamename[32];
+static struct verify_entry *verify_list;
+static struct osd_lock *verify_lock;
+static int verify_active;
+static int verify_dirty;
+
+
+static struct verify_entry *verify_cache_find(const char *path, UINT32 crc, UINT32 length)
+{
+	struct verify_entry *entry;
+
+	for (entry = verify_list; entry; entry = entry->next)
+		if (entry->crc == crc && entry->length == length && !strcmp(entry->path, path))
+			return entry;
+	return NULL;
+}
+
+
+static struct verify_entry *verify_cache_add(const char *path, UINT32 crc, UINT32 length)
+{
+	struct verify_entry *entry = calloc(1, sizeof(*entry));
+
+	if (!entry)
+		return NULL;
+	entry->path = strdup(path);
+	if (!entry->path)
+	{
+		free(entry);
+		return NULL;
+	}
+	entry->crc = crc;
+	entry->length = length;
+	entry->next = verify_list;
+	verify_list = entry;
+	return entry;
+}
+
+
+/*-------------------------------------------------
+	verify_cache_lookup - fill in hash from the
+	cache if path is unchanged and every function
+	asked for was computed; returns !=0 on a hit
+-------------------------------------------------*/
+
+static int verify_cache_lookup(int pathtype, int pathindex, const char *path, UINT32 crc, UINT32 length, unsigned int functions, char *hash)
+{
+	struct verify_entry *entry;
+	UINT64 size;
+	INT64 mtime;
+	int i, hit = 0;
+
+	if (!verify_active || osd_get_file_stamp(pathtype, pathindex, path, &size, &mtime) != 0)
+		return 0;
+
+	/* zero means all the functions, as for hash_compute() */
+	if (functions == 0)
+		functions = (1 << HASH_NUM_FUNCTIONS) - 1;
+
+	osd_lock_acquire(verify_lock);
+	entry = verify_cache_find(path, crc, length);
+	if (entry && entry->file_size == size && entry->file_time == mtime &&
+			(hash_data_used_functions(entry->hash) & functions) == functions)
+	{
+		/* hand back just the functions asked for, as if computed */
+		hash_data_clear(hash);
+		for (i = 0; i < HASH_NUM_FUNCTIONS; i++)
+			if (functions & (1 << i))
+			{
+				UINT8 chksum[256];
+				hash_data_extract_binary_checksum(entry->hash, 1 << i, chksum);
+				hash_data_insert_binary_checksum(hash, 1 << i, chksum);
+			}
+		entry->used = 1;
+		hit = 1;
+	}
+	osd_lock_release(verify_lock);
+
+	if (hit)
+		log_trace(FILEIO, (RETRO_LOG_DEBUG, LOGPRE "verify cache: HIT %s %08x\n", path, crc));
+	return hit;
+}
+
+
+/*-------------------------------------------------
+	verify_cache_store - remember a freshly
+	computed hash; zipped ROMs only count as
+	verified if it matches the directory's CRC
+-------------------------------------------------*/
+
+static void verify_cache_store(int pathtype, int pathindex, const char *path, int zipped, UINT32 crc, UINT32 length, const char *hash)
+{
+	struct verify_entry *entry;
+	UINT64 size;
+	INT64 mtime;
+
+	if (!verify_active || osd_get_file_stamp(pathtype, pathindex, path, &size, &mtime) != 0)
+		return;
+
+	if (zipped)
+	{
+		UINT8 crcs[4];
+
+		if (hash_data_extract_binary_checksum(hash, HASH_CRC, crcs) != 1)
+			return;
+		if ((((UINT32)crcs[0] << 24) | (crcs[1] << 16) | (crcs[2] << 8) | crcs[3]) != crc)
+		{
+			log_trace(FILEIO, (RETRO_LOG_DEBUG, LOGPRE "verify cache: %s %08x doesn't match its CRC\n", path, crc));
+			return;
+		}
+	}
+
+	osd_lock_acquire(verify_lock);
+	entry = verify_cache_find(path, crc, length);
+	if (!entry)
+		entry = verify_cache_add(path, crc, length);
+	if (entry)
+	{
+		entry->file_size = size;
+		entry->file_time = mtime;
+		entry->used = 1;
+		hash_data_copy(entry->hash, hash);
+		verify_dirty = 1;
+	}
+	osd_lock_release(verify_lock);
+}
+
+
+/*-------------------------------------------------
+	mame_verify_cache_open - read the cache for
+	a set
+-------------------------------------------------*/
+
+void mame_verify_cache_open(const char *gamename)
+{
+	mame_file *file;
+	char line[PATH_MAX_LENGTH + HASH_BUF_SIZE + 64];
+
+	mame_verify_cache_close();
+
+	snprintf(verify_gamename, sizeof(verify_gamename), "%s", gamename);
+	verify_lock = osd_lock_alloc();
+	verify_active = 1;
+
+	file = mame_fopen(verify_gamename, NULL, FILETYPE_VERIFY_CACHE, 0);
+	if (!file)
+		return;
+
+	/* ignore a cache written in any other format */
+	if (mame_fgets(line, sizeof(line), file) && !strncmp(line, VERIFY_CACHE_HEADER, strlen(VERIFY_CACHE_HEADER)))
+	{
+		while (mame_fgets(line, sizeof(line), file))
+		{
+			struct verify_entry *entry;
+			unsigned int crc, length;
+			unsigned long long size, mtime;
+			char hash[HASH_BUF_SIZE];
+			char *path = strchr(line, '\t');
+
+			/* crc length size mtime hash<TAB>path */
+			if (!path || sscanf(line, "%x %x %llx %llx %255s", &crc, &length, &size, &mtime, hash) != 5)
+				continue;
+			*path++ = 0;
+			path[strcspn(path, "\r\n")] = 0;
+
+			entry = verify_cache_add(path, crc, length);
+			if (entry)
+			{
+				entry->file_size = size;
+				entry->file_time = mtime;
+				hash_data_copy(entry->hash, hash);
+			}
+		}
+	}
+	mame_fclose(file);
+}
+
+
+/*-------------------------------------------------
+	mame_verify_cache_close - write back the
+	entries used by this load if any were added,
+	and free the cache
+-------------------------------------------------*/
+
+void mame_verify_cache_close(void)
+{
+	struct verify_entry *entry;
+	char line[PATH_MAX_LENGTH + HASH_BUF_SIZE + 64];
+
+	if (!verify_active)
+		return;
+
+	if (verify_dirty)
+	{
+		mame_file *file = mame_fopen(verify_gamename, NULL, FILETYPE_VERIFY_CACHE, 1);
+		if (file)
+		{
+			mame_fwrite(file, VERIFY_CACHE_HEADER "\n", strlen(VERIFY_CACHE_HEADER "\n"));
+			for (entry = verify_list; entry; entry = entry->next)
+				if (entry->used)
+				{
+					int len = snprintf(line, sizeof(line), "%08x %x %llx %llx %s\t%s\n", entry->crc, entry->length,
+							(unsigned long long)entry->file_size, (unsigned long long)entry->file_time, entry->hash, entry->path);
+					if (len > 0 && len < sizeof(line))
+						mame_fwrite(file, line, len);
+				}
+			mame_fclose(file);
+		}
+		else
+			log_cb(RETRO_LOG_WARN, LOGPRE "Unable to write ROM verification cache for %s\n", verify_gamename);
+	}
+
+	while (verify_list)
+	{
+		entry = verify_list;
+		verify_list = entry->next;
+		free(entry->path);
+		free(entry);
+	}
+
+	osd_lock_free(verify_lock);
+	verify_lock = NULL;
+	verify_active = 0;
+	verify_dirty = 0;
+}
+
+
+
 /***************************************************************************
 	generic_fopen
 ***************************************************************************/
@@ -902,7 +1252,7 @@ static mame_file *generic_fopen(int pathtype, const char *gamename, const char *
 	mame_file file, *newfile;
 	char tempname[256];
 
-	log_cb(RETRO_LOG_DEBUG, "(generic_fopen) (pathtype:%d, gamename:%s, filename:%s, extension:%s, flags:%X)\n", pathtype, gamename, filename, extension, flags);
+	log_trace(FILEIO, (RETRO_LOG_DEBUG, "(generic_fopen) (pathtype:%d, gamename:%s, filename:%s, extension:%s, flags:%X)\n", pathtype, gamename, filename, extension, flags));
 
 	/* reset the file handle */
 	memset(&file, 0, sizeof(file));
@@ -934,22 +1284,24 @@ static mame_file *generic_fopen(int pathtype, const char *gamename, const char *
 
 		/* first look for path/gamename as a directory */
 		compose_path(name, gamename, NULL, NULL);
-		log_cb(RETRO_LOG_DEBUG, LOGPRE "Trying %s\n", name);
+		log_trace(FILEIO, (RETRO_LOG_DEBUG, LOGPRE "Trying %s\n", name));
 
 
 		/* if the directory exists, proceed */
 		if (*name == 0 || osd_get_path_info(pathtype, pathindex, name) == PATH_IS_DIRECTORY)
 		{
-			log_cb(RETRO_LOG_DEBUG, LOGPRE "(generic_fopen) directory exists: %s\n", name);
+			log_trace(FILEIO, (RETRO_LOG_DEBUG, LOGPRE "(generic_fopen) directory exists: %s\n", name));
 			/* now look for path/gamename/filename.ext */
 			compose_path(name, gamename, filename, extension);
 
 			/* if we need checksums, load it into RAM and compute it along the way */
 			if (flags & FILEFLAG_HASH)
 			{
-				if (checksum_file(pathtype, pathindex, name, &file.data, &file.length, file.hash) == 0)
+				int mapped;
+
+				if (checksum_file(pathtype, pathindex, name, &file.data, &file.length, file.hash, &mapped) == 0)
 				{
-					file.type = RAM_FILE;
+					file.type = mapped ? MAPPED_FILE : RAM_FILE;
 					break;
 				}
 			}
@@ -957,7 +1309,7 @@ static mame_file *generic_fopen(int pathtype, const char *gamename, const char *
 			/* otherwise, just open it straight */
 			else
 			{
-				log_cb(RETRO_LOG_DEBUG, LOGPRE " (generic_fopen) using osd_fopen %s\n", name);
+				log_trace(FILEIO, (RETRO_LOG_DEBUG, LOGPRE " (generic_fopen) using osd_fopen %s\n", name));
 				file.type = PLAIN_FILE;
 				file.file = osd_fopen(pathtype, pathindex, name, access_modes[flags & 3]);
 				if (file.file == NULL && (flags & 3) == 3)
@@ -976,7 +1328,7 @@ static mame_file *generic_fopen(int pathtype, const char *gamename, const char *
 		{
 			/* first look for path/gamename.zip */
 			compose_path(name, gamename, NULL, "zip");
-			log_cb(RETRO_LOG_DEBUG, LOGPRE "Trying %s file\n", name);
+			log_trace(FILEIO, (RETRO_LOG_DEBUG, LOGPRE "Trying %s file\n", name));
 
 			/* if the ZIP file exists, proceed */
 			if (osd_get_path_info(pathtype, pathindex, name) == PATH_IS_FILE)
@@ -1024,10 +1376,11 @@ static mame_file *generic_fopen(int pathtype, const char *gamename, const char *
 				/* full load case */
 				else
 				{
-					int err;
+					unsigned int zipcrc;
+					int err, mapped;
 
 					/* Try loading the file */
-					err = load_zipped_file(pathtype, pathindex, name, tempname, &file.data, &ziplength);
+					err = load_zipped_file(pathtype, pathindex, name, tempname, &file.data, &ziplength, &zipcrc, &mapped);
 
 					/* If it failed, since this is a ZIP file, we can try to load by CRC
 					   if an expected hash has been provided. unzip.c uses this ugly hack
@@ -1038,16 +1391,16 @@ static mame_file *generic_fopen(int pathtype, const char *gamename, const char *
 
 						hash_data_extract_printable_checksum(hash, HASH_CRC, crcn);
 
-						err = load_zipped_file(pathtype, pathindex, name, crcn, &file.data, &ziplength);
+						err = load_zipped_file(pathtype, pathindex, name, crcn, &file.data, &ziplength, &zipcrc, &mapped);
 					}
 
 					if (err == 0)
 					{
 						unsigned functions;
 
-						log_cb(RETRO_LOG_DEBUG, LOGPRE "Using (mame_fopen) zip file for %s\n", filename);
+						log_trace(FILEIO, (RETRO_LOG_DEBUG, LOGPRE "Using (mame_fopen) zip file for %s\n", filename));
 						file.length = ziplength;
-						file.type = ZIPPED_FILE;
+						file.type = mapped ? MAPPED_FILE : ZIPPED_FILE;
 
 						/* Since we already loaded the file, we can easily calculate the
 						   checksum of all the functions. In practice, we use only the
@@ -1059,7 +1412,12 @@ static mame_file *generic_fopen(int pathtype, const char *gamename, const char *
 						if (options.crc_only && (functions & HASH_CRC))
 							functions = HASH_CRC;
 
-						hash_compute(file.hash, file.data, file.length, functions);
+						/* skip it if this entry of an unchanged zip verified before */
+						if (!verify_cache_lookup(pathtype, pathindex, name, zipcrc, ziplength, functions, file.hash))
+						{
+							hash_compute(file.hash, file.data, file.length, functions);
+							verify_cache_store(pathtype, pathindex, name, 1, zipcrc, ziplength, file.hash);
+						}
 						break;
 					}
 				}
@@ -1090,7 +1448,7 @@ static mame_file *generic_fopen(int pathtype, const char *gamename, const char *
 	checksum_file
 ***************************************************************************/
 
-static int checksum_file(int pathtype, int pathindex, const char *file, UINT8 **p, UINT64 *size, char* hash)
+static int checksum_file(int pathtype, int pathindex, const char *file, UINT8 **p, UINT64 *size, char* hash, int *mapped)
 {
 	UINT64 length;
 	UINT8 *data;
@@ -1116,27 +1474,26 @@ static int checksum_file(int pathtype, int pathindex, const char *file, UINT8 **
 		return -1;
 	}
 
-	/* allocate space for entire file */
-	data = malloc(length);
-	if (!data)
-	{
-		fclose(f);
-		return -1;
-	}
+	/* map the file if we can, so it's hashed and copied from the page cache */
+	data = osd_map_file(f, 0, length);
+	*mapped = (data != NULL);
 
-	/* read entire file into memory */
-	if (fseek(f, 0L, SEEK_SET) != 0)
+	/* otherwise read entire file into memory */
+	if (!data)
 	{
-		free(data);
-		fclose(f);
-		return -1;
-	}
+		data = malloc(length);
+		if (!data)
+		{
+			fclose(f);
+			return -1;
+		}
 
-	if (fread(data, 1, length, f) != length)
-	{
-		free(data);
-		fclose(f);
-		return -1;
+		if (fseek(f, 0L, SEEK_SET) != 0 || fread(data, 1, length, f) != length)
+		{
+			free(data);
+			fclose(f);
+			return -1;
+		}
 	}
 
 	*size = length;
@@ -1148,11 +1505,17 @@ static int checksum_file(int pathtype, int pathindex, const char *file, UINT8 **
 	functions = hash_data_used_functions(hash);
 	if (options.crc_only && (functions & HASH_CRC))
 		functions = HASH_CRC;
-	hash_compute(hash, data, length, functions);
+	if (!verify_cache_lookup(pathtype, pathindex, file, 0, length, functions, hash))
+	{
+		hash_compute(hash, data, length, functions);
+		verify_cache_store(pathtype, pathindex, file, 0, 0, length, hash);
+	}
 
 	/* if the caller wants the data, give it away, otherwise free it */
 	if (p)
 		*p = data;
+	else if (*mapped)
+		osd_unmap_file(data, length);
 	else
 		free(data);
 
@@ -38,6 +38,9 @@ enum
 	FILETYPE_LANGUAGE,
 	FILETYPE_CTRLR,
 	FILETYPE_XML_DAT,
+	FILETYPE_PROFILE,
+	FILETYPE_VERIFY_CACHE,
+	FILETYPE_GFX_CACHE,
 	FILETYPE_end /* dummy last entry */
 };
 
@@ -79,6 +82,15 @@ int osd_get_path_info(int pathtype, int pathindex, const char *filename);
 /* Attempt to open a file with the given name and mode using the specified path type */
 FILE* osd_fopen(int pathtype, int pathindex, const char *filename, const char *mode);
 
+/* Get the size and modification time of a file; returns 0 on success */
+int osd_get_file_stamp(int pathtype, int pathindex, const char *filename, UINT64 *size, INT64 *mtime);
+
+/* Map part of an open file, so it can be used straight from the page cache. The pages
+   are private: writing to them changes only this copy, never the file. Returns NULL if
+   the platform can't, in which case the caller reads the file instead. */
+UINT8 *osd_map_file(FILE *file, UINT64 offset, UINT64 length);
+void osd_unmap_file(UINT8 *data, UINT64 length);
+
 int osd_create_directory(const char *dir);
 
 
@@ -113,6 +125,12 @@ char *mame_fgets(char *s, int n, mame_file *file);
 int mame_feof(mame_file *file);
 UINT64 mame_ftell(mame_file *file);
 
+/* Remember the hashes of ROMs that verified, so unchanged archives aren't
+   hashed again on the next launch; open before loading a set's ROMs and
+   close once done to write back what changed */
+void mame_verify_cache_open(const char *gamename);
+void mame_verify_cache_close(void);
+
 int mame_fputs(mame_file *f, const char *s);
 int mame_vfprintf(mame_file *f, const char *fmt, va_list va);
 
@@ -138,6 +138,15 @@
 
 #define ASSERT(x)
 
+/* Running state of one checksum; each hash_compute() call has its own, so
+   ROMs can be hashed from several threads at once */
+typedef union
+{
+	UINT32 crc;
+	struct sha1_ctx sha1;
+	MD5_CTX md5;
+} hash_context;
+
 typedef struct 
 {
 	const char* name;           /* human-readable name*/
@@ -145,23 +154,23 @@ typedef struct
 	unsigned int size;          /* checksum size in bytes*/
 	
 	/* Functions used to calculate the hash of a memory block*/
-	void (*calculate_begin)(void);
-	void (*calculate_buffer)(const void* mem, unsigned long len);
-	void (*calculate_end)(UINT8* bin_chksum);
+	void (*calculate_begin)(hash_context* ctx);
+	void (*calculate_buffer)(hash_context* ctx, const void* mem, unsigned long len);
+	void (*calculate_end)(hash_context* ctx, UINT8* bin_chksum);
 
 } hash_function_desc;
 
-static void h_crc_begin(void);
-static void h_crc_buffer(const void* mem, unsigned long len);
-static void h_crc_end(UINT8* chksum);
+static void h_crc_begin(hash_context* ctx);
+static void h_crc_buffer(hash_context* ctx, const void* mem, unsigned long len);
+static void h_crc_end(hash_context* ctx, UINT8* chksum);
 
-static void h_sha1_begin(void);
-static void h_sha1_buffer(const void* mem, unsigned long len);
-static void h_sha1_end(UINT8* chksum);
+static void h_sha1_begin(hash_context* ctx);
+static void h_sha1_buffer(hash_context* ctx, const void* mem, unsigned long len);
+static void h_sha1_end(hash_context* ctx, UINT8* chksum);
 
-static void h_md5_begin(void);
-static void h_md5_buffer(const void* mem, unsigned long len);
-static void h_md5_end(UINT8* chksum);
+static void h_md5_begin(hash_context* ctx);
+static void h_md5_buffer(hash_context* ctx, const void* mem, unsigned long len);
+static void h_md5_end(hash_context* ctx, UINT8* chksum);
 
 static hash_function_desc hash_descs[HASH_NUM_FUNCTIONS] =
 {
@@ -533,11 +542,12 @@ void hash_compute(char* dst, const unsigned char* data, unsigned long length, un
 		if (functions & func)
 		{
 			hash_function_desc* desc = hash_get_function_desc(func);
+			hash_context ctx;
 			UINT8 chksum[256];
 
-			desc->calculate_begin();
-			desc->calculate_buffer(data, length);
-			desc->calculate_end(chksum);
+			desc->calculate_begin(&ctx);
+			desc->calculate_buffer(&ctx, data, length);
+			desc->calculate_end(&ctx, chksum);
 
 			dst += hash_data_add_binary_checksum(dst, func, chksum);
 		}
@@ -636,65 +646,59 @@ int hash_verify_string(const char *hash)
 	Hash functions - Wrappers
  *********************************************************************/
 
-static UINT32 crc;
-
-static void h_crc_begin(void)
+static void h_crc_begin(hash_context* ctx)
 {
-	crc = 0;
+	ctx->crc = 0;
 }
 
-static void h_crc_buffer(const void* mem, unsigned long len)
+static void h_crc_buffer(hash_context* ctx, const void* mem, unsigned long len)
 {
-	crc = crc32(crc, (UINT8*)mem, len);
+	ctx->crc = crc32(ctx->crc, (UINT8*)mem, len);
 }
 
-static void h_crc_end(UINT8* bin_chksum)
+static void h_crc_end(hash_context* ctx, UINT8* bin_chksum)
 {
-	bin_chksum[0] = (UINT8)(crc >> 24);
-	bin_chksum[1] = (UINT8)(crc >> 16);
-	bin_chksum[2] = (UINT8)(crc >> 8);
-	bin_chksum[3] = (UINT8)(crc >> 0);
+	bin_chksum[0] = (UINT8)(ctx->crc >> 24);
+	bin_chksum[1] = (UINT8)(ctx->crc >> 16);
+	bin_chksum[2] = (UINT8)(ctx->crc >> 8);
+	bin_chksum[3] = (UINT8)(ctx->crc >> 0);
 }
 
 
-struct sha1_ctx sha1ctx;
-
-static void h_sha1_begin(void)
+static void h_sha1_begin(hash_context* ctx)
 {
-	sha1_init(&sha1ctx);
+	sha1_init(&ctx->sha1);
 }
 
-static void h_sha1_buffer(const void* mem, unsigned long len)
+static void h_sha1_buffer(hash_context* ctx, const void* mem, unsigned long len)
 {
-	sha1_update(&sha1ctx, len, (UINT8*)mem);
+	sha1_update(&ctx->sha1, len, (UINT8*)mem);
 }
 
-static void h_sha1_end(UINT8* bin_chksum)
+static void h_sha1_end(hash_context* ctx, UINT8* bin_chksum)
 {
-	sha1_final(&sha1ctx);
-	sha1_digest(&sha1ctx, 20, bin_chksum);
+	sha1_final(&ctx->sha1);
+	sha1_digest(&ctx->sha1, 20, bin_chksum);
 }
 
 
-static MD5_CTX md5;
-
-static void h_md5_begin(void)
+static void h_md5_begin(hash_context* ctx)
 {
 #ifndef HAVE_LIBNX // Add hw crypto later, works without
-	MD5_Init(&md5);
+	MD5_Init(&ctx->md5);
 #endif
 }
 
-static void h_md5_buffer(const void* mem, unsigned long len)
+static void h_md5_buffer(hash_context* ctx, const void* mem, unsigned long len)
 {
 #ifndef HAVE_LIBNX // Add hw crypto later, works without
-	MD5_Update(&md5, (md5byte*)mem, len);
+	MD5_Update(&ctx->md5, (md5byte*)mem, len);
 #endif
 }
 
-static void h_md5_end(UINT8* bin_chksum)
+static void h_md5_end(hash_context* ctx, UINT8* bin_chksum)
 {
 #ifndef HAVE_LIBNX // Add hw crypto later, works without
-	MD5_Final(bin_chksum, &md5);
+	MD5_Final(bin_chksum, &ctx->md5);
 #endif
 }
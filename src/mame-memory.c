@@ -123,6 +123,16 @@ struct cpu_data
 	offs_t				op_mem_min;			/* dynamic ROM/RAM min */
 	offs_t				op_mem_max;			/* dynamic ROM/RAM max */
 	UINT8		 		opcode_entry;		/* opcode base handler */
+	UINT8				opcode_stale;		/* opcodes were invalidated since they were last fetched */
+	offs_t				opcode_stale_min;	/* lowest invalidated opcode address */
+	offs_t				opcode_stale_max;	/* highest invalidated opcode address */
+
+	UINT32				bank_op_used;		/* mask of the banks this CPU reads through */
+	offs_t				bank_op_min[STATIC_BANKMAX + 1];	/* lowest address read through each bank */
+	offs_t				bank_op_max[STATIC_BANKMAX + 1];	/* highest address read through each bank */
+
+	struct memory_direct direct_read[MEMORY_DIRECT_SLOTS];	/* saved direct read runs */
+	struct memory_direct direct_write[MEMORY_DIRECT_SLOTS];	/* saved direct write runs */
 
 	struct memport_data	mem;				/* memory tables */
 	struct memport_data	port;				/* port tables */
@@ -157,6 +167,8 @@ offs_t						mem_amask;						/* memory address mask */
 static offs_t				port_amask;						/* port address mask */
 
 UINT8 *						cpu_bankbase[STATIC_COUNT];		/* array of bank bases */
+struct memory_direct		memory_direct_read[MEMORY_DIRECT_SLOTS];	/* direct read runs */
+struct memory_direct		memory_direct_write[MEMORY_DIRECT_SLOTS];	/* direct write runs */
 int ext_entries = 0;										/* number of entries ext_memory[] entries used */
 struct ExtMemory			ext_memory[MAX_EXT_MEMORY];		/* externally-allocated memory */
 
@@ -235,6 +247,7 @@ int memory_init(void)
 	/* no current context to start */
 	cur_context = -1;
 	unmap_value = 0;
+	memory_direct_invalidate(-1);
 
 	/* init the static handlers */
 	if (!init_static())
@@ -326,6 +339,7 @@ void memory_set_opcode_base(int cpunum, void *base)
 		cpudata[cpunum].op_mem_min = (offs_t) 0x00000000;
 		cpudata[cpunum].op_mem_max = (offs_t) 0x7fffffff;
 	}
+	memory_invalidate_opcodes(cpunum, 0, ~0);
 }
 
 
@@ -350,6 +364,8 @@ void memory_set_context(int activecpu)
 		cpudata[cur_context].op_mem_min = OP_MEM_MIN;
 		cpudata[cur_context].op_mem_max = OP_MEM_MAX;
 		cpudata[cur_context].opcode_entry = opcode_entry;
+		memcpy(cpudata[cur_context].direct_read, memory_direct_read, sizeof(memory_direct_read));
+		memcpy(cpudata[cur_context].direct_write, memory_direct_write, sizeof(memory_direct_write));
 	}
 	cur_context = activecpu;
 
@@ -358,7 +374,10 @@ void memory_set_context(int activecpu)
 	OP_ROM = cpudata[activecpu].op_rom;
 	OP_MEM_MIN = cpudata[activecpu].op_mem_min;
 	OP_MEM_MAX = cpudata[activecpu].op_mem_max;
-	opcode_entry = opcode_entry;
+	opcode_entry = cpudata[activecpu].opcode_entry;
+
+	memcpy(memory_direct_read, cpudata[activecpu].direct_read, sizeof(memory_direct_read));
+	memcpy(memory_direct_write, cpudata[activecpu].direct_write, sizeof(memory_direct_write));
 
 	readmem_lookup = cpudata[activecpu].mem.read.table;
 	writemem_lookup = cpudata[activecpu].mem.write.table;
@@ -383,6 +402,62 @@ void memory_set_unmap_value(data32_t value)
 }
 
 
+/*-------------------------------------------------
+	memory_set_bankptr - point a bank at new
+	memory; opcode bases that were resolved into
+	the bank are moved along with it instead of
+	being looked up again
+-------------------------------------------------*/
+
+static void move_opbase(UINT8 **op_ram, UINT8 **op_rom, UINT8 *oldbase, UINT8 *newbase)
+{
+	/* keeps OP_ROM - OP_RAM, the same as SETOPBASE would */
+	*op_rom = newbase + (*op_rom - oldbase);
+	*op_ram = newbase + (*op_ram - oldbase);
+}
+
+void memory_set_bankptr(int bank, void *base)
+{
+	UINT8 *oldbase = cpu_bankbase[bank];
+	int cpunum;
+
+	if ((UINT8 *)base == oldbase)
+		return;
+
+	cpu_bankbase[bank] = base;
+	memory_direct_invalidate(bank);
+
+	/* code fetched through the bank is now something else */
+	for (cpunum = 0; cpunum < MAX_CPU; cpunum++)
+		if (cpudata[cpunum].bank_op_used & (1 << bank))
+			memory_invalidate_opcodes(cpunum, cpudata[cpunum].bank_op_min[bank], cpudata[cpunum].bank_op_max[bank]);
+
+	/* the CPU whose opcode base is live */
+	if (cur_context != -1 && opcode_entry == bank)
+	{
+		/* an opbase handler gets to see the new mapping */
+		if (opbasefunc)
+		{
+			opcode_entry = 0xff;
+			if (cpu_getactivecpu() >= 0)
+				activecpu_set_op_base(activecpu_get_pc_byte());
+		}
+		else
+			move_opbase(&OP_RAM, &OP_ROM, oldbase, base);
+	}
+
+	/* and the ones that are switched out */
+	for (cpunum = 0; cpunum < MAX_CPU; cpunum++)
+		if (cpunum != cur_context && cpudata[cpunum].opcode_entry == bank)
+		{
+			if (cpudata[cpunum].opbase)
+				cpudata[cpunum].opcode_entry = 0xff;
+			else
+				move_opbase((UINT8 **)&cpudata[cpunum].op_ram, (UINT8 **)&cpudata[cpunum].op_rom, oldbase, base);
+		}
+}
+
+
 /*-------------------------------------------------
 	memory_set_bankhandler_r - set readmemory
 	handler for bank memory (8-bit only!)
@@ -402,6 +477,7 @@ void memory_set_bankhandler_r(int bank, offs_t offset, mem_read_handler handler)
 	if (HANDLER_IS_STATIC(handler))
 		handler = rmemhandler8s[(FPTR)handler];
 	rmemhandler8[bank].handler = (void *)handler;
+	memory_direct_invalidate(bank);
 }
 
 
@@ -424,6 +500,7 @@ void memory_set_bankhandler_w(int bank, offs_t offset, mem_write_handler handler
 	if (HANDLER_IS_STATIC(handler))
 		handler = wmemhandler8s[(FPTR)handler];
 	wmemhandler8[bank].handler = (void *)handler;
+	memory_direct_invalidate(bank);
 }
 
 
@@ -438,10 +515,90 @@ opbase_handler memory_set_opbase_handler(int cpunum, opbase_handler function)
 	cpudata[cpunum].opbase = function;
 	if (cpunum == cpu_getactivecpu())
 		opbasefunc = function;
+	if (function != old)
+		memory_invalidate_opcodes(cpunum, 0, ~0);
 	return old;
 }
 
 
+/*-------------------------------------------------
+	memory_invalidate_opcodes - tell anything that
+	caches translated opcodes for a CPU, such as a
+	recompiler, that the ones between start and
+	end are stale
+-------------------------------------------------*/
+
+void memory_invalidate_opcodes(int cpunum, offs_t start, offs_t end)
+{
+	struct cpu_data *cpu = &cpudata[cpunum];
+
+	if (!cpu->opcode_stale)
+	{
+		cpu->opcode_stale = 1;
+		cpu->opcode_stale_min = start;
+		cpu->opcode_stale_max = end;
+	}
+	else
+	{
+		if (start < cpu->opcode_stale_min)
+			cpu->opcode_stale_min = start;
+		if (end > cpu->opcode_stale_max)
+			cpu->opcode_stale_max = end;
+	}
+}
+
+
+/*-------------------------------------------------
+	memory_get_stale_opcodes - fetch the range
+	invalidated since the last call; returns 0 if
+	nothing was
+-------------------------------------------------*/
+
+int memory_get_stale_opcodes(int cpunum, offs_t *start, offs_t *end)
+{
+	struct cpu_data *cpu = &cpudata[cpunum];
+
+	if (!cpu->opcode_stale)
+		return 0;
+	*start = cpu->opcode_stale_min;
+	*end = cpu->opcode_stale_max;
+	cpu->opcode_stale = 0;
+	return 1;
+}
+
+
+/*-------------------------------------------------
+	memory_direct_invalidate - forget the direct
+	data runs that belong to a bank, or all of
+	them if bank is negative
+-------------------------------------------------*/
+
+static void invalidate_direct(struct memory_direct *direct, int bank)
+{
+	int i;
+
+	for (i = 0; i < MEMORY_DIRECT_SLOTS; i++)
+		if (bank < 0 || direct[i].entry == bank)
+		{
+			direct[i].span = 0;
+			direct[i].entry = STATIC_INVALID;
+		}
+}
+
+void memory_direct_invalidate(int bank)
+{
+	int cpunum;
+
+	invalidate_direct(memory_direct_read, bank);
+	invalidate_direct(memory_direct_write, bank);
+	for (cpunum = 0; cpunum < MAX_CPU; cpunum++)
+	{
+		invalidate_direct(cpudata[cpunum].direct_read, bank);
+		invalidate_direct(cpudata[cpunum].direct_write, bank);
+	}
+}
+
+
 /*-------------------------------------------------
 	install_mem_read_handler - install dynamic
 	read handler for 8-bit case
@@ -1020,9 +1177,31 @@ void install_mem_handler(struct memport_data *memport, int iswrite, offs_t start
 	if (IS_SPARSE(memport->abits) && HANDLER_IS_RAM(handler))
 		handler = (void *)assign_dynamic_bank(memport->cpunum, start);
 
+	/* remember where the CPU reads through banks, for memory_set_bankptr */
+	if (!iswrite && HANDLER_IS_BANK(handler))
+	{
+		struct cpu_data *cpu = &cpudata[memport->cpunum];
+		int bank = HANDLER_TO_BANK(handler);
+
+		if (!(cpu->bank_op_used & (1 << bank)))
+		{
+			cpu->bank_op_used |= 1 << bank;
+			cpu->bank_op_min[bank] = start;
+			cpu->bank_op_max[bank] = end;
+		}
+		else
+		{
+			if (start < cpu->bank_op_min[bank])
+				cpu->bank_op_min[bank] = start;
+			if (end > cpu->bank_op_max[bank])
+				cpu->bank_op_max[bank] = end;
+		}
+	}
+
 	/* set the handler */
 	idx = get_handler_index(tabledata->handlers, handler, start);
 	populate_table(memport, iswrite, start, end, idx);
+	memory_direct_invalidate(-1);
 
 	/* if this is a bank, set the bankbase as well */
 	if (HANDLER_IS_BANK(handler))
@@ -2356,6 +2535,51 @@ void name(offs_t pc)																	\
 }
 
 
+/*-------------------------------------------------
+	SETDIRECT - fill in a direct data run for an
+	offset, if it's in RAM, ROM or a bank. The run
+	grows over neighbouring 1st level pages that
+	map the same way; the base is returned, NULL
+	if the offset needs the handlers.
+-------------------------------------------------*/
+
+#define SETDIRECT(name,abits,minbits,lookup,handlist,direct)							\
+UINT8 *name(offs_t offset)																\
+{																						\
+	const int shift = LEVEL2_BITS((abits)-(minbits)) + (minbits);						\
+	offs_t page, first, last;															\
+	UINT8 entry;																		\
+	int i;																				\
+																						\
+	/* subtables and handlers aren't worth it */										\
+	offset &= mem_amask;																\
+	page = LEVEL1_INDEX(offset,abits,minbits);											\
+	entry = lookup[page];																\
+	if (entry == STATIC_INVALID || entry > STATIC_RAM || !cpu_bankbase[entry])			\
+		return NULL;																	\
+																						\
+	/* find the extent of the run */													\
+	first = last = page;																\
+	while (first > 0 && page - first < MEMORY_DIRECT_PAGES && lookup[first - 1] == entry)	\
+		first--;																		\
+	while (last < (mem_amask >> shift) && last - page < MEMORY_DIRECT_PAGES && lookup[last + 1] == entry)	\
+		last++;																			\
+																						\
+	/* the last word of a run misses, but it's there already */						\
+	for (i = 0; i < MEMORY_DIRECT_SLOTS; i++)											\
+		if (direct[i].span && direct[i].entry == entry && direct[i].min == (first << shift))	\
+			return direct[i].base;														\
+																						\
+	/* most recently filled first */													\
+	memmove(&direct[1], &direct[0], sizeof(direct[0]) * (MEMORY_DIRECT_SLOTS - 1));	\
+	direct[0].min = first << shift;														\
+	direct[0].span = ((last - first + 1) << shift) - 3;									\
+	direct[0].base = cpu_bankbase[entry] - handlist[entry].offset;						\
+	direct[0].entry = entry;															\
+	return direct[0].base;																\
+}
+
+
 /*-------------------------------------------------
 	GENERATE_HANDLERS - macros to spew out all
 	the handlers needed for a given memory type
@@ -2405,7 +2629,9 @@ SETOPBASE(cpu_setopbase##abits,           abits, 0, rmemhandler8)
 
 #define GENERATE_MEM_HANDLERS_16BIT_BE(abits) \
 GENERATE_HANDLERS_16BIT_BE(mem, abits) \
-SETOPBASE(cpu_setopbase##abits##bew,      abits, 1, rmemhandler16)
+SETOPBASE(cpu_setopbase##abits##bew,      abits, 1, rmemhandler16) \
+SETDIRECT(cpu_setdirectread##abits##bew,  abits, 1, readmem_lookup,  rmemhandler16, memory_direct_read) \
+SETDIRECT(cpu_setdirectwrite##abits##bew, abits, 1, writemem_lookup, wmemhandler16, memory_direct_write)
 
 #define GENERATE_MEM_HANDLERS_16BIT_LE(abits) \
 GENERATE_HANDLERS_16BIT_LE(mem, abits) \
@@ -2613,81 +2839,81 @@ static INLINE offs_t effective_offset(offs_t offset)
 
 static READ_HANDLER( mrh8_bad )
 {
-	log_cb(RETRO_LOG_DEBUG, LOGPRE "cpu #%d (PC=%08X): unmapped memory byte read from %08X\n", cpu_getactivecpu(), activecpu_get_pc(), effective_offset(offset));
+	log_trace(MEMORY, (RETRO_LOG_DEBUG, LOGPRE "cpu #%d (PC=%08X): unmapped memory byte read from %08X\n", cpu_getactivecpu(), activecpu_get_pc(), effective_offset(offset)));
 	if (activecpu_address_bits() <= SPARSE_THRESH && unmap_value == 0) return cpu_bankbase[STATIC_RAM][offset];
 	return unmap_value;
 }
 static READ16_HANDLER( mrh16_bad )
 {
-	log_cb(RETRO_LOG_DEBUG, LOGPRE "cpu #%d (PC=%08X): unmapped memory word read from %08X & %04X\n", cpu_getactivecpu(), activecpu_get_pc(), effective_offset(offset*2), mem_mask ^ 0xffff);
+	log_trace(MEMORY, (RETRO_LOG_DEBUG, LOGPRE "cpu #%d (PC=%08X): unmapped memory word read from %08X & %04X\n", cpu_getactivecpu(), activecpu_get_pc(), effective_offset(offset*2), mem_mask ^ 0xffff));
 	if (activecpu_address_bits() <= SPARSE_THRESH && unmap_value == 0) return ((data16_t *)cpu_bankbase[STATIC_RAM])[offset];
 	return unmap_value;
 }
 static READ32_HANDLER( mrh32_bad )
 {
-	log_cb(RETRO_LOG_DEBUG, LOGPRE "cpu #%d (PC=%08X): unmapped memory dword read from %08X & %08X\n", cpu_getactivecpu(), activecpu_get_pc(), effective_offset(offset*4), mem_mask ^ 0xffffffff);
+	log_trace(MEMORY, (RETRO_LOG_DEBUG, LOGPRE "cpu #%d (PC=%08X): unmapped memory dword read from %08X & %08X\n", cpu_getactivecpu(), activecpu_get_pc(), effective_offset(offset*4), mem_mask ^ 0xffffffff));
 	if (activecpu_address_bits() <= SPARSE_THRESH && unmap_value == 0) return ((data32_t *)cpu_bankbase[STATIC_RAM])[offset];
 	return unmap_value;
 }
 
 static WRITE_HANDLER( mwh8_bad )
 {
-	log_cb(RETRO_LOG_DEBUG, LOGPRE "cpu #%d (PC=%08X): unmapped memory byte write to %08X = %02X\n", cpu_getactivecpu(), activecpu_get_pc(), effective_offset(offset), data);
+	log_trace(MEMORY, (RETRO_LOG_DEBUG, LOGPRE "cpu #%d (PC=%08X): unmapped memory byte write to %08X = %02X\n", cpu_getactivecpu(), activecpu_get_pc(), effective_offset(offset), data));
 	if (activecpu_address_bits() <= SPARSE_THRESH) cpu_bankbase[STATIC_RAM][offset] = data;
 }
 static WRITE16_HANDLER( mwh16_bad )
 {
-	log_cb(RETRO_LOG_DEBUG, LOGPRE "cpu #%d (PC=%08X): unmapped memory word write to %08X = %04X & %04X\n", cpu_getactivecpu(), activecpu_get_pc(), effective_offset(offset*2), data, mem_mask ^ 0xffff);
+	log_trace(MEMORY, (RETRO_LOG_DEBUG, LOGPRE "cpu #%d (PC=%08X): unmapped memory word write to %08X = %04X & %04X\n", cpu_getactivecpu(), activecpu_get_pc(), effective_offset(offset*2), data, mem_mask ^ 0xffff));
 	if (activecpu_address_bits() <= SPARSE_THRESH) COMBINE_DATA(&((data16_t *)cpu_bankbase[STATIC_RAM])[offset]);
 }
 static WRITE32_HANDLER( mwh32_bad )
 {
-	log_cb(RETRO_LOG_DEBUG, LOGPRE "cpu #%d (PC=%08X): unmapped memory dword write to %08X = %08X & %08X\n", cpu_getactivecpu(), activecpu_get_pc(), effective_offset(offset*4), data, mem_mask ^ 0xffffffff);
+	log_trace(MEMORY, (RETRO_LOG_DEBUG, LOGPRE "cpu #%d (PC=%08X): unmapped memory dword write to %08X = %08X & %08X\n", cpu_getactivecpu(), activecpu_get_pc(), effective_offset(offset*4), data, mem_mask ^ 0xffffffff));
 	if (activecpu_address_bits() <= SPARSE_THRESH) COMBINE_DATA(&((data32_t *)cpu_bankbase[STATIC_RAM])[offset]);
 }
 
 static READ_HANDLER( prh8_bad )
 {
-	log_cb(RETRO_LOG_DEBUG, LOGPRE "cpu #%d (PC=%08X): unmapped port byte read from %08X\n", cpu_getactivecpu(), activecpu_get_pc(), offset);
+	log_trace(MEMORY, (RETRO_LOG_DEBUG, LOGPRE "cpu #%d (PC=%08X): unmapped port byte read from %08X\n", cpu_getactivecpu(), activecpu_get_pc(), offset));
 	return unmap_value;
 }
 static READ16_HANDLER( prh16_bad )
 {
-	log_cb(RETRO_LOG_DEBUG, LOGPRE "cpu #%d (PC=%08X): unmapped port word read from %08X & %04X\n", cpu_getactivecpu(), activecpu_get_pc(), offset*2, mem_mask ^ 0xffff);
+	log_trace(MEMORY, (RETRO_LOG_DEBUG, LOGPRE "cpu #%d (PC=%08X): unmapped port word read from %08X & %04X\n", cpu_getactivecpu(), activecpu_get_pc(), offset*2, mem_mask ^ 0xffff));
 	return unmap_value;
 }
 static READ32_HANDLER( prh32_bad )
 {
-	log_cb(RETRO_LOG_DEBUG, LOGPRE "cpu #%d (PC=%08X): unmapped port dword read from %08X & %08X\n", cpu_getactivecpu(), activecpu_get_pc(), offset*4, mem_mask ^ 0xffffffff);
+	log_trace(MEMORY, (RETRO_LOG_DEBUG, LOGPRE "cpu #%d (PC=%08X): unmapped port dword read from %08X & %08X\n", cpu_getactivecpu(), activecpu_get_pc(), offset*4, mem_mask ^ 0xffffffff));
 	return unmap_value;
 }
 
 static WRITE_HANDLER( pwh8_bad )
 {
-	log_cb(RETRO_LOG_DEBUG, LOGPRE "cpu #%d (PC=%08X): unmapped port byte write to %08X = %02X\n", cpu_getactivecpu(), activecpu_get_pc(), offset, data);
+	log_trace(MEMORY, (RETRO_LOG_DEBUG, LOGPRE "cpu #%d (PC=%08X): unmapped port byte write to %08X = %02X\n", cpu_getactivecpu(), activecpu_get_pc(), offset, data));
 }
 static WRITE16_HANDLER( pwh16_bad )
 {
-	log_cb(RETRO_LOG_DEBUG, LOGPRE "cpu #%d (PC=%08X): unmapped port word write to %08X = %04X & %04X\n", cpu_getactivecpu(), activecpu_get_pc(), offset*2, data, mem_mask ^ 0xffff);
+	log_trace(MEMORY, (RETRO_LOG_DEBUG, LOGPRE "cpu #%d (PC=%08X): unmapped port word write to %08X = %04X & %04X\n", cpu_getactivecpu(), activecpu_get_pc(), offset*2, data, mem_mask ^ 0xffff));
 }
 static WRITE32_HANDLER( pwh32_bad )
 {
-	log_cb(RETRO_LOG_DEBUG, LOGPRE "cpu #%d (PC=%08X): unmapped port dword write to %08X = %08X & %08X\n", cpu_getactivecpu(), activecpu_get_pc(), offset*4, data, mem_mask ^ 0xffffffff);
+	log_trace(MEMORY, (RETRO_LOG_DEBUG, LOGPRE "cpu #%d (PC=%08X): unmapped port dword write to %08X = %08X & %08X\n", cpu_getactivecpu(), activecpu_get_pc(), offset*4, data, mem_mask ^ 0xffffffff));
 }
 
 static WRITE_HANDLER( mwh8_rom )
 { 
-  log_cb(RETRO_LOG_DEBUG, LOGPRE "cpu #%d (PC=%08X): byte write to ROM %08X = %02X\n", cpu_getactivecpu(), activecpu_get_pc(), effective_offset(offset), data); 
+  log_trace(MEMORY, (RETRO_LOG_DEBUG, LOGPRE "cpu #%d (PC=%08X): byte write to ROM %08X = %02X\n", cpu_getactivecpu(), activecpu_get_pc(), effective_offset(offset), data)); 
 }
 
 static WRITE16_HANDLER( mwh16_rom )
 {
-  log_cb(RETRO_LOG_DEBUG, LOGPRE "cpu #%d (PC=%08X): word write to %08X = %04X & %04X\n", cpu_getactivecpu(), activecpu_get_pc(), effective_offset(offset*2), data, mem_mask ^ 0xffff);
+  log_trace(MEMORY, (RETRO_LOG_DEBUG, LOGPRE "cpu #%d (PC=%08X): word write to %08X = %04X & %04X\n", cpu_getactivecpu(), activecpu_get_pc(), effective_offset(offset*2), data, mem_mask ^ 0xffff));
 }
 
 static WRITE32_HANDLER( mwh32_rom )
 {
-  log_cb(RETRO_LOG_DEBUG, LOGPRE "cpu #%d (PC=%08X): dword write to %08X = %08X & %08X\n", cpu_getactivecpu(), activecpu_get_pc(), effective_offset(offset*4), data, mem_mask ^ 0xffffffff);
+  log_trace(MEMORY, (RETRO_LOG_DEBUG, LOGPRE "cpu #%d (PC=%08X): dword write to %08X = %08X & %08X\n", cpu_getactivecpu(), activecpu_get_pc(), effective_offset(offset*4), data, mem_mask ^ 0xffffffff));
 }
 
 static READ_HANDLER( mrh8_nop )        { return 0; }
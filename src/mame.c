@@ -104,6 +104,7 @@
 #include <ctype.h>
 #include <stdarg.h>
 #include <file/file_path.h>
+#include <compat/zlib.h>
 #include "ui_text.h"
 #include "mamedbg.h"
 #include "artwork.h"
@@ -112,9 +113,11 @@
 #include "vidhrdw/vector.h"
 #include "palette.h"
 #include "harddisk.h"
+#include "unzip.h"
 #include "driver.h"
 #include "mame.h"
 #include "bootstrap.h"
+#include "libretro_perf.h"
 
 /***************************************************************************
 
@@ -521,6 +524,9 @@ void pause_action_start_emulator(void)
         mame_fclose(nvram_file);
   }
 
+  /* loading is done, don't hold on to the archives */
+  unzip_cache_suspend();
+
   /* run the emulation! */
   cpu_run();
 
@@ -578,6 +584,9 @@ static void shutdown_machine(void)
 
 	/* reset the saved states */
 	state_save_reset();
+
+	/* forget the archives of this game */
+	unzip_cache_clear();
 }
 
 /*-------------------------------------------------
@@ -855,12 +864,284 @@ static void init_game_options(void)
 
 
 
+/*-------------------------------------------------
+	gfx cache - with the gfx cache option on,
+	decoded elements are written to the save
+	folder, and later launches map them back in
+	rather than decoding again. A cached set is
+	only used if the layout and the source data
+	hash the same as when it was written.
+-------------------------------------------------*/
+
+#define GFX_CACHE_MAGIC		0x58464743	/* "CGFX" */
+#define GFX_CACHE_VERSION	3			/* bump whenever decodegfx() or the file layout changes */
+#define GFX_CACHE_ALIGN		0x10000		/* pixel data alignment, a multiple of any page size */
+#define GFX_CACHE_MIN		0x10000		/* smaller sets decode quicker than the file opens */
+
+struct gfx_cache_header
+{
+	UINT32 magic;
+	UINT32 version;
+	UINT32 layout_crc;			/* the layout, with fractions resolved */
+	UINT32 data_crc;			/* the source, from the start of the decode to the end of the region */
+	UINT32 data_length;
+	UINT32 total_elements;
+	UINT32 line_modulo;
+	UINT32 char_modulo;
+	UINT32 flags;
+	UINT32 pen_usage;			/* !=0 if total_elements pen usage words follow */
+	UINT32 data_offset;			/* pixels, on the first GFX_CACHE_ALIGN boundary after the pen usage */
+};
+
+
+static UINT64 gfx_cache_data_start(UINT32 total_elements, int pen_usage)
+{
+	return sizeof(struct gfx_cache_header) + (pen_usage ? (UINT64)total_elements * sizeof(UINT32) : 0);
+}
+
+
+static void gfx_cache_key(struct gfx_cache_header *key, const struct GfxLayout *gl, int packed, const UINT8 *src, UINT32 length)
+{
+	UINT32 crc = 0;
+
+	memset(key, 0, sizeof(*key));
+	key->magic = GFX_CACHE_MAGIC;
+	key->version = GFX_CACHE_VERSION;
+
+	/* field by field, so padding doesn't count */
+	crc = crc32(crc, (const Bytef *)&gl->width, sizeof(gl->width));
+	crc = crc32(crc, (const Bytef *)&gl->height, sizeof(gl->height));
+	crc = crc32(crc, (const Bytef *)&gl->total, sizeof(gl->total));
+	crc = crc32(crc, (const Bytef *)&gl->planes, sizeof(gl->planes));
+	crc = crc32(crc, (const Bytef *)gl->planeoffset, sizeof(gl->planeoffset));
+	crc = crc32(crc, (const Bytef *)gl->xoffset, sizeof(gl->xoffset));
+	crc = crc32(crc, (const Bytef *)gl->yoffset, sizeof(gl->yoffset));
+	crc = crc32(crc, (const Bytef *)&gl->charincrement, sizeof(gl->charincrement));
+	crc = crc32(crc, (const Bytef *)&packed, sizeof(packed));
+	key->layout_crc = crc;
+
+	key->data_crc = crc32(0, src, length);
+	key->data_length = length;
+	key->total_elements = gl->total;
+}
+
+
+static struct GfxElement *gfx_cache_load(const char *name, const struct gfx_cache_header *key, const struct GfxLayout *gl)
+{
+	struct gfx_cache_header header;
+	struct GfxElement *gfx;
+	UINT64 data_size;
+	FILE *file;
+
+	file = osd_fopen(FILETYPE_GFX_CACHE, 0, name, "rb");
+	if (!file)
+		return NULL;
+
+	/* it has to be for this layout and data, and complete */
+	if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != key->magic || header.version != key->version ||
+			header.layout_crc != key->layout_crc || header.data_crc != key->data_crc ||
+			header.data_length != key->data_length || header.total_elements != key->total_elements)
+	{
+		fclose(file);
+		return NULL;
+	}
+	data_size = (UINT64)header.total_elements * header.char_modulo;
+	if ((header.data_offset & (GFX_CACHE_ALIGN - 1)) != 0 ||
+			header.data_offset < gfx_cache_data_start(header.total_elements, header.pen_usage) ||
+			fseek(file, 0, SEEK_END) != 0 || ftell(file) < header.data_offset + data_size)
+	{
+		fclose(file);
+		return NULL;
+	}
+
+	gfx = calloc(1, sizeof(*gfx));
+	if (!gfx)
+	{
+		fclose(file);
+		return NULL;
+	}
+	gfx->width = gl->width;
+	gfx->height = gl->height;
+	gfx->total_elements = header.total_elements;
+	gfx->color_granularity = 1 << gl->planes;
+	gfx->line_modulo = header.line_modulo;
+	gfx->char_modulo = header.char_modulo;
+	gfx->flags = header.flags;
+
+	if (header.pen_usage)
+	{
+		gfx->pen_usage = malloc(header.total_elements * sizeof(gfx->pen_usage[0]));
+		if (!gfx->pen_usage || fseek(file, sizeof(header), SEEK_SET) != 0 ||
+				fread(gfx->pen_usage, sizeof(gfx->pen_usage[0]), header.total_elements, file) != header.total_elements)
+		{
+			free(gfx->pen_usage);
+			free(gfx);
+			fclose(file);
+			return NULL;
+		}
+	}
+
+	/* map the pixels where we can, so they load on demand from the page cache */
+	gfx->gfxdata = osd_map_file(file, header.data_offset, data_size);
+	if (gfx->gfxdata)
+		gfx->flags |= GFX_MAPPED_GFXDATA;
+	else
+	{
+		gfx->gfxdata = malloc(data_size);
+		if (!gfx->gfxdata || fseek(file, header.data_offset, SEEK_SET) != 0 || fread(gfx->gfxdata, 1, data_size, file) != data_size)
+		{
+			free(gfx->gfxdata);
+			free(gfx->pen_usage);
+			free(gfx);
+			fclose(file);
+			return NULL;
+		}
+	}
+
+	fclose(file);
+	log_cb(RETRO_LOG_INFO, LOGPRE "Using cached gfx %s\n", name);
+	return gfx;
+}
+
+
+static void gfx_cache_save(const char *name, const struct gfx_cache_header *key, const struct GfxElement *gfx)
+{
+	struct gfx_cache_header header = *key;
+	UINT64 data_size = (UINT64)gfx->total_elements * gfx->char_modulo;
+	UINT64 data_offset;
+	FILE *file;
+	int ok;
+
+	/* pen usage grows with the set, so the pixels go after it, aligned for mapping */
+	data_offset = gfx_cache_data_start(gfx->total_elements, gfx->pen_usage != NULL);
+	data_offset = (data_offset + GFX_CACHE_ALIGN - 1) & ~(UINT64)(GFX_CACHE_ALIGN - 1);
+	if (data_offset > 0xffffffff)
+	{
+		log_cb(RETRO_LOG_WARN, LOGPRE "Gfx set too large to cache as %s\n", name);
+		return;
+	}
+
+	file = osd_fopen(FILETYPE_GFX_CACHE, 0, name, "wb");
+	if (!file)
+	{
+		log_cb(RETRO_LOG_WARN, LOGPRE "Unable to write gfx cache %s\n", name);
+		return;
+	}
+
+	header.line_modulo = gfx->line_modulo;
+	header.char_modulo = gfx->char_modulo;
+	header.flags = gfx->flags;
+	header.pen_usage = (gfx->pen_usage != NULL);
+	header.data_offset = (UINT32)data_offset;
+
+	/* the pixels go last, so a short write fails the size check on load */
+	ok = fwrite(&header, sizeof(header), 1, file) == 1;
+	if (ok && gfx->pen_usage)
+		ok = fwrite(gfx->pen_usage, sizeof(gfx->pen_usage[0]), gfx->total_elements, file) == gfx->total_elements;
+	if (ok)
+		ok = fseek(file, data_offset, SEEK_SET) == 0 && fwrite(gfx->gfxdata, 1, data_size, file) == data_size;
+	fclose(file);
+
+	if (!ok)
+		log_cb(RETRO_LOG_WARN, LOGPRE "Unable to write gfx cache %s\n", name);
+}
+
+
+struct GfxElement *gfx_cache_decode(const char *name, const UINT8 *src, UINT32 length, const struct GfxLayout *gl, int flags)
+{
+	struct gfx_cache_header key;
+	struct GfxElement *gfx;
+
+	gfx_cache_key(&key, gl, (flags & DECODEGFX_PACKED) ? 1 : 0, src, length);
+	gfx = gfx_cache_load(name, &key, gl);
+	if (!gfx && (gfx = decodegfx_ex(src, gl, flags)) != NULL)
+		gfx_cache_save(name, &key, gfx);
+	return gfx;
+}
+
+
+
+/*-------------------------------------------------
+	gfx_can_pack - with the packed gfx option on,
+	4bpp sets are decoded two pixels to a byte,
+	except for drivers whose video code reads the
+	decoded pixels itself a byte at a time
+-------------------------------------------------*/
+
+static const char *gfx_unpacked_sources[] =
+{
+	"atarig1.c", "atarig42.c", "atarigt.c", "atarigx2.c", "bbusters.c",
+	"bishi.c", "boogwing.c", "buggychl.c", "bwing.c", "circus.c",
+	"dassault.c", "deco32.c", "deco_mlc.c", "djmain.c", "gaelco2.c",
+	"gijoe.c", "konamigx.c", "lethal.c", "mcr1.c", "mcr2.c",
+	"mcr68.c", "moo.c", "ms32.c", "mystwarr.c", "namcona1.c",
+	"namcos1.c", "namcos2.c", "namcos22.c", "playch10.c", "polepos.c",
+	"psikyosh.c", "relief.c", "rohga.c", "ssv.c", "system32.c",
+	"taito_f2.c", "taito_f3.c", "vmetal.c", "vsnes.c", "wecleman.c",
+	"xexex.c",
+	NULL
+};
+
+static int gfx_source_listed(const char **list)
+{
+	const char *source = Machine->gamedrv->source_file;
+	const char *slash = strrchr(source, '/');
+	int i;
+
+	if (slash)
+		source = slash + 1;
+	if ((slash = strrchr(source, '\\')) != NULL)
+		source = slash + 1;
+
+	for (i = 0; list[i]; i++)
+		if (!strcmp(source, list[i]))
+			return 1;
+	return 0;
+}
+
+static int gfx_can_pack(void)
+{
+	return options.gfx_packed && !gfx_source_listed(gfx_unpacked_sources);
+}
+
+
+
+/*-------------------------------------------------
+	gfx_can_defer - with the lazy gfx option on,
+	sets are decoded an element at a time the
+	first time each one is drawn. That also rules
+	out drivers that read the decoded pixels, and
+	those reading pen_usage directly.
+-------------------------------------------------*/
+
+static const char *gfx_eager_sources[] =
+{
+	"system1.c", "thepit.c", "bwing.c",
+	NULL
+};
+
+static int gfx_can_defer(int region)
+{
+	if (!options.gfx_lazy || options.gfx_cache)
+		return 0;
+
+	/* the source has to stay put until the set is freed */
+	if (region < REGION_GFX1 || region > REGION_GFX8)
+		return 0;
+
+	return !gfx_source_listed(gfx_unpacked_sources) && !gfx_source_listed(gfx_eager_sources);
+}
+
+
+
 /*-------------------------------------------------
 	decode_graphics - decode the graphics
 -------------------------------------------------*/
 
 static int decode_graphics(const struct GfxDecodeInfo *gfxdecodeinfo)
 {
+	int packed = gfx_can_pack();
+	int decode_flags;
 	int i;
 
 	/* loop over all elements */
@@ -915,8 +1196,30 @@ static int decode_graphics(const struct GfxDecodeInfo *gfxdecodeinfo)
 			}
 		}
 
-		/* now decode the actual graphics */
-		if ((Machine->gfx[i] = decodegfx(region_base + gfxdecodeinfo[i].start, &glcopy)) == 0)
+		/* sets decoded on demand keep their source region */
+		decode_flags = packed ? DECODEGFX_PACKED : 0;
+		if (region_base && gfx_can_defer(gfxdecodeinfo[i].memory_region))
+		{
+			decode_flags |= DECODEGFX_LAZY;
+			for (j = 0; j < MAX_MEMORY_REGIONS; j++)
+				if (Machine->memory_region[j].type == gfxdecodeinfo[i].memory_region)
+					Machine->memory_region[j].flags &= ~ROMREGION_DISPOSE;
+		}
+
+		/* now decode the actual graphics, or take them from the cache */
+		Machine->gfx[i] = NULL;
+		if (options.gfx_cache && glcopy.planeoffset[0] != GFX_RAW && gfxdecodeinfo[i].start < region_length/8 &&
+				(UINT64)glcopy.total * glcopy.width * glcopy.height >= GFX_CACHE_MIN)
+		{
+			char name[64];
+
+			snprintf(name, sizeof(name), "%s_%d.gfx", Machine->gamedrv->name, i);
+			Machine->gfx[i] = gfx_cache_decode(name, region_base + gfxdecodeinfo[i].start, region_length/8 - gfxdecodeinfo[i].start, &glcopy, decode_flags);
+		}
+		else
+			Machine->gfx[i] = decodegfx_ex(region_base + gfxdecodeinfo[i].start, &glcopy, decode_flags);
+
+		if (Machine->gfx[i] == 0)
 		{
 			bailing = 1;
 			log_cb(RETRO_LOG_ERROR, LOGPRE "Out of memory decoding gfx\n");
@@ -1217,14 +1520,21 @@ void update_video_and_audio(void)
 
 int updatescreen(void)
 {
+	RETRO_PERFORMANCE_INIT(perf_cb, update_sound);
+	RETRO_PERFORMANCE_INIT(perf_cb, render_screen);
+
 	/* update sound */
+	RETRO_PERFORMANCE_START(perf_cb, update_sound);
 	sound_update();
+	RETRO_PERFORMANCE_STOP(perf_cb, update_sound);
 
 	/* if we're not skipping this frame, draw the screen */
 	if (osd_skip_this_frame() == 0)
 	{
 		profiler_mark(PROFILER_VIDEO);
+		RETRO_PERFORMANCE_START(perf_cb, render_screen);
 		draw_screen();
+		RETRO_PERFORMANCE_STOP(perf_cb, render_screen);
 		profiler_mark(PROFILER_END);
 	}
 
@@ -260,6 +260,10 @@ struct GameOptions
   bool     cheat_input_ports;     /*cheat input ports enable/disable */
   bool     machine_timing;
   bool     digital_joy_centering; /* center digital joysticks enable/disable */
+  int      profiler;             /* one of the PROFILER_MODE_* values */
+  bool     gfx_cache;            /* keep decoded gfx in the save folder for the next launch */
+  bool     gfx_packed;           /* store 4bpp gfx two pixels to a byte */
+  bool     gfx_lazy;             /* decode gfx elements the first time they are drawn */
   };
 
 
@@ -390,4 +394,8 @@ const struct performance_info *mame_get_performance_info(void);
 /* return the index of the given CPU, or -1 if not found */
 int mame_find_cpu_index(const char *tag);
 
+/* decode a gfx set, or map it from the named gfx cache file written by an earlier decode */
+struct GfxLayout;
+struct GfxElement *gfx_cache_decode(const char *name, const UINT8 *src, UINT32 length, const struct GfxLayout *gl, int flags);
+
 #endif
@@ -0,0 +1,1210 @@
+/*********************************************************************
+
+	bench.c
+
+	Headless benchmark harness for the mame2003-plus libretro core.
+
+	Acts as a minimal libretro frontend: the core objects are linked
+	straight into the executable, a single romset is loaded through
+	retro_load_game() and retro_run() is driven for a fixed number of
+	frames with no-op video, audio and input callbacks.
+
+	Build with "make bench" (unix only), then for example:
+
+	  mame2003_plus_bench -f 3000 -w 300 /path/to/roms/pacman.zip
+
+	One romset is benchmarked per process, since the core keeps its
+	machine state in globals. Nightly runs over every driver should
+	loop over romsets from a shell script and collect the -c output.
+
+	-p turns on the core's profiler and sums its per-frame sections
+	over the timed frames, so the breakdown needs no special build.
+
+	-t runs a scheduler microbenchmark instead of a romset: it times
+	timer_adjust() (insert) and timer firing for growing numbers of
+	live timers, without bringing up a machine.
+
+	-V likewise times the output bitmap conversion on a synthetic frame
+	for every conversion type and orientation, C against SIMD kernels.
+
+	-G times decodegfx() over the gfx layouts of every parent driver,
+	against decoding one element at a time with decodechar().
+
+*********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+
+#include <libretro.h>
+
+#include "osd_cpu.h"
+#include "profiler.h"
+#include "timer.h"
+#include "cpuintrf.h"
+#include "state.h"
+#include "driver.h"
+#include "mame2003.h"
+
+#define BENCH_MAX_OPTIONS   128
+#define BENCH_MAX_COUNTERS  64
+
+
+/******************************************************************************
+
+	harness state
+
+******************************************************************************/
+
+struct bench_option
+{
+  char key[128];
+  char value[128];
+  int  overridden;  /* set from the command line; the core default is ignored */
+};
+
+static struct bench_option core_options[BENCH_MAX_OPTIONS];
+static int                 option_count;
+
+static const char *system_dir;
+static const char *save_dir;
+static int         verbose;
+
+/* what the core handed to the frontend while timing */
+static unsigned     video_frames;
+static unsigned     video_dupes;
+static size_t       audio_frames;
+
+/* what GET_AUDIO_VIDEO_ENABLE reports; -A changes it per frame */
+static int          av_enable = 3;
+
+/* FNV-1a over everything presented while timing, with -H */
+static int          hash_output;
+static UINT32       video_hash = 2166136261u;
+static UINT32       audio_hash = 2166136261u;
+static unsigned     pixel_bytes = 2;
+
+/* counters registered by the core through the perf interface; these only
+   exist when the core objects were built with LOG_PERFORMANCE=1 */
+static struct retro_perf_counter *counters[BENCH_MAX_COUNTERS];
+static int                        counter_count;
+
+/* profiler sections summed over the timed frames, with -p */
+static UINT64 profile_count[PROFILER_TOTAL];
+static UINT64 profile_total;
+static UINT64 profile_switches;
+
+
+/******************************************************************************
+
+	timing
+
+******************************************************************************/
+
+static retro_time_t bench_get_time_usec(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (retro_time_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/* the perf interface counts in microseconds rather than cycles; good enough for
+   per-frame sums and it keeps the harness free of architecture specific code */
+static retro_perf_tick_t bench_get_perf_counter(void)
+{
+  return (retro_perf_tick_t)bench_get_time_usec();
+}
+
+static uint64_t bench_get_cpu_features(void)
+{
+  return 0;
+}
+
+static void bench_perf_register(struct retro_perf_counter *counter)
+{
+  if (counter->registered || counter_count >= BENCH_MAX_COUNTERS)
+    return;
+  counters[counter_count++] = counter;
+  counter->registered = true;
+}
+
+static void bench_perf_start(struct retro_perf_counter *counter)
+{
+  counter->call_cnt++;
+  counter->start = bench_get_perf_counter();
+}
+
+static void bench_perf_stop(struct retro_perf_counter *counter)
+{
+  counter->total += bench_get_perf_counter() - counter->start;
+}
+
+static void bench_perf_log(void)
+{
+}
+
+static void bench_profile_frame(void)
+{
+  const struct profiler_frame *pf = profiler_get_frame(0);
+  int i;
+
+  if (!pf)
+    return;
+  for (i = 0; i < PROFILER_TOTAL; i++)
+    profile_count[i] += pf->count[i];
+  profile_total    += pf->total;
+  profile_switches += pf->context_switches;
+}
+
+static void bench_perf_reset(void)
+{
+  int i;
+  for (i = 0; i < counter_count; i++)
+  {
+    counters[i]->total    = 0;
+    counters[i]->call_cnt = 0;
+  }
+}
+
+
+/******************************************************************************
+
+	core options
+
+	Defaults are taken from the first value of each RETRO_ENVIRONMENT_SET_VARIABLES
+	entry, the same way a real frontend does; -o key=value overrides them.
+
+******************************************************************************/
+
+static struct bench_option *bench_find_option(const char *key)
+{
+  int i;
+  for (i = 0; i < option_count; i++)
+    if (strcmp(core_options[i].key, key) == 0)
+      return &core_options[i];
+  return NULL;
+}
+
+static struct bench_option *bench_add_option(const char *key)
+{
+  struct bench_option *opt = bench_find_option(key);
+
+  if (!opt && option_count < BENCH_MAX_OPTIONS)
+  {
+    opt = &core_options[option_count++];
+    memset(opt, 0, sizeof(*opt));
+    snprintf(opt->key, sizeof(opt->key), "%s", key);
+  }
+  return opt;
+}
+
+static void bench_set_override(const char *key, const char *value)
+{
+  struct bench_option *opt = bench_add_option(key);
+
+  if (!opt)
+    return;
+  snprintf(opt->value, sizeof(opt->value), "%s", value);
+  opt->overridden = 1;
+}
+
+static void bench_set_defaults(const struct retro_variable *vars)
+{
+  for ( ; vars->key; vars++)
+  {
+    struct bench_option *opt = bench_add_option(vars->key);
+    const char *first = vars->value ? strstr(vars->value, "; ") : NULL;
+    size_t len;
+
+    if (!opt || opt->overridden || !first)
+      continue;
+
+    first += 2;
+    len = strcspn(first, "|");
+    if (len >= sizeof(opt->value))
+      len = sizeof(opt->value) - 1;
+    memcpy(opt->value, first, len);
+    opt->value[len] = 0;
+  }
+}
+
+
+/******************************************************************************
+
+	frontend callbacks
+
+******************************************************************************/
+
+static void bench_log(enum retro_log_level level, const char *fmt, ...)
+{
+  va_list args;
+
+  if (!verbose && level < RETRO_LOG_WARN)
+    return;
+
+  va_start(args, fmt);
+  vfprintf(stderr, fmt, args);
+  va_end(args);
+}
+
+static bool bench_environment(unsigned cmd, void *data)
+{
+  switch (cmd)
+  {
+    case RETRO_ENVIRONMENT_GET_LOG_INTERFACE:
+      ((struct retro_log_callback *)data)->log = bench_log;
+      return true;
+
+    case RETRO_ENVIRONMENT_GET_PERF_INTERFACE:
+    {
+      struct retro_perf_callback *perf = (struct retro_perf_callback *)data;
+      perf->get_time_usec    = bench_get_time_usec;
+      perf->get_cpu_features = bench_get_cpu_features;
+      perf->get_perf_counter = bench_get_perf_counter;
+      perf->perf_register    = bench_perf_register;
+      perf->perf_start       = bench_perf_start;
+      perf->perf_stop        = bench_perf_stop;
+      perf->perf_log         = bench_perf_log;
+      return true;
+    }
+
+    case RETRO_ENVIRONMENT_GET_SYSTEM_DIRECTORY:
+      *(const char **)data = system_dir;
+      return true;
+
+    case RETRO_ENVIRONMENT_GET_SAVE_DIRECTORY:
+      *(const char **)data = save_dir;
+      return true;
+
+    case RETRO_ENVIRONMENT_SET_VARIABLES:
+      bench_set_defaults((const struct retro_variable *)data);
+      return true;
+
+    case RETRO_ENVIRONMENT_GET_VARIABLE:
+    {
+      struct retro_variable *var = (struct retro_variable *)data;
+      struct bench_option *opt = bench_find_option(var->key);
+      var->value = (opt && opt->value[0]) ? opt->value : NULL;
+      return var->value != NULL;
+    }
+
+    case RETRO_ENVIRONMENT_GET_VARIABLE_UPDATE:
+      *(bool *)data = false;
+      return true;
+
+    case RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE:
+      *(int *)data = av_enable;
+      return true;
+
+    case RETRO_ENVIRONMENT_SET_MESSAGE:
+      if (verbose)
+        fprintf(stderr, "message: %s\n", ((const struct retro_message *)data)->msg);
+      return true;
+
+    case RETRO_ENVIRONMENT_SET_PIXEL_FORMAT:
+      pixel_bytes = (*(const enum retro_pixel_format *)data == RETRO_PIXEL_FORMAT_XRGB8888) ? 4 : 2;
+      return true;
+
+    case RETRO_ENVIRONMENT_SET_ROTATION:
+    case RETRO_ENVIRONMENT_SET_GEOMETRY:
+    case RETRO_ENVIRONMENT_SET_INPUT_DESCRIPTORS:
+    case RETRO_ENVIRONMENT_SET_CONTROLLER_INFO:
+    case RETRO_ENVIRONMENT_SET_PERFORMANCE_LEVEL:
+      return true;
+
+    default:
+      return false;
+  }
+}
+
+static UINT32 bench_hash(UINT32 hash, const void *data, size_t length)
+{
+  const UINT8 *bytes = (const UINT8 *)data;
+  while (length--)
+    hash = (hash ^ *bytes++) * 16777619u;
+  return hash;
+}
+
+static void bench_video_refresh(const void *data, unsigned width, unsigned height, size_t pitch)
+{
+  unsigned y;
+
+  video_frames++;
+  if (!data)
+  {
+    video_dupes++;
+    return;
+  }
+  if (hash_output)
+    for (y = 0; y < height; y++)
+      video_hash = bench_hash(video_hash, (const UINT8 *)data + y * pitch, width * pixel_bytes);
+}
+
+static size_t bench_audio_sample_batch(const int16_t *data, size_t frames)
+{
+  audio_frames += frames;
+  if (hash_output)
+    audio_hash = bench_hash(audio_hash, data, frames * 2 * sizeof(*data));
+  return frames;
+}
+
+static void bench_audio_sample(int16_t left, int16_t right)
+{
+}
+
+static void bench_input_poll(void)
+{
+}
+
+static int16_t bench_input_state(unsigned port, unsigned device, unsigned index, unsigned id)
+{
+  return 0;
+}
+
+
+/******************************************************************************
+
+	rewind
+
+	With -R, a delta save is taken after every timed frame and the last
+	<depth> deltas are kept, the way a frontend's rewind buffer would.
+	Afterwards the snapshot is stepped back through all of them, compared
+	with a full save taken at that frame, and loaded.
+
+******************************************************************************/
+
+static unsigned     rewind_depth;
+static size_t       rewind_image_size;
+static UINT8       *rewind_snapshot;
+static UINT8       *rewind_check;
+static UINT8       *rewind_scratch;
+static UINT8      **rewind_deltas;
+static size_t      *rewind_sizes;
+static unsigned     rewind_count;
+static unsigned     rewind_check_at;
+static UINT64       rewind_bytes;
+static retro_time_t rewind_usec;
+
+static int bench_rewind_start(unsigned frames)
+{
+  size_t delta_size;
+
+  /* stepping back over the whole ring lands <depth> frames from the end */
+  if (rewind_depth > frames)
+    rewind_depth = frames;
+  rewind_check_at = frames - rewind_depth;
+
+  rewind_image_size = retro_serialize_size();
+  if (!rewind_image_size)
+    return 0;
+
+  rewind_snapshot = calloc(1, rewind_image_size);
+  rewind_check = malloc(rewind_image_size);
+  rewind_scratch = malloc(state_delta_max_size());
+  rewind_deltas = calloc(rewind_depth, sizeof(*rewind_deltas));
+  rewind_sizes = calloc(rewind_depth, sizeof(*rewind_sizes));
+  if (!rewind_snapshot || !rewind_check || !rewind_scratch || !rewind_deltas || !rewind_sizes)
+    return 0;
+
+  /* the first delta is against nothing, so it isn't counted */
+  if (!mame2003_serialize_delta(rewind_snapshot, rewind_scratch, &delta_size))
+    return 0;
+  if (rewind_check_at == 0)
+    memcpy(rewind_check, rewind_snapshot, rewind_image_size);
+  return 1;
+}
+
+static void bench_rewind_capture(void)
+{
+  unsigned slot = rewind_count % rewind_depth;
+  retro_time_t start = bench_get_time_usec();
+  size_t size;
+
+  if (!mame2003_serialize_delta(rewind_snapshot, rewind_scratch, &size))
+    return;
+  free(rewind_deltas[slot]);
+  rewind_deltas[slot] = malloc(size ? size : 1);
+  memcpy(rewind_deltas[slot], rewind_scratch, size);
+  rewind_sizes[slot] = size;
+  rewind_usec += bench_get_time_usec() - start;
+  rewind_bytes += size;
+  rewind_count++;
+
+  if (rewind_count == rewind_check_at)
+    memcpy(rewind_check, rewind_snapshot, rewind_image_size);
+}
+
+/* returns the cost of a full save in usec, and whether stepping back worked */
+static int bench_rewind_finish(double *full_usec)
+{
+  retro_time_t start;
+  unsigned i;
+  int ok = 1;
+
+  start = bench_get_time_usec();
+  for (i = 0; i < 100; i++)
+    retro_serialize(rewind_scratch, rewind_image_size);
+  *full_usec = (bench_get_time_usec() - start) / 100.0;
+
+  for (i = 0; i < rewind_depth; i++)
+  {
+    unsigned slot = (rewind_count - 1 - i) % rewind_depth;
+    if (state_delta_apply(rewind_snapshot, rewind_image_size, rewind_deltas[slot], rewind_sizes[slot]))
+      ok = 0;
+  }
+  if (memcmp(rewind_snapshot, rewind_check, rewind_image_size) != 0)
+    ok = 0;
+  if (ok && !retro_unserialize(rewind_snapshot, rewind_image_size))
+    ok = 0;
+
+  for (i = 0; i < rewind_depth; i++)
+    free(rewind_deltas[i]);
+  free(rewind_deltas);
+  free(rewind_sizes);
+  free(rewind_scratch);
+  free(rewind_check);
+  free(rewind_snapshot);
+  return ok;
+}
+
+
+
+
+/******************************************************************************
+
+	run-ahead
+
+	With -A <frames>, each timed frame is run the way a frontend does
+	single instance run-ahead: the real frame with video off, a fast
+	save, <frames> frames ahead with audio off and only the last one
+	shown, then a fast load back to the real frame.
+
+******************************************************************************/
+
+#define BENCH_AV_VIDEO            1
+#define BENCH_AV_AUDIO            2
+#define BENCH_AV_FAST_SAVESTATES  4
+
+static unsigned runahead;
+static size_t   runahead_size;
+static void    *runahead_state;
+
+static int bench_runahead_start(void)
+{
+  runahead_size = retro_serialize_size();
+  if (!runahead_size)
+    return 0;
+  runahead_state = malloc(runahead_size);
+  return runahead_state != NULL;
+}
+
+static void bench_runahead_frame(void)
+{
+  unsigned i;
+
+  av_enable = BENCH_AV_AUDIO | BENCH_AV_FAST_SAVESTATES;
+  retro_run();
+  retro_serialize(runahead_state, runahead_size);
+
+  for (i = 1; i <= runahead; i++)
+  {
+    av_enable = BENCH_AV_FAST_SAVESTATES | (i == runahead ? BENCH_AV_VIDEO : 0);
+    retro_run();
+  }
+
+  av_enable = BENCH_AV_FAST_SAVESTATES;
+  retro_unserialize(runahead_state, runahead_size);
+  av_enable = BENCH_AV_VIDEO | BENCH_AV_AUDIO;
+}
+
+
+/******************************************************************************
+
+	timer microbenchmark
+
+	Nothing is executing, so relative times are taken from 0 and every
+	adjust lands in the scheduler's insert path; firing is driven through
+	mame_timer_set_global_time() the same way cpu_timeslice() does.
+
+******************************************************************************/
+
+#define BENCH_TIMER_ADJUSTS 1000000
+#define BENCH_TIMER_SLICES  20000
+
+static unsigned bench_timers_fired;
+
+static void bench_timer_callback(int param)
+{
+  bench_timers_fired++;
+}
+
+static void bench_timers(void)
+{
+  static const int counts[] = { 8, 32, 128, 256, 1024, 4096 };
+  static mame_timer *timers[4096];
+  unsigned seed;
+  int c, i, n;
+
+  /* no CPUs, so nothing is active or executing */
+  cpuintrf_init();
+
+  printf("%8s %16s %16s %12s\n", "timers", "adjust ns/call", "fire ns/timer", "fired");
+
+  for (c = 0; c < (int)(sizeof(counts) / sizeof(counts[0])); c++)
+  {
+    retro_time_t start, adjust_usec, fire_usec;
+    mame_time slice, now;
+
+    double_to_mame_time(TIME_IN_USEC(100), &slice);
+
+    timer_init();
+    for (n = 0; n < counts[c]; n++)
+      if ((timers[n] = timer_alloc(bench_timer_callback)) == NULL)
+        break;
+    if (n < counts[c])
+    {
+      printf("%8d %16s %16s %12s\n", counts[c], "n/a", "n/a", "n/a");
+      continue;
+    }
+
+    /* reschedule random timers to random points in the next 10ms */
+    seed = 1;
+    start = bench_get_time_usec();
+    for (i = 0; i < BENCH_TIMER_ADJUSTS; i++)
+    {
+      seed = seed * 1103515245 + 12345;
+      timer_adjust(timers[(seed >> 8) % n], TIME_IN_USEC(1 + (seed >> 16) % 10000), 0, 0);
+    }
+    adjust_usec = bench_get_time_usec() - start;
+
+    /* turn them all into pulses and advance time in 100us slices */
+    for (i = 0; i < n; i++)
+    {
+      seed = seed * 1103515245 + 12345;
+      timer_adjust(timers[i], TIME_IN_USEC(10 + (seed >> 16) % 10000), 0, TIME_IN_USEC(10 + (seed >> 16) % 10000));
+    }
+    bench_timers_fired = 0;
+    start = bench_get_time_usec();
+    for (i = 0; i < BENCH_TIMER_SLICES; i++)
+    {
+      mame_timer_get_time(&now);
+      mame_timer_set_global_time(add_mame_times(now, slice));
+    }
+    fire_usec = bench_get_time_usec() - start;
+
+    printf("%8d %16.1f %16.1f %12u\n", n, adjust_usec * 1000.0 / BENCH_TIMER_ADJUSTS,
+           bench_timers_fired ? fire_usec * 1000.0 / bench_timers_fired : 0.0, bench_timers_fired);
+  }
+}
+
+/******************************************************************************
+
+	video conversion microbenchmark
+
+	Converts a synthetic frame with every output conversion type in all
+	eight orientations, once with the plain C kernels and once with the
+	SIMD ones picked for this CPU. Both outputs are checked against a
+	pixel at a time reference conversion.
+
+******************************************************************************/
+
+#define BENCH_VIDEO_WIDTH   320
+#define BENCH_VIDEO_HEIGHT  256
+#define BENCH_VIDEO_FRAMES  2000
+
+static UINT32 bench_palette[4096];
+
+/* the straightforward conversion: output pixel (col, row) from the input */
+static void bench_video_reference(const struct mame_display *display, void *dest)
+{
+  const struct rectangle *area = &display->game_visible_area;
+  int w = area->max_x - area->min_x + 1, h = area->max_y - area->min_y + 1;
+  int out_w = video_swap_xy ? h : w, out_h = video_swap_xy ? w : h;
+  int row, col;
+
+  for (row = 0; row < out_h; row++)
+    for (col = 0; col < out_w; col++)
+    {
+      int x = video_swap_xy ? row : col, y = video_swap_xy ? col : row;
+      int i = row * out_w + col;
+      int src;
+      UINT32 color;
+
+      /* an XY swap trades the flips too, as in reverse_orientation() */
+      if (video_swap_xy ? video_flip_y : video_flip_x)
+        x = w - 1 - x;
+      if (video_swap_xy ? video_flip_x : video_flip_y)
+        y = h - 1 - y;
+      src = (area->min_y + y) * display->game_bitmap->rowpixels + area->min_x + x;
+
+      switch (video_conversion_type)
+      {
+        case VCT_PASS8888:
+          ((UINT32 *)dest)[i] = ((const UINT32 *)display->game_bitmap->base)[src];
+          break;
+        case VCT_PASS1555:
+          ((UINT16 *)dest)[i] = ((const UINT16 *)display->game_bitmap->base)[src];
+          break;
+        case VCT_PASSPAL:
+          ((UINT32 *)dest)[i] = video_palette[((const UINT16 *)display->game_bitmap->base)[src]];
+          break;
+        case VCT_PALTO565:
+          color = video_palette[((const UINT16 *)display->game_bitmap->base)[src]];
+          ((UINT16 *)dest)[i] = (color & 0x00F80000) >> 8 | (color & 0x0000FC00) >> 5 | (color & 0x000000F8) >> 3;
+          break;
+      }
+    }
+}
+
+static void bench_video(void)
+{
+  static const char *type_names[] = { "pass8888", "pass1555", "passpal", "palto565" };
+  static const unsigned stride_in[] = { 4, 2, 2, 2 };
+  static const unsigned stride_out[] = { 4, 2, 4, 2 };
+  struct mame_bitmap bitmap;
+  struct mame_display display;
+  size_t frame_bytes = BENCH_VIDEO_WIDTH * BENCH_VIDEO_HEIGHT * 4;
+  UINT8 *pixels = malloc(frame_bytes);
+  UINT8 *expected = malloc(frame_bytes);
+  unsigned seed = 1;
+  unsigned type, orientation, i;
+  int pixel_count;
+
+  video_buffer = malloc(frame_bytes);
+  if (!pixels || !expected || !video_buffer)
+    return;
+
+  /* 16-bit pixels index a 4096 entry palette, which is typical */
+  for (i = 0; i < frame_bytes; i++)
+  {
+    seed = seed * 1103515245 + 12345;
+    pixels[i] = (i & 1) ? (seed >> 16) & 0x0f : seed >> 16;
+  }
+  for (i = 0; i < 4096; i++)
+  {
+    seed = seed * 1103515245 + 12345;
+    bench_palette[i] = (seed >> 8) & 0xffffff;
+  }
+
+  /* a visible area inset into the bitmap, like most drivers have */
+  memset(&bitmap, 0, sizeof(bitmap));
+  memset(&display, 0, sizeof(display));
+  bitmap.width = BENCH_VIDEO_WIDTH;
+  bitmap.height = BENCH_VIDEO_HEIGHT;
+  bitmap.rowpixels = BENCH_VIDEO_WIDTH;
+  bitmap.base = pixels;
+  display.game_bitmap = &bitmap;
+  display.game_visible_area.min_x = 16;
+  display.game_visible_area.max_x = 16 + 288 - 1;
+  display.game_visible_area.min_y = 16;
+  display.game_visible_area.max_y = 16 + 224 - 1;
+  pixel_count = 288 * 224;
+  video_palette = bench_palette;
+
+  printf("%-10s %-12s %14s %14s %8s\n", "type", "orientation", "scalar ns/px", "simd ns/px", "check");
+
+  for (type = 0; type < 4; type++)
+    for (orientation = 0; orientation < 8; orientation++)
+    {
+      double ns[2];
+      int simd, ok = 1;
+      char name[16];
+
+      video_conversion_type = type;
+      video_stride_in = stride_in[type];
+      video_stride_out = stride_out[type];
+      video_flip_x = orientation & 1;
+      video_flip_y = (orientation >> 1) & 1;
+      video_swap_xy = (orientation >> 2) & 1;
+      bitmap.depth = (type == VCT_PASS8888) ? 32 : 16;
+
+      bench_video_reference(&display, expected);
+
+      for (simd = 0; simd < 2; simd++)
+      {
+        retro_time_t start;
+
+        mame2003_video_select_kernels(simd);
+        memset(video_buffer, 0, frame_bytes);
+        mame2003_video_frame_convert(&display);
+        if (memcmp(video_buffer, expected, pixel_count * stride_out[type]) != 0)
+          ok = 0;
+
+        start = bench_get_time_usec();
+        for (i = 0; i < BENCH_VIDEO_FRAMES; i++)
+          mame2003_video_frame_convert(&display);
+        ns[simd] = (bench_get_time_usec() - start) * 1000.0 / ((double)BENCH_VIDEO_FRAMES * pixel_count);
+      }
+
+      snprintf(name, sizeof(name), "%s%s%s", video_swap_xy ? "swap " : "",
+               video_flip_x ? "fx " : "", video_flip_y ? "fy" : "");
+      printf("%-10s %-12s %14.3f %14.3f %8s\n", type_names[type], orientation ? name : "none",
+             ns[0], ns[1], ok ? "ok" : "MISMATCH");
+    }
+
+  mame2003_video_select_kernels(true);
+  free(video_buffer);
+  video_buffer = NULL;
+  free(expected);
+  free(pixels);
+}
+
+
+
+/******************************************************************************
+
+	gfx decode microbenchmark
+
+	Decodes every layout of every parent driver from a region of random
+	data the size the driver declares, with decodegfx() and with the
+	element at a time decodechar() reference, and checks that pixels
+	and pen usage match. 4bpp layouts are decoded a second time packed,
+	and every set once more on demand, an element at a time from the
+	last one back, which has to give the same result.
+
+	With -S, sets of more than BENCH_GFX_CACHE_ELEMENTS elements are also
+	written to the gfx cache in the save directory and mapped back in;
+	their pen usage alone runs past the first 64K of the file.
+
+******************************************************************************/
+
+#define BENCH_GFX_MAX_REGION     0x400000
+#define BENCH_GFX_CACHE_ELEMENTS 16384
+
+static UINT8 *bench_gfx_region(const struct GameDriver *drv, int type, UINT32 *length)
+{
+  const struct RomModule *region;
+  UINT8 *data;
+  unsigned seed = 1;
+  UINT32 i;
+
+  for (region = rom_first_region(drv); region; region = rom_next_region(region))
+    if (ROMREGION_GETTYPE(region) == type)
+      break;
+  if (!region || ROMREGION_GETLENGTH(region) > BENCH_GFX_MAX_REGION)
+    return NULL;
+
+  /* twice the size, for the few layouts that read past the end of the */
+  /* region (cvs.c's RAM chars); both decoders must see the same data */
+  *length = ROMREGION_GETLENGTH(region);
+  data = malloc(2 * *length);
+  if (data)
+    for (i = 0; i < 2 * *length; i++)
+    {
+      seed = seed * 1103515245 + 12345;
+      data[i] = seed >> 16;
+    }
+  return data;
+}
+
+/* the layout as decode_graphics() adjusts it for the region */
+static void bench_gfx_layout(struct GfxLayout *gl, UINT32 region_length, UINT32 start)
+{
+  int bits = 8 * region_length;
+  int j;
+
+  if (IS_FRAC(gl->total))
+    gl->total = bits / gl->charincrement * FRAC_NUM(gl->total) / FRAC_DEN(gl->total);
+  for (j = 0; j < MAX_GFX_PLANES; j++)
+    if (IS_FRAC(gl->planeoffset[j]))
+      gl->planeoffset[j] = FRAC_OFFSET(gl->planeoffset[j]) + bits * FRAC_NUM(gl->planeoffset[j]) / FRAC_DEN(gl->planeoffset[j]);
+  for (j = 0; j < MAX_GFX_SIZE; j++)
+  {
+    if (IS_FRAC(gl->xoffset[j]))
+      gl->xoffset[j] = FRAC_OFFSET(gl->xoffset[j]) + bits * FRAC_NUM(gl->xoffset[j]) / FRAC_DEN(gl->xoffset[j]);
+    if (IS_FRAC(gl->yoffset[j]))
+      gl->yoffset[j] = FRAC_OFFSET(gl->yoffset[j]) + bits * FRAC_NUM(gl->yoffset[j]) / FRAC_DEN(gl->yoffset[j]);
+  }
+  if (gl->planeoffset[0] == GFX_RAW)
+    while (gl->total > 0 && start + (gl->total - 1) * gl->charincrement / 8 + gl->height * gl->yoffset[0] / 8 > region_length)
+      gl->total--;
+}
+
+static void bench_gfx(void)
+{
+  struct InternalMachineDriver drv;
+  UINT64 decoded_bytes = 0;
+  retro_time_t decode_usec = 0, reference_usec = 0;
+  int layouts = 0, mismatches = 0, skipped = 0, cached_sets = 0;
+  char cache_dir[PATH_MAX_LENGTH];
+  int d, i, packed;
+
+  /* machine driver expansion logs through the core */
+  retro_set_environment(bench_environment);
+  retro_init();
+
+  /* the gfx cache lives under the save directory, as it does for a game */
+  if (save_dir)
+  {
+    options.libretro_save_path = (char *)save_dir;
+    osd_get_path(FILETYPE_GFX_CACHE, cache_dir);
+  }
+
+  for (d = 0; drivers[d]; d++)
+  {
+    const struct GameDriver *game = drivers[d];
+
+    if (game->clone_of && !(game->clone_of->flags & NOT_A_DRIVER))
+      continue;
+
+    memset(&drv, 0, sizeof(drv));
+    expand_machine_driver(game->drv, &drv);
+    if (!drv.gfxdecodeinfo)
+      continue;
+
+    for (i = 0; i < MAX_GFX_ELEMENTS && drv.gfxdecodeinfo[i].memory_region != -1; i++)
+    {
+      const struct GfxDecodeInfo *info = &drv.gfxdecodeinfo[i];
+      struct GfxElement *gfx, *lazy, ref;
+      struct GfxLayout gl;
+      retro_time_t start;
+      UINT32 length;
+      UINT8 *region;
+      UINT32 c;
+
+      region = bench_gfx_region(game, info->memory_region, &length);
+      if (!region)
+      {
+        skipped++;
+        continue;
+      }
+      gl = *info->gfxlayout;
+      bench_gfx_layout(&gl, length, info->start);
+
+      /* once as bytes, and once packed where the layout is 4bpp */
+      for (packed = 0; packed < 2; packed++)
+      {
+        if (packed && (gl.planeoffset[0] == GFX_RAW || gl.planes > 4 || (gl.width & 1)))
+          break;
+
+        start = bench_get_time_usec();
+        gfx = decodegfx_ex(region + info->start, &gl, packed ? DECODEGFX_PACKED : 0);
+        decode_usec += bench_get_time_usec() - start;
+        if (!gfx)
+          break;
+
+        /* the same element, decoded a bit at a time */
+        ref = *gfx;
+        ref.pen_usage = gfx->pen_usage ? malloc(gfx->total_elements * sizeof(UINT32)) : NULL;
+        if (gl.planeoffset[0] != GFX_RAW)
+        {
+          ref.gfxdata = malloc((size_t)gfx->total_elements * gfx->char_modulo);
+          start = bench_get_time_usec();
+          for (c = 0; c < gfx->total_elements; c++)
+            decodechar(&ref, c, region + info->start, &gl);
+          reference_usec += bench_get_time_usec() - start;
+          decoded_bytes += (UINT64)gfx->total_elements * gfx->char_modulo;
+          if (memcmp(ref.gfxdata, gfx->gfxdata, (size_t)gfx->total_elements * gfx->char_modulo))
+          {
+            printf("%s gfx %d%s: pixels MISMATCH\n", game->name, i, packed ? " packed" : "");
+            mismatches++;
+          }
+          free(ref.gfxdata);
+        }
+        if (ref.pen_usage)
+        {
+          if (gl.planeoffset[0] != GFX_RAW && memcmp(ref.pen_usage, gfx->pen_usage, gfx->total_elements * sizeof(UINT32)))
+          {
+            printf("%s gfx %d%s: pen usage MISMATCH\n", game->name, i, packed ? " packed" : "");
+            mismatches++;
+          }
+          free(ref.pen_usage);
+        }
+
+        /* and decoded on demand */
+        lazy = decodegfx_ex(region + info->start, &gl, (packed ? DECODEGFX_PACKED : 0) | DECODEGFX_LAZY);
+        if (lazy)
+        {
+          for (c = lazy->total_elements; c-- > 0; )
+            gfx_element_get_data(lazy, c);
+          if ((gl.planeoffset[0] != GFX_RAW && memcmp(lazy->gfxdata, gfx->gfxdata, (size_t)gfx->total_elements * gfx->char_modulo)) ||
+              (gfx->pen_usage && memcmp(lazy->pen_usage, gfx->pen_usage, gfx->total_elements * sizeof(UINT32))))
+          {
+            printf("%s gfx %d%s: lazy MISMATCH\n", game->name, i, packed ? " packed" : "");
+            mismatches++;
+          }
+          freegfx(lazy);
+        }
+
+        /* and written to the gfx cache, then mapped back from it */
+        if (save_dir && gl.planeoffset[0] != GFX_RAW && gfx->total_elements > BENCH_GFX_CACHE_ELEMENTS)
+        {
+          struct GfxElement *cached;
+          char name[64], path[PATH_MAX_LENGTH + 64];
+
+          snprintf(name, sizeof(name), "bench_%s_%d%s.gfx", game->name, i, packed ? "p" : "");
+          freegfx(gfx_cache_decode(name, region + info->start, length - info->start, &gl, packed ? DECODEGFX_PACKED : 0));
+          cached = gfx_cache_decode(name, region + info->start, length - info->start, &gl, packed ? DECODEGFX_PACKED : 0);
+          if (!cached || !(cached->flags & GFX_MAPPED_GFXDATA) ||
+              memcmp(cached->gfxdata, gfx->gfxdata, (size_t)gfx->total_elements * gfx->char_modulo) ||
+              (gfx->pen_usage && (!cached->pen_usage || memcmp(cached->pen_usage, gfx->pen_usage, gfx->total_elements * sizeof(UINT32)))))
+          {
+            printf("%s gfx %d%s: cache MISMATCH\n", game->name, i, packed ? " packed" : "");
+            mismatches++;
+          }
+          freegfx(cached);
+          snprintf(path, sizeof(path), "%s%c%s", cache_dir, PATH_DEFAULT_SLASH_C(), name);
+          remove(path);
+          cached_sets++;
+        }
+
+        freegfx(gfx);
+        layouts++;
+      }
+      free(region);
+    }
+  }
+
+  printf("layouts %d (%d skipped), decoded %.1f MB, decodegfx %.1f ms, decodechar %.1f ms, %d cached, %d mismatches\n",
+         layouts, skipped, decoded_bytes / 1048576.0, decode_usec / 1000.0, reference_usec / 1000.0, cached_sets, mismatches);
+}
+
+
+
+/******************************************************************************
+
+	main
+
+******************************************************************************/
+
+static void usage(const char *argv0)
+{
+  fprintf(stderr,
+    "usage: %s [options] <romset>\n"
+    "  -f <frames>      frames to time (default 3000)\n"
+    "  -w <frames>      warm-up frames run before timing starts (default 300)\n"
+    "  -s <dir>         system directory (default: the romset's directory)\n"
+    "  -S <dir>         save directory (default: the romset's directory)\n"
+    "  -o <key=value>   override a core option, may be repeated\n"
+    "  -c               print one CSV line instead of the report\n"
+    "  -H               checksum the video and audio output while timing\n"
+    "  -p               enable the core profiler and report its sections\n"
+    "  -R <depth>       take a rewind delta every frame, keeping <depth>\n"
+    "  -A <frames>      run each frame with <frames> of run-ahead\n"
+    "  -t               run the timer scheduler microbenchmark (no romset)\n"
+    "  -V               run the video conversion microbenchmark (no romset)\n"
+    "  -G               run the gfx decode microbenchmark (no romset; with -S,\n"
+    "                   large sets also round-trip through the gfx cache)\n"
+    "  -v               pass all core log messages through\n",
+    argv0);
+}
+
+int main(int argc, char **argv)
+{
+  struct retro_game_info game;
+  struct retro_system_av_info av_info;
+  const char *romset = NULL;
+  const char *driver;
+  char driver_name[256];
+  char *ext;
+  unsigned frames = 3000;
+  unsigned warmup = 300;
+  int csv = 0;
+  int profile = 0;
+  int i;
+  unsigned frame;
+  retro_time_t load_start, run_start, run_usec, load_usec;
+  double seconds;
+  double full_save_usec = 0;
+  int rewind_ok = 0;
+
+  /* measure gameplay, not the startup screens */
+  bench_set_override("mame2003-plus_skip_disclaimer", "enabled");
+  bench_set_override("mame2003-plus_skip_warnings",   "enabled");
+
+  for (i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+      frames = strtoul(argv[++i], NULL, 0);
+    else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc)
+      warmup = strtoul(argv[++i], NULL, 0);
+    else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+      system_dir = argv[++i];
+    else if (strcmp(argv[i], "-S") == 0 && i + 1 < argc)
+      save_dir = argv[++i];
+    else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+    {
+      char key[128];
+      const char *eq = strchr(argv[++i], '=');
+      if (!eq || eq - argv[i] >= (int)sizeof(key))
+      {
+        usage(argv[0]);
+        return 1;
+      }
+      memcpy(key, argv[i], eq - argv[i]);
+      key[eq - argv[i]] = 0;
+      bench_set_override(key, eq + 1);
+    }
+    else if (strcmp(argv[i], "-c") == 0)
+      csv = 1;
+    else if (strcmp(argv[i], "-H") == 0)
+      hash_output = 1;
+    else if (strcmp(argv[i], "-p") == 0)
+      profile = 1;
+    else if (strcmp(argv[i], "-R") == 0 && i + 1 < argc)
+      rewind_depth = strtoul(argv[++i], NULL, 0);
+    else if (strcmp(argv[i], "-A") == 0 && i + 1 < argc)
+      runahead = strtoul(argv[++i], NULL, 0);
+    else if (strcmp(argv[i], "-t") == 0)
+    {
+      bench_timers();
+      return 0;
+    }
+    else if (strcmp(argv[i], "-V") == 0)
+    {
+      bench_video();
+      return 0;
+    }
+    else if (strcmp(argv[i], "-G") == 0)
+    {
+      bench_gfx();
+      return 0;
+    }
+    else if (strcmp(argv[i], "-v") == 0)
+      verbose = 1;
+    else if (argv[i][0] != '-' && !romset)
+      romset = argv[i];
+    else
+    {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (!romset || !frames)
+  {
+    usage(argv[0]);
+    return 1;
+  }
+
+  /* -o may already have picked one of the trace modes */
+  if (profile && !bench_find_option("mame2003-plus_profiler"))
+    bench_set_override("mame2003-plus_profiler", "enabled");
+
+  /* report the romset name without its directory or extension */
+  driver = strrchr(romset, '/');
+  snprintf(driver_name, sizeof(driver_name), "%s", driver ? driver + 1 : romset);
+  if ((ext = strrchr(driver_name, '.')) != NULL)
+    *ext = 0;
+
+  retro_set_environment(bench_environment);
+  retro_set_video_refresh(bench_video_refresh);
+  retro_set_audio_sample(bench_audio_sample);
+  retro_set_audio_sample_batch(bench_audio_sample_batch);
+  retro_set_input_poll(bench_input_poll);
+  retro_set_input_state(bench_input_state);
+  retro_init();
+
+  memset(&game, 0, sizeof(game));
+  game.path = romset;
+
+  load_start = bench_get_time_usec();
+  if (!retro_load_game(&game))
+  {
+    fprintf(stderr, "%s: failed to load %s\n", argv[0], romset);
+    retro_deinit();
+    return 2;
+  }
+
+  /* the first retro_run() brings the machine up, so count it as load time */
+  retro_run();
+  load_usec = bench_get_time_usec() - load_start;
+  retro_get_system_av_info(&av_info);
+
+  for (frame = 0; frame < warmup; frame++)
+    retro_run();
+
+  video_frames = video_dupes = 0;
+  audio_frames = 0;
+  video_hash = audio_hash = 2166136261u;
+  bench_perf_reset();
+
+  if (rewind_depth && !bench_rewind_start(frames))
+  {
+    fprintf(stderr, "%s: %s can't be saved, rewind disabled\n", argv[0], driver_name);
+    rewind_depth = 0;
+  }
+  if (runahead && !bench_runahead_start())
+  {
+    fprintf(stderr, "%s: %s can't be saved, run-ahead disabled\n", argv[0], driver_name);
+    runahead = 0;
+  }
+
+  run_start = bench_get_time_usec();
+  for (frame = 0; frame < frames; frame++)
+  {
+    if (runahead)
+      bench_runahead_frame();
+    else
+      retro_run();
+    if (profile)
+      bench_profile_frame();
+    if (rewind_depth)
+      bench_rewind_capture();
+  }
+  run_usec = bench_get_time_usec() - run_start;
+
+  if (rewind_depth)
+    rewind_ok = bench_rewind_finish(&full_save_usec);
+
+  seconds   = run_usec / 1000000.0;
+
+  if (csv)
+  {
+    /* driver,frames,seconds,fps,speed,load_ms,counter=ms... */
+    printf("%s,%u,%.6f,%.3f,%.4f,%.3f", driver_name, frames, seconds, frames / seconds,
+           frames / seconds / av_info.timing.fps, load_usec / 1000.0);
+    if (hash_output)
+      printf(",video=%08x,audio=%08x", video_hash, audio_hash);
+    if (rewind_depth)
+      printf(",rewind_bytes=%.0f,rewind_us=%.1f,full_save_us=%.1f,rewind=%s",
+             rewind_count ? (double)rewind_bytes / rewind_count : 0.0,
+             rewind_count ? (double)rewind_usec / rewind_count : 0.0,
+             full_save_usec, rewind_ok ? "ok" : "FAILED");
+    for (i = 0; i < counter_count; i++)
+      printf(",%s=%.3f", counters[i]->ident, counters[i]->total / 1000.0);
+    for (i = 0; i < PROFILER_TOTAL && profile_total; i++)
+      if (profile_count[i])
+        printf(",%s=%.2f%%", profiler_get_name(i), 100.0 * profile_count[i] / profile_total);
+    printf("\n");
+  }
+  else
+  {
+    printf("driver:        %s\n", driver_name);
+    printf("load:          %.3f ms\n", load_usec / 1000.0);
+    printf("frames:        %u (+%u warm-up), %u presented, %u duped\n", frames, warmup, video_frames, video_dupes);
+    if (runahead)
+      printf("run-ahead:     %u frames\n", runahead);
+    printf("audio frames:  %lu\n", (unsigned long)audio_frames);
+    printf("time:          %.3f s\n", seconds);
+    printf("fps:           %.2f (%.1f%% of %.2f Hz)\n", frames / seconds,
+           100.0 * frames / seconds / av_info.timing.fps, av_info.timing.fps);
+    printf("per frame:     %.3f ms\n", run_usec / 1000.0 / frames);
+    if (hash_output)
+      printf("checksums:     video %08x, audio %08x\n", video_hash, audio_hash);
+    if (rewind_depth)
+      printf("rewind:        %.0f of %lu bytes per delta, %.1f us per delta (full save %.1f us), step back %s\n",
+             rewind_count ? (double)rewind_bytes / rewind_count : 0.0, (unsigned long)rewind_image_size,
+             rewind_count ? (double)rewind_usec / rewind_count : 0.0, full_save_usec,
+             rewind_ok ? "ok" : "FAILED");
+    for (i = 0; i < counter_count; i++)
+      printf("  %-24s %10.3f ms  %8lu calls  %6.2f%%\n", counters[i]->ident,
+             counters[i]->total / 1000.0, (unsigned long)counters[i]->call_cnt,
+             100.0 * counters[i]->total / run_usec);
+    if (profile_total)
+    {
+      printf("profiler:      %.1f context switches per frame\n", (double)profile_switches / frames);
+      for (i = 0; i < PROFILER_TOTAL; i++)
+        if (profile_count[i])
+          printf("  %-24s %6.2f%%\n", profiler_get_name(i), 100.0 * profile_count[i] / profile_total);
+    }
+  }
+
+  free(runahead_state);
+  retro_unload_game();
+  retro_deinit();
+
+  return 0;
+}
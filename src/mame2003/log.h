@@ -15,6 +15,39 @@
 extern retro_log_printf_t log_cb;
 
 
+/* Compile-time trace categories for debug output on hot paths: once per
+   timeslice, per timer, per save state entry, per file path probe.
+   log_cb filters by level at runtime, which still means a variadic call
+   through a pointer for every message; a category set to 0 here is type
+   checked but compiled out entirely.
+
+   Turn categories on from the command line, e.g.
+     make TRACE="CPUEXEC TIMER"
+   or by defining TRACE_<category> to 1 before including this header.
+
+   Usage, note the double parentheses:
+     log_trace(CPUEXEC, (RETRO_LOG_DEBUG, LOGPRE "target = %.9f\n", target));
+*/
+
+#ifndef TRACE_CPUEXEC
+#define TRACE_CPUEXEC	0	/* cpu_timeslice, suspend/resume, interleave */
+#endif
+#ifndef TRACE_TIMER
+#define TRACE_TIMER		0	/* timer adjust and fire */
+#endif
+#ifndef TRACE_STATE
+#define TRACE_STATE		0	/* save state begin/continue/load, per entry */
+#endif
+#ifndef TRACE_FILEIO
+#define TRACE_FILEIO	0	/* path lookups and generic_fopen probes */
+#endif
+#ifndef TRACE_MEMORY
+#define TRACE_MEMORY	0	/* unmapped and ROM write accesses */
+#endif
+
+#define log_trace(category, args)	do { if (TRACE_##category) log_cb args; } while (0)
+
+
 /* logerror is a holdover from the MAME log system. MAME 0.78 was evidently
    trying to standardize on logerror but the standardization was not complete,
    with a dozen variations on indicating loging verbosity via defines,
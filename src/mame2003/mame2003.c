@@ -13,6 +13,7 @@
 #include <string/stdstring.h>
 #include <libretro.h>
 #include <file/file_path.h>
+#include <features/features_cpu.h>
 #include <math.h>
 
 #if (HAS_DRZ80 || HAS_CYCLONE)
@@ -23,6 +24,7 @@
 #include "driver.h"
 #include "state.h"
 #include "log.h"
+#include "libretro_perf.h"
 #include "input.h"
 #include "inptport.h"
 #include "fileio.h"
@@ -37,9 +39,6 @@ static const struct GameDriver  *game_driver;
 static float              delta_samples;
 int                       samples_per_frame = 0;
 int                       orig_samples_per_frame =0;
-short*                    samples_buffer;
-short*                    conversion_buffer;
-int                       usestereo = 1;
 int16_t                   prev_pointer_x;
 int16_t                   prev_pointer_y;
 unsigned                  retroColorMode;
@@ -111,6 +110,10 @@ enum CORE_OPTIONS/* controls the order in which core options appear. common, imp
   OPT_Cheat_Input_Ports,
   OPT_Machine_Timing,
   OPT_Digital_Joy_Centering,
+  OPT_PROFILER,
+  OPT_GFX_CACHE,
+  OPT_GFX_PACKED,
+  OPT_GFX_LAZY,
   OPT_end /* dummy last entry */
 };
 
@@ -226,6 +229,10 @@ static void init_core_options(void)
   init_default(&default_options[OPT_Cheat_Input_Ports],      APPNAME"_cheat_input_ports",      "Dip switch/Cheat input ports; disabled|enabled");
   init_default(&default_options[OPT_Machine_Timing],         APPNAME"_machine_timing",         "Bypass audio skew (Restart core); enabled|disabled");
   init_default(&default_options[OPT_Digital_Joy_Centering],  APPNAME"_digital_joy_centering",  "Center joystick axis for digital controls; enabled|disabled");
+  init_default(&default_options[OPT_PROFILER],               APPNAME"_profiler",               "Profiler; disabled|enabled|csv|json");
+  init_default(&default_options[OPT_GFX_CACHE],              APPNAME"_gfx_cache",              "Cache decoded graphics (Restart core); disabled|enabled");
+  init_default(&default_options[OPT_GFX_PACKED],             APPNAME"_gfx_packed",             "Pack 4bpp graphics to save memory (Restart core); disabled|enabled");
+  init_default(&default_options[OPT_GFX_LAZY],               APPNAME"_gfx_lazy",               "Decode graphics on first use (Restart core); disabled|enabled");
   init_default(&default_options[OPT_end], NULL, NULL);
   set_variables(true);
 }
@@ -662,6 +669,34 @@ static void update_variables(bool first_time)
             options.machine_timing = true;
           else
             options.machine_timing = false;
+          break;
+	    case OPT_PROFILER:
+          if(strcmp(var.value, "enabled") == 0)
+            options.profiler = PROFILER_MODE_ON;
+          else if(strcmp(var.value, "csv") == 0)
+            options.profiler = PROFILER_MODE_CSV;
+          else if(strcmp(var.value, "json") == 0)
+            options.profiler = PROFILER_MODE_JSON;
+          else
+            options.profiler = PROFILER_MODE_OFF;
+          break;
+	    case OPT_GFX_CACHE:
+          if(strcmp(var.value, "enabled") == 0)
+            options.gfx_cache = true;
+          else
+            options.gfx_cache = false;
+          break;
+	    case OPT_GFX_PACKED:
+          if(strcmp(var.value, "enabled") == 0)
+            options.gfx_packed = true;
+          else
+            options.gfx_packed = false;
+          break;
+	    case OPT_GFX_LAZY:
+          if(strcmp(var.value, "enabled") == 0)
+            options.gfx_lazy = true;
+          else
+            options.gfx_lazy = false;
           break;
 	  }
     }
@@ -1226,6 +1261,19 @@ int16_t get_pointer_delta(int16_t coord, int16_t *prev_coord)
    return delta;
 }
 
+/* RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE bits */
+#define AV_ENABLE_VIDEO            1
+#define AV_ENABLE_AUDIO            2
+#define AV_ENABLE_FAST_SAVESTATES  4
+
+static int get_av_enable(void)
+{
+	int av_enable;
+	if (!environ_cb(RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE, &av_enable))
+		av_enable = AV_ENABLE_VIDEO | AV_ENABLE_AUDIO;
+	return av_enable;
+}
+
 void retro_run (void)
 {
 	int i;
@@ -1332,6 +1380,10 @@ void retro_run (void)
 		if (convert_analog_scale(analogjoy[i][3]) >  pressure_check)
 			retroJsState[ 25 + offset] = convert_analog_scale(analogjoy[i][3]);
 	}
+
+   /* Frames the frontend discards (run-ahead) are emulated but not drawn */
+   video_frame_hidden = !(get_av_enable() & AV_ENABLE_VIDEO);
+
    mame_frame();
 }
 
@@ -1357,36 +1409,61 @@ size_t retro_serialize_size(void)
     return state_get_dump_size();
 }
 
-bool retro_serialize(void *data, size_t size)
+/*
+  Runs the save for tag 0 and then each CPU, with its context and banking
+  in place. Fast savestates (run-ahead: same binary, same session) skip
+  what only a portable save needs: a CPU whose registers are already in
+  its core's globals is saved without a context switch, and the bank
+  reset is left to the load, which does it once the registers are back.
+*/
+static bool save_state_tags(bool fast)
 {
-   int cpunum;
-	if(  retro_serialize_size() == size  && size   )
+	int cpunum;
+
+	/* write tag 0 */
+	state_save_set_current_tag(0);
+	if(state_save_save_continue())
 	{
-		/* write the save state */
-		state_save_save_begin(data);
+	    return false;
+	}
 
-		/* write tag 0 */
-		state_save_set_current_tag(0);
-		if(state_save_save_continue())
+	/* loop over CPUs */
+	for (cpunum = 0; cpunum < cpu_gettotalcpu(); cpunum++)
+	{
+		if (fast && !cpunum_get_context_ptr(cpunum))
 		{
-		    return false;
+			state_save_set_current_tag(cpunum + 1);
+			if(state_save_save_continue())
+			    return false;
+			continue;
 		}
 
-		/* loop over CPUs */
-		for (cpunum = 0; cpunum < cpu_gettotalcpu(); cpunum++)
-		{
-			cpuintrf_push_context(cpunum);
+		cpuintrf_push_context(cpunum);
 
-			/* make sure banking is set */
+		/* make sure banking is set */
+		if (!fast)
 			activecpu_reset_banking();
 
-			/* save the CPU data */
-			state_save_set_current_tag(cpunum + 1);
-			if(state_save_save_continue())
-			    return false;
+		/* save the CPU data */
+		state_save_set_current_tag(cpunum + 1);
+		if(state_save_save_continue())
+		    return false;
 
-			cpuintrf_pop_context();
-		}
+		cpuintrf_pop_context();
+	}
+
+	return true;
+}
+
+bool retro_serialize(void *data, size_t size)
+{
+	if(  retro_serialize_size() == size  && size   )
+	{
+		/* write the save state */
+		state_save_save_begin(data);
+
+		if(!save_state_tags(get_av_enable() & AV_ENABLE_FAST_SAVESTATES))
+		    return false;
 
 		/* finish and close */
 		state_save_save_finish();
@@ -1397,9 +1474,28 @@ bool retro_serialize(void *data, size_t size)
 	return false;
 }
 
+/*
+  Rewind helper: snapshot holds the previous retro_serialize() sized image
+  (zeroed for the first call) and is brought up to date, while only the
+  changed runs go to delta, which needs state_delta_max_size() bytes.
+*/
+bool mame2003_serialize_delta(void *snapshot, void *delta, size_t *delta_size)
+{
+	if (!retro_serialize_size())
+		return false;
+
+	state_save_delta_begin(snapshot, delta);
+	if (!save_state_tags(get_av_enable() & AV_ENABLE_FAST_SAVESTATES))
+		return false;
+
+	*delta_size = state_save_delta_finish();
+	return true;
+}
+
 bool retro_unserialize(const void * data, size_t size)
 {
     int cpunum;
+    bool fast = get_av_enable() & AV_ENABLE_FAST_SAVESTATES;
 	/* if successful, load it */
 	if ( (retro_serialize_size() ) && ( data ) && ( size ) && ( !state_save_load_begin((void*)data, size) ) )
 	{
@@ -1414,13 +1510,18 @@ bool retro_unserialize(const void * data, size_t size)
             cpuintrf_push_context(cpunum);
 
             /* make sure banking is set */
-            activecpu_reset_banking();
+            if (!fast)
+                activecpu_reset_banking();
 
             /* load the CPU data */
             state_save_set_current_tag(cpunum + 1);
             if(state_save_load_continue())
                 return false;
 
+            /* fast savestates left the bank reset until the PC is restored */
+            if (fast)
+                activecpu_reset_banking();
+
             cpuintrf_pop_context();
         }
 
@@ -1442,9 +1543,9 @@ bool retro_unserialize(const void * data, size_t size)
   the output stream, then osd_update_audio_stream() is called every frame to
   feed new data. osd_stop_audio_stream() is called when the emulation is stopped.
 
-  The sample rate is fixed at Machine->sample_rate. Samples are 16-bit, signed.
-  When the stream is stereo, left and right samples are alternated in the
-  stream.
+  The sample rate is fixed at Machine->sample_rate. Samples are 16-bit, signed,
+  with left and right alternated; the mixer duplicates mono into both channels,
+  so the buffer is handed to the frontend as is, without a copy.
 
   osd_start_audio_stream() and osd_update_audio_stream() must return the number
   of samples (or couples of samples, when using stereo) required for next frame.
@@ -1479,7 +1580,6 @@ int osd_start_audio_stream(int stereo)
   }
 
   delta_samples = 0.0f;
-  usestereo = stereo ? 1 : 0;
 
   /* determine the number of samples per frame */
   samples_per_frame = Machine->sample_rate / Machine->drv->frames_per_second;
@@ -1487,30 +1587,18 @@ int osd_start_audio_stream(int stereo)
 
   if (Machine->sample_rate == 0) return 0;
 
-  samples_buffer = (short *) calloc(samples_per_frame+16, 2 + usestereo * 2);
-  if (!usestereo) conversion_buffer = (short *) calloc(samples_per_frame+16, 4);
-
   return samples_per_frame;
 }
 
 
 int osd_update_audio_stream(INT16 *buffer)
 {
-	int i,j;
+	RETRO_PERFORMANCE_INIT(perf_cb, output_audio);
+	RETRO_PERFORMANCE_START(perf_cb, output_audio);
+
 	if ( Machine->sample_rate !=0 && buffer )
 	{
-   		memcpy(samples_buffer, buffer, samples_per_frame * (usestereo ? 4 : 2));
-		if (usestereo)
-			audio_batch_cb(samples_buffer, samples_per_frame);
-		else
-		{
-			for (i = 0, j = 0; i < samples_per_frame; i++)
-        		{
-				conversion_buffer[j++] = samples_buffer[i];
-				conversion_buffer[j++] = samples_buffer[i];
-		        }
-         		audio_batch_cb(conversion_buffer,samples_per_frame);
-		}
+		audio_batch_cb(buffer, samples_per_frame);
 
 
 		//process next frame
@@ -1535,6 +1623,8 @@ int osd_update_audio_stream(INT16 *buffer)
 
 		}
 	}
+
+	RETRO_PERFORMANCE_STOP(perf_cb, output_audio);
         return samples_per_frame;
 }
 
@@ -1545,6 +1635,30 @@ void osd_stop_audio_stream(void)
 
 
 
+/******************************************************************************
+
+Timing
+
+******************************************************************************/
+
+cycles_t osd_cycles(void)
+{
+  return cpu_features_get_time_usec();
+}
+
+cycles_t osd_cycles_per_second(void)
+{
+  return 1000000;
+}
+
+cycles_t osd_profiling_ticks(void)
+{
+  /* raw tick counter (TSC where available); only ever used for relative measurements */
+  return cpu_features_get_perf_counter();
+}
+
+
+
 /******************************************************************************
 
 Miscellaneous
@@ -53,6 +53,73 @@ extern "C" {
 extern void mame2003_video_get_geometry(struct retro_game_geometry *geom);
 
 
+/******************************************************************************
+
+	Output bitmap conversion
+    implemented in video.c, set up by osd_create_display()
+
+******************************************************************************/
+
+/* Possible pixel conversions */
+enum
+{
+   VCT_PASS8888,
+   VCT_PASS1555,
+   VCT_PASSPAL,
+   VCT_PALTO565
+};
+
+struct mame_display;
+
+extern unsigned video_conversion_type;
+extern unsigned video_stride_in, video_stride_out;
+extern bool video_flip_x, video_flip_y, video_swap_xy;
+extern const UINT32 *video_palette;
+extern uint16_t *video_buffer;
+
+/* Set for frames the frontend discards (run-ahead); they aren't drawn */
+extern bool video_frame_hidden;
+
+extern void mame2003_video_select_kernels(bool allow_simd);
+extern void mame2003_video_frame_convert(struct mame_display *display);
+
+
+/******************************************************************************
+
+	Delta save states for rewind
+    implemented in mame2003.c, see state.c for the delta format
+
+******************************************************************************/
+extern bool mame2003_serialize_delta(void *snapshot, void *delta, size_t *delta_size);
+
+
+/******************************************************************************
+
+	Threading
+    implemented in threads.c; without HAVE_THREADS locks are no-ops and
+    work items run on the calling thread as they are queued
+
+******************************************************************************/
+
+struct osd_lock;
+struct osd_work_queue;
+
+typedef void (*osd_work_callback)(void *param);
+
+extern int osd_num_processors(void);
+
+extern struct osd_lock *osd_lock_alloc(void);
+extern void osd_lock_acquire(struct osd_lock *lock);
+extern void osd_lock_release(struct osd_lock *lock);
+extern void osd_lock_free(struct osd_lock *lock);
+
+/* returns NULL when there is nothing to gain from threads */
+extern struct osd_work_queue *osd_work_queue_alloc(int threads);
+extern void osd_work_item_queue(struct osd_work_queue *queue, osd_work_callback callback, void *param);
+extern void osd_work_queue_wait(struct osd_work_queue *queue);
+extern void osd_work_queue_free(struct osd_work_queue *queue);
+
+
 /******************************************************************************
 
 	Shared libretro log interface
@@ -196,9 +263,9 @@ void osd_update_video_and_audio(struct mame_display *display);
   the output stream, then osd_update_audio_stream() is called every frame to
   feed new data. osd_stop_audio_stream() is called when the emulation is stopped.
 
-  The sample rate is fixed at Machine->sample_rate. Samples are 16-bit, signed.
-  When the stream is stereo, left and right samples are alternated in the
-  stream.
+  The sample rate is fixed at Machine->sample_rate. Samples are 16-bit, signed,
+  with left and right alternated; the mixer always delivers stereo and
+  duplicates mono sources, so the buffer can be passed on without conversion.
 
   osd_start_audio_stream() and osd_update_audio_stream() must return the number
   of samples (or couples of samples, when using stereo) required for next frame.
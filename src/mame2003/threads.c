@@ -0,0 +1,211 @@
+/******************************************************************************
+
+	threads.c
+
+	Locks and work queues for the core, on top of libretro-common's
+	rthreads. Without HAVE_THREADS the locks do nothing and queued work
+	items run immediately on the calling thread, so callers don't need
+	to care whether threads are available.
+
+******************************************************************************/
+
+#include <stdlib.h>
+#include <features/features_cpu.h>
+#include "mame2003.h"
+
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#include <rthreads/tpool.h>
+#endif
+
+
+/*-------------------------------------------------
+	osd_num_processors - number of cores on the
+	host, or 1 without thread support
+-------------------------------------------------*/
+
+int osd_num_processors(void)
+{
+#ifdef HAVE_THREADS
+	unsigned cores = cpu_features_get_core_amount();
+	return cores ? cores : 1;
+#else
+	return 1;
+#endif
+}
+
+
+
+/*-------------------------------------------------
+	locks
+-------------------------------------------------*/
+
+struct osd_lock *osd_lock_alloc(void)
+{
+#ifdef HAVE_THREADS
+	return (struct osd_lock *)slock_new();
+#else
+	return NULL;
+#endif
+}
+
+
+void osd_lock_acquire(struct osd_lock *lock)
+{
+#ifdef HAVE_THREADS
+	if (lock)
+		slock_lock((slock_t *)lock);
+#endif
+}
+
+
+void osd_lock_release(struct osd_lock *lock)
+{
+#ifdef HAVE_THREADS
+	if (lock)
+		slock_unlock((slock_t *)lock);
+#endif
+}
+
+
+void osd_lock_free(struct osd_lock *lock)
+{
+#ifdef HAVE_THREADS
+	if (lock)
+		slock_free((slock_t *)lock);
+#endif
+}
+
+
+
+/*-------------------------------------------------
+	work queues
+
+	tpool_wait() only waits for items a worker has
+	already picked up, so the queue keeps its own
+	count of outstanding items.
+-------------------------------------------------*/
+
+#ifdef HAVE_THREADS
+struct osd_work_queue
+{
+	tpool_t *pool;
+	slock_t *lock;
+	scond_t *done;					/* signalled when pending drops to 0 */
+	int pending;					/* items queued and not yet finished */
+};
+
+struct osd_work_item
+{
+	struct osd_work_queue *queue;
+	osd_work_callback callback;
+	void *param;
+};
+
+
+static void osd_work_item_run(void *param)
+{
+	struct osd_work_item *item = param;
+	struct osd_work_queue *queue = item->queue;
+
+	(*item->callback)(item->param);
+	free(item);
+
+	slock_lock(queue->lock);
+	if (--queue->pending == 0)
+		scond_broadcast(queue->done);
+	slock_unlock(queue->lock);
+}
+#endif
+
+
+struct osd_work_queue *osd_work_queue_alloc(int threads)
+{
+#ifdef HAVE_THREADS
+	struct osd_work_queue *queue;
+
+	if (threads <= 1)
+		return NULL;
+
+	queue = calloc(1, sizeof(*queue));
+	if (!queue)
+		return NULL;
+
+	queue->lock = slock_new();
+	queue->done = scond_new();
+	if (queue->lock && queue->done)
+		queue->pool = tpool_create(threads);
+	if (!queue->pool)
+	{
+		osd_work_queue_free(queue);
+		return NULL;
+	}
+	return queue;
+#else
+	return NULL;
+#endif
+}
+
+
+void osd_work_item_queue(struct osd_work_queue *queue, osd_work_callback callback, void *param)
+{
+#ifdef HAVE_THREADS
+	if (queue)
+	{
+		struct osd_work_item *item = malloc(sizeof(*item));
+		if (item)
+		{
+			item->queue = queue;
+			item->callback = callback;
+			item->param = param;
+
+			slock_lock(queue->lock);
+			queue->pending++;
+			slock_unlock(queue->lock);
+
+			if (tpool_add_work(queue->pool, osd_work_item_run, item))
+				return;
+
+			slock_lock(queue->lock);
+			queue->pending--;
+			slock_unlock(queue->lock);
+			free(item);
+		}
+	}
+#endif
+
+	/* no queue, or it's unable to take the item: do it now */
+	(*callback)(param);
+}
+
+
+void osd_work_queue_wait(struct osd_work_queue *queue)
+{
+#ifdef HAVE_THREADS
+	if (!queue)
+		return;
+
+	slock_lock(queue->lock);
+	while (queue->pending > 0)
+		scond_wait(queue->done, queue->lock);
+	slock_unlock(queue->lock);
+#endif
+}
+
+
+void osd_work_queue_free(struct osd_work_queue *queue)
+{
+#ifdef HAVE_THREADS
+	if (!queue)
+		return;
+
+	osd_work_queue_wait(queue);
+	if (queue->pool)
+		tpool_destroy(queue->pool);
+	if (queue->done)
+		scond_free(queue->done);
+	if (queue->lock)
+		slock_free(queue->lock);
+	free(queue);
+#endif
+}
@@ -8,6 +8,15 @@
 #include "mame.h"
 #include "usrintrf.h"
 #include "driver.h"
+#include <features/features_cpu.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define VIDEO_CONVERT_SSE2
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define VIDEO_CONVERT_NEON
+#endif
 
 #define MAX_LED 8
 
@@ -32,18 +41,10 @@ unsigned video_do_bypass;
 unsigned video_stride_in, video_stride_out;
 bool video_flip_x, video_flip_y, video_swap_xy;
 bool video_hw_transpose;
+bool video_frame_hidden;
 const rgb_t *video_palette;
 uint16_t *video_buffer;
 
-/* Possible pixel conversions (see corresponding function far below) */
-enum
-{
-   VCT_PASS8888,
-   VCT_PASS1555,
-   VCT_PASSPAL,
-   VCT_PALTO565
-};
-
 /* Retrieve output geometry (i.e. window dimensions) */
 void mame2003_video_get_geometry(struct retro_game_geometry *geom)
 {
@@ -260,115 +261,328 @@ void osd_close_display(void)
    video_buffer = NULL;
 }
 
-static INLINE void pix_convert_pass8888(uint32_t *from, uint32_t *to)
+/*
+   Pixel conversion kernels. Each one converts a run of count pixels to
+   consecutive output pixels, reading the input step pixels apart: +/-1
+   along a bitmap row, or +/- the bitmap pitch down a column when the XY
+   swap is done in software. mame2003_video_select_kernels() swaps in the
+   SSE2 or NEON versions when the CPU has them.
+*/
+typedef void (*convert_run_func)(const void *from, int step, void *to, int count);
+
+#define PAL_TO_565(color) \
+   (((color) & 0x00F80000) >> 8 | /* red */ \
+    ((color) & 0x0000FC00) >> 5 | /* green */ \
+    ((color) & 0x000000F8) >> 3)  /* blue */
+
+static void run_convert_pass8888(const void *from, int step, void *to, int count)
 {
-   *to = *from;
+   const uint32_t *in = (const uint32_t*)from;
+   uint32_t *out = (uint32_t*)to;
+
+   if (step == 1)
+   {
+      memcpy(out, in, count * sizeof(*out));
+      return;
+   }
+   for (; count > 0; count--, in += step)
+      *out++ = *in;
 }
 
-static INLINE void pix_convert_pass1555(uint16_t *from, uint16_t *to)
+static void run_convert_pass1555(const void *from, int step, void *to, int count)
 {
-   *to = *from;
+   const uint16_t *in = (const uint16_t*)from;
+   uint16_t *out = (uint16_t*)to;
+
+   if (step == 1)
+   {
+      memcpy(out, in, count * sizeof(*out));
+      return;
+   }
+   for (; count > 0; count--, in += step)
+      *out++ = *in;
 }
 
-static INLINE void pix_convert_passpal(uint16_t *from, uint32_t *to)
+static void run_convert_passpal(const void *from, int step, void *to, int count)
 {
-   *to = video_palette[*from];
+   const uint16_t *in = (const uint16_t*)from;
+   uint32_t *out = (uint32_t*)to;
+   const rgb_t *palette = video_palette;
+
+   for (; count > 0; count--, in += step)
+      *out++ = palette[*in];
 }
 
-static INLINE void pix_convert_palto565(uint16_t *from, uint16_t *to)
+static void run_convert_palto565(const void *from, int step, void *to, int count)
 {
-   const uint32_t color = video_palette[*from];
-   *to = (color & 0x00F80000) >> 8 | /* red */
-         (color & 0x0000FC00) >> 5 | /* green */
-         (color & 0x000000F8) >> 3;  /* blue */
+   const uint16_t *in = (const uint16_t*)from;
+   uint16_t *out = (uint16_t*)to;
+   const rgb_t *palette = video_palette;
+
+   for (; count > 0; count--, in += step)
+   {
+      const uint32_t color = palette[*in];
+      *out++ = PAL_TO_565(color);
+   }
+}
+
+#if defined(VIDEO_CONVERT_SSE2)
+/* Reversed runs (X flip) are loaded a vector at a time and shuffled */
+static void run_convert_pass8888_sse2(const void *from, int step, void *to, int count)
+{
+   const uint32_t *in = (const uint32_t*)from;
+   uint32_t *out = (uint32_t*)to;
+
+   if (step == -1)
+      for (; count >= 4; count -= 4, in -= 4, out += 4)
+      {
+         __m128i pixels = _mm_loadu_si128((const __m128i*)(in - 3));
+         _mm_storeu_si128((__m128i*)out, _mm_shuffle_epi32(pixels, _MM_SHUFFLE(0, 1, 2, 3)));
+      }
+   run_convert_pass8888(in, step, out, count);
 }
 
-static void frame_convert(struct mame_display *display)
+static void run_convert_pass1555_sse2(const void *from, int step, void *to, int count)
 {
-   int x, y;
+   const uint16_t *in = (const uint16_t*)from;
+   uint16_t *out = (uint16_t*)to;
 
-   bool flip_x = video_flip_x;
-   bool flip_y = video_flip_y;
+   if (step == -1)
+      for (; count >= 8; count -= 8, in -= 8, out += 8)
+      {
+         __m128i pixels = _mm_loadu_si128((const __m128i*)(in - 7));
+         pixels = _mm_shuffle_epi32(pixels, _MM_SHUFFLE(0, 1, 2, 3));
+         pixels = _mm_shufflelo_epi16(pixels, _MM_SHUFFLE(2, 3, 0, 1));
+         pixels = _mm_shufflehi_epi16(pixels, _MM_SHUFFLE(2, 3, 0, 1));
+         _mm_storeu_si128((__m128i*)out, pixels);
+      }
+   run_convert_pass1555(in, step, out, count);
+}
 
+/* There is no gather in SSE2; the lookups are scalar, the stores are not */
+static void run_convert_passpal_sse2(const void *from, int step, void *to, int count)
+{
+   const uint16_t *in = (const uint16_t*)from;
+   uint32_t *out = (uint32_t*)to;
+   const rgb_t *palette = video_palette;
+
+   for (; count >= 4; count -= 4, in += 4 * step, out += 4)
+      _mm_storeu_si128((__m128i*)out, _mm_setr_epi32(
+         (int)palette[in[0]], (int)palette[in[step]],
+         (int)palette[in[2 * step]], (int)palette[in[3 * step]]));
+   run_convert_passpal(in, step, out, count);
+}
+
+static INLINE __m128i sse2_pal_to_565(__m128i color)
+{
+   __m128i r = _mm_and_si128(_mm_srli_epi32(color, 8), _mm_set1_epi32(0xF800));
+   __m128i g = _mm_and_si128(_mm_srli_epi32(color, 5), _mm_set1_epi32(0x07E0));
+   __m128i b = _mm_and_si128(_mm_srli_epi32(color, 3), _mm_set1_epi32(0x001F));
+
+   /* sign extend, so the saturating pack keeps all 16 bits */
+   color = _mm_or_si128(_mm_or_si128(r, g), b);
+   return _mm_srai_epi32(_mm_slli_epi32(color, 16), 16);
+}
+
+static void run_convert_palto565_sse2(const void *from, int step, void *to, int count)
+{
+   const uint16_t *in = (const uint16_t*)from;
+   uint16_t *out = (uint16_t*)to;
+   const rgb_t *palette = video_palette;
+
+   for (; count >= 8; count -= 8, in += 8 * step, out += 8)
+   {
+      __m128i lo = _mm_setr_epi32(
+         (int)palette[in[0]], (int)palette[in[step]],
+         (int)palette[in[2 * step]], (int)palette[in[3 * step]]);
+      __m128i hi = _mm_setr_epi32(
+         (int)palette[in[4 * step]], (int)palette[in[5 * step]],
+         (int)palette[in[6 * step]], (int)palette[in[7 * step]]);
+      _mm_storeu_si128((__m128i*)out, _mm_packs_epi32(sse2_pal_to_565(lo), sse2_pal_to_565(hi)));
+   }
+   run_convert_palto565(in, step, out, count);
+}
+#endif
+
+#if defined(VIDEO_CONVERT_NEON)
+static void run_convert_pass8888_neon(const void *from, int step, void *to, int count)
+{
+   const uint32_t *in = (const uint32_t*)from;
+   uint32_t *out = (uint32_t*)to;
+
+   if (step == -1)
+      for (; count >= 4; count -= 4, in -= 4, out += 4)
+      {
+         uint32x4_t pixels = vrev64q_u32(vld1q_u32(in - 3));
+         vst1q_u32(out, vcombine_u32(vget_high_u32(pixels), vget_low_u32(pixels)));
+      }
+   run_convert_pass8888(in, step, out, count);
+}
+
+static void run_convert_pass1555_neon(const void *from, int step, void *to, int count)
+{
+   const uint16_t *in = (const uint16_t*)from;
+   uint16_t *out = (uint16_t*)to;
+
+   if (step == -1)
+      for (; count >= 8; count -= 8, in -= 8, out += 8)
+      {
+         uint16x8_t pixels = vrev64q_u16(vld1q_u16(in - 7));
+         vst1q_u16(out, vcombine_u16(vget_high_u16(pixels), vget_low_u16(pixels)));
+      }
+   run_convert_pass1555(in, step, out, count);
+}
+
+static void run_convert_passpal_neon(const void *from, int step, void *to, int count)
+{
+   const uint16_t *in = (const uint16_t*)from;
+   uint32_t *out = (uint32_t*)to;
+   const rgb_t *palette = video_palette;
+   uint32_t colors[4];
+
+   for (; count >= 4; count -= 4, in += 4 * step, out += 4)
+   {
+      colors[0] = palette[in[0]];
+      colors[1] = palette[in[step]];
+      colors[2] = palette[in[2 * step]];
+      colors[3] = palette[in[3 * step]];
+      vst1q_u32(out, vld1q_u32(colors));
+   }
+   run_convert_passpal(in, step, out, count);
+}
+
+static INLINE uint16x4_t neon_pal_to_565(uint32x4_t color)
+{
+   uint32x4_t r = vandq_u32(vshrq_n_u32(color, 8), vdupq_n_u32(0xF800));
+   uint32x4_t g = vandq_u32(vshrq_n_u32(color, 5), vdupq_n_u32(0x07E0));
+   uint32x4_t b = vandq_u32(vshrq_n_u32(color, 3), vdupq_n_u32(0x001F));
+
+   return vmovn_u32(vorrq_u32(vorrq_u32(r, g), b));
+}
+
+static void run_convert_palto565_neon(const void *from, int step, void *to, int count)
+{
+   const uint16_t *in = (const uint16_t*)from;
+   uint16_t *out = (uint16_t*)to;
+   const rgb_t *palette = video_palette;
+   uint32_t colors[8];
+   int i;
+
+   for (; count >= 8; count -= 8, in += 8 * step, out += 8)
+   {
+      for (i = 0; i < 8; i++)
+         colors[i] = palette[in[i * step]];
+      vst1q_u16(out, vcombine_u16(
+         neon_pal_to_565(vld1q_u32(&colors[0])),
+         neon_pal_to_565(vld1q_u32(&colors[4]))));
+   }
+   run_convert_palto565(in, step, out, count);
+}
+#endif
+
+/* Indexed by video_conversion_type */
+static convert_run_func convert_run[] =
+{
+   run_convert_pass8888,
+   run_convert_pass1555,
+   run_convert_passpal,
+   run_convert_palto565
+};
+static bool convert_run_selected;
+
+/* Pick the conversion kernels; allow_simd false keeps the plain C ones */
+void mame2003_video_select_kernels(bool allow_simd)
+{
+   uint64_t simd = allow_simd ? cpu_features_get() : 0;
+
+   convert_run[VCT_PASS8888] = run_convert_pass8888;
+   convert_run[VCT_PASS1555] = run_convert_pass1555;
+   convert_run[VCT_PASSPAL] = run_convert_passpal;
+   convert_run[VCT_PALTO565] = run_convert_palto565;
+
+#if defined(VIDEO_CONVERT_SSE2)
+   if (simd & RETRO_SIMD_SSE2)
+   {
+      convert_run[VCT_PASS8888] = run_convert_pass8888_sse2;
+      convert_run[VCT_PASS1555] = run_convert_pass1555_sse2;
+      convert_run[VCT_PASSPAL] = run_convert_passpal_sse2;
+      convert_run[VCT_PALTO565] = run_convert_palto565_sse2;
+   }
+#elif defined(VIDEO_CONVERT_NEON)
+   if (simd & RETRO_SIMD_NEON)
+   {
+      convert_run[VCT_PASS8888] = run_convert_pass8888_neon;
+      convert_run[VCT_PASS1555] = run_convert_pass1555_neon;
+      convert_run[VCT_PASSPAL] = run_convert_passpal_neon;
+      convert_run[VCT_PALTO565] = run_convert_palto565_neon;
+   }
+#else
+   (void)simd;
+#endif
+
+   convert_run_selected = true;
+}
+
+/*
+   Edge of the square blocks an XY swapped frame is converted in. Reading
+   down a column touches one cache line per source row; a block's worth of
+   lines stays cached until the neighbouring columns have been read too.
+*/
+#define CONVERT_TILE 32
+
+void mame2003_video_frame_convert(struct mame_display *display)
+{
    struct rectangle visible_area = display->game_visible_area;
    int x0 = visible_area.min_x, y0 = visible_area.min_y;
    int x1 = visible_area.max_x, y1 = visible_area.max_y;
    int w = x1 - x0 + 1, h = y1 - y0 + 1;
- 
+
    signed pitch = display->game_bitmap->rowpixels;
-   char *input = (char*)display->game_bitmap->base;
+   const char *input = (const char*)display->game_bitmap->base;
    char *output = (char*)video_buffer;
 
-   /* Pixel conversion loop macro for best possible inlining, w/o XY swap */
-   #define CONVERT_NOSWAP(CONVERT_FUNC, TYPE_IN, TYPE_OUT, FLIP_X, FLIP_Y)\
-      {\
-         signed skip;\
-         TYPE_IN *in = (TYPE_IN*)input;\
-         TYPE_OUT *out = (TYPE_OUT*)output;\
-         \
-         /* Swaps are handled by iterating over input backwards */\
-         in += (!FLIP_X ? x0 : x1) + (!FLIP_Y ? y0 * pitch : y1 * pitch);\
-         /* After each line, reset the pointer to start, then to next line */\
-         skip = (!FLIP_X ? -w : w) + (!FLIP_Y ? pitch : -pitch);\
-         \
-         for (y = 0; y < h; y++)\
-         {\
-            if (!FLIP_X)\
-               for (x = 0; x < w; x++)\
-                  CONVERT_FUNC(in++, out++);\
-            else\
-               for (x = 0; x < w; x++)\
-                  CONVERT_FUNC(in--, out++);\
-            in += skip;\
-         }\
-      }
-   
-   /* A much less optimized pixel conversion loop macro, with XY swap */
-   #define CONVERT_SWAP(CONVERT_FUNC, TYPE_IN, TYPE_OUT, FLIP_X, FLIP_Y)\
-      {\
-         TYPE_IN *in = (TYPE_IN*)input;\
-         TYPE_OUT *out = (TYPE_OUT*)output;\
-         \
-         for (x = FLIP_Y ? x1 : x0; FLIP_Y ? x >= x0 : x <= x1; x += FLIP_Y ? -1 : 1)\
-            for (y = FLIP_X ? y1 : y0; FLIP_X ? y >= y0 : y <= y1; y += FLIP_X ? -1 : 1)\
-               CONVERT_FUNC(&in[y * pitch + x], out++);\
-      }
-
-   /* Do a conversion accounting for XY flips */
-   #define CONVERT_CHOOSE(CONVERT_MACRO, CONVERT_FUNC, TYPE_IN, TYPE_OUT)\
-      {\
-         if (!flip_x && !flip_y)\
-            CONVERT_MACRO(CONVERT_FUNC, TYPE_IN, TYPE_OUT, false, false)\
-         else if (!flip_x && flip_y)\
-            CONVERT_MACRO(CONVERT_FUNC, TYPE_IN, TYPE_OUT, false, true)\
-         else if (flip_x && !flip_y)\
-            CONVERT_MACRO(CONVERT_FUNC, TYPE_IN, TYPE_OUT, true, false)\
-         else if (flip_x && flip_y)\
-            CONVERT_MACRO(CONVERT_FUNC, TYPE_IN, TYPE_OUT, true, true);\
-      }
+   convert_run_func convert;
+   const char *origin;
+   signed row_step, col_step;
+   int out_w, out_h, run, r0, c0, r;
 
-   /* Do a conversion accounting for XY swap */
-   #define CONVERT(CONVERT_FUNC, TYPE_IN, TYPE_OUT)\
-      if (!video_swap_xy)\
-         CONVERT_CHOOSE(CONVERT_NOSWAP, CONVERT_FUNC, TYPE_IN, TYPE_OUT)\
-      else\
-         CONVERT_CHOOSE(CONVERT_SWAP, CONVERT_FUNC, TYPE_IN, TYPE_OUT)
+   if (!convert_run_selected)
+      mame2003_video_select_kernels(true);
+   convert = convert_run[video_conversion_type];
 
-   switch (video_conversion_type)
+   /*
+      The output is written in raster order. origin is the input pixel that
+      lands at the top left of the output; row_step and col_step move one
+      output row or column along in the input. Flips just negate a step.
+   */
+   if (!video_swap_xy)
+   {
+      origin = input + ((video_flip_y ? y1 : y0) * pitch + (video_flip_x ? x1 : x0)) * video_stride_in;
+      row_step = video_flip_y ? -pitch : pitch;
+      col_step = video_flip_x ? -1 : 1;
+      out_w = w; out_h = h;
+   }
+   else
    {
-      case VCT_PASS8888:
-         CONVERT(pix_convert_pass8888, uint32_t, uint32_t);
-         break;
-      case VCT_PASS1555:
-         CONVERT(pix_convert_pass1555, uint16_t, uint16_t);
-         break;
-      case VCT_PASSPAL:
-         CONVERT(pix_convert_passpal, uint16_t, uint32_t);
-         break;
-      case VCT_PALTO565:
-         CONVERT(pix_convert_palto565, uint16_t, uint16_t);
-         break;
+      origin = input + ((video_flip_x ? y1 : y0) * pitch + (video_flip_y ? x1 : x0)) * video_stride_in;
+      row_step = video_flip_y ? -1 : 1;
+      col_step = video_flip_x ? -pitch : pitch;
+      out_w = h; out_h = w;
    }
+
+   /* Runs along a bitmap row take whole lines, runs down a column are tiled */
+   run = (col_step == 1 || col_step == -1) ? out_w : CONVERT_TILE;
+
+   for (r0 = 0; r0 < out_h; r0 += CONVERT_TILE)
+      for (c0 = 0; c0 < out_w; c0 += run)
+      {
+         int count = out_w - c0 < run ? out_w - c0 : run;
+         int r1 = out_h - r0 < CONVERT_TILE ? out_h : r0 + CONVERT_TILE;
+
+         for (r = r0; r < r1; r++)
+            convert(origin + (r * row_step + c0 * col_step) * (signed)video_stride_in, col_step,
+               output + (r * out_w + c0) * video_stride_out, count);
+      }
 }
 
 
@@ -389,6 +603,11 @@ const int frameskip_table[12][12] =
 int osd_skip_this_frame(void)
 {
    static unsigned frameskip_counter = 0;
+
+   /* Nothing to draw if the frontend discards the frame */
+   if (video_frame_hidden)
+      return 1;
+
    return frameskip_table[options.frameskip][frameskip_counter++ % 12];
 }
 
@@ -432,7 +651,7 @@ void osd_update_video_and_audio(struct mame_display *display)
             }
             else
             {
-               frame_convert(display);
+               mame2003_video_frame_convert(display);
                video_cb(video_buffer, vis_width, vis_height, vis_width * video_stride_out);
             }
          }
@@ -1,5 +1,6 @@
 #include "unzip.h"
 #include "driver.h"
+#include "log.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -276,6 +277,18 @@ ZIP* openzip(int pathtype, int pathindex, const char* zipfile) {
 	/* reset ent */
 	zip->ent.name = 0;
 
+	/* the index is built on the first lookup */
+	zip->index = 0;
+	zip->index_names = 0;
+	zip->index_count = 0;
+	zip->hash_mask = 0;
+	zip->name_hash = 0;
+	zip->crc_hash = 0;
+
+	/* not in the cache yet */
+	zip->cache_next = 0;
+	zip->cache_size = 0;
+
 	/* rewind */
 	zip->cd_pos = 0;
 
@@ -295,6 +308,53 @@ ZIP* openzip(int pathtype, int pathindex, const char* zipfile) {
 	return zip;
 }
 
+/* Parse the central directory entry at pos, except for the name
+   return:
+     ==0 success
+     <0 error
+*/
+static int readcent(ZIP* zip, unsigned pos, struct zipent* ent) {
+	char* cd = zip->cd + pos;
+
+	/* check that the fixed part of the entry is inside the directory */
+	if (pos + ZIPCFN > zip->size_of_cent_dir)
+	{
+		errormsg("Invalid entry in directory", ERROR_CORRUPT, zip->zip);
+		return -1;
+	}
+
+	/* compile zipent info */
+	ent->cent_file_header_sig = read_dword (cd+ZIPCENSIG);
+	ent->version_made_by = *(cd+ZIPCVER);
+	ent->host_os = *(cd+ZIPCOS);
+	ent->version_needed_to_extract = *(cd+ZIPCVXT);
+	ent->os_needed_to_extract = *(cd+ZIPCEXOS);
+	ent->general_purpose_bit_flag = read_word (cd+ZIPCFLG);
+	ent->compression_method = read_word (cd+ZIPCMTHD);
+	ent->last_mod_file_time = read_word (cd+ZIPCTIM);
+	ent->last_mod_file_date = read_word (cd+ZIPCDAT);
+	ent->crc32 = read_dword (cd+ZIPCCRC);
+	ent->compressed_size = read_dword (cd+ZIPCSIZ);
+	ent->uncompressed_size = read_dword (cd+ZIPCUNC);
+	ent->filename_length = read_word (cd+ZIPCFNL);
+	ent->extra_field_length = read_word (cd+ZIPCXTL);
+	ent->file_comment_length = read_word (cd+ZIPCCML);
+	ent->disk_number_start = read_word (cd+ZIPDSK);
+	ent->internal_file_attrib = read_word (cd+ZIPINT);
+	ent->external_file_attrib = read_dword (cd+ZIPEXT);
+	ent->offset_lcl_hdr_frm_frst_disk = read_dword (cd+ZIPOFST);
+
+	/* check to see if filename length is illegally long (past the size of this directory
+	   entry) */
+	if (pos + ZIPCFN + ent->filename_length > zip->size_of_cent_dir)
+	{
+		errormsg("Invalid filename length in directory", ERROR_CORRUPT,zip->zip);
+		return -1;
+	}
+
+	return 0;
+}
+
 /* Reads the current entry from a zip stream
    in:
      zip opened zip
@@ -308,34 +368,8 @@ struct zipent* readzip(ZIP* zip) {
 	if (zip->cd_pos >= zip->size_of_cent_dir)
 		return 0;
 
-	/* compile zipent info */
-	zip->ent.cent_file_header_sig = read_dword (zip->cd+zip->cd_pos+ZIPCENSIG);
-	zip->ent.version_made_by = *(zip->cd+zip->cd_pos+ZIPCVER);
-	zip->ent.host_os = *(zip->cd+zip->cd_pos+ZIPCOS);
-	zip->ent.version_needed_to_extract = *(zip->cd+zip->cd_pos+ZIPCVXT);
-	zip->ent.os_needed_to_extract = *(zip->cd+zip->cd_pos+ZIPCEXOS);
-	zip->ent.general_purpose_bit_flag = read_word (zip->cd+zip->cd_pos+ZIPCFLG);
-	zip->ent.compression_method = read_word (zip->cd+zip->cd_pos+ZIPCMTHD);
-	zip->ent.last_mod_file_time = read_word (zip->cd+zip->cd_pos+ZIPCTIM);
-	zip->ent.last_mod_file_date = read_word (zip->cd+zip->cd_pos+ZIPCDAT);
-	zip->ent.crc32 = read_dword (zip->cd+zip->cd_pos+ZIPCCRC);
-	zip->ent.compressed_size = read_dword (zip->cd+zip->cd_pos+ZIPCSIZ);
-	zip->ent.uncompressed_size = read_dword (zip->cd+zip->cd_pos+ZIPCUNC);
-	zip->ent.filename_length = read_word (zip->cd+zip->cd_pos+ZIPCFNL);
-	zip->ent.extra_field_length = read_word (zip->cd+zip->cd_pos+ZIPCXTL);
-	zip->ent.file_comment_length = read_word (zip->cd+zip->cd_pos+ZIPCCML);
-	zip->ent.disk_number_start = read_word (zip->cd+zip->cd_pos+ZIPDSK);
-	zip->ent.internal_file_attrib = read_word (zip->cd+zip->cd_pos+ZIPINT);
-	zip->ent.external_file_attrib = read_dword (zip->cd+zip->cd_pos+ZIPEXT);
-	zip->ent.offset_lcl_hdr_frm_frst_disk = read_dword (zip->cd+zip->cd_pos+ZIPOFST);
-
-    /* check to see if filename length is illegally long (past the size of this directory
-       entry) */
-    if (zip->cd_pos + ZIPCFN + zip->ent.filename_length > zip->size_of_cent_dir)
-    {
-        errormsg("Invalid filename length in directory", ERROR_CORRUPT,zip->zip);
-        return 0;
-    }
+	if (readcent(zip, zip->cd_pos, &zip->ent) != 0)
+		return 0;
 
 	/* copy filename */
 	free(zip->ent.name);
@@ -349,10 +383,97 @@ struct zipent* readzip(ZIP* zip) {
 	return &zip->ent;
 }
 
+/* -------------------------------------------------------------------------
+   Central directory index
+ ------------------------------------------------------------------------- */
+
+/* Hash of the name after the last /, ignoring case */
+static unsigned hash_filename(const char* name) {
+	const char* s = strrchr(name,'/');
+	unsigned hash = 2166136261U;
+	for (s = s ? s+1 : name; *s; ++s)
+		hash = (hash ^ (unsigned char)tolower(*s)) * 16777619U;
+	return hash;
+}
+
+/* Parse the whole central directory once into zip->index, with open
+   addressing hash tables by basename and by CRC. Entries are inserted in
+   directory order, so a probe finds the first of several equal keys first,
+   as a sequential readzip() scan would.
+   return:
+     ==0 success
+     <0 error
+*/
+static int buildindex(ZIP* zip) {
+	unsigned count = zip->total_entries_cent_dir;
+	unsigned size, pos, i;
+	char* names;
+
+	if (zip->index)
+		return 0;
+
+	/* table size is a power of 2 at least twice the number of entries */
+	for (size = 16; size < count * 2; size <<= 1)
+		;
+
+	/* every directory record is longer than its name plus a terminator */
+	zip->index = (struct zipent*)malloc(count * sizeof(struct zipent));
+	zip->index_names = (char*)malloc(zip->size_of_cent_dir);
+	zip->name_hash = (int*)malloc(size * sizeof(int));
+	zip->crc_hash = (int*)malloc(size * sizeof(int));
+	if (!zip->index || !zip->index_names || !zip->name_hash || !zip->crc_hash)
+		goto fail;
+	memset(zip->name_hash, 0xff, size * sizeof(int));
+	memset(zip->crc_hash, 0xff, size * sizeof(int));
+	zip->hash_mask = size - 1;
+
+	names = zip->index_names;
+	for (i = 0, pos = 0; i < count && pos < zip->size_of_cent_dir; ++i) {
+		struct zipent* ent = &zip->index[i];
+		unsigned slot;
+
+		if (readcent(zip, pos, ent) != 0)
+			goto fail;
+
+		ent->name = names;
+		memcpy(names, zip->cd+pos+ZIPCFN, ent->filename_length);
+		names[ent->filename_length] = 0;
+		names += ent->filename_length + 1;
+
+		pos += ZIPCFN + ent->filename_length + ent->extra_field_length + ent->file_comment_length;
+
+		for (slot = hash_filename(ent->name) & zip->hash_mask; zip->name_hash[slot] >= 0; slot = (slot + 1) & zip->hash_mask)
+			;
+		zip->name_hash[slot] = i;
+
+		for (slot = ent->crc32 & zip->hash_mask; zip->crc_hash[slot] >= 0; slot = (slot + 1) & zip->hash_mask)
+			;
+		zip->crc_hash[slot] = i;
+	}
+	zip->index_count = i;
+
+	return 0;
+
+fail:
+	free(zip->index);
+	free(zip->index_names);
+	free(zip->name_hash);
+	free(zip->crc_hash);
+	zip->index = 0;
+	zip->index_names = 0;
+	zip->name_hash = 0;
+	zip->crc_hash = 0;
+	return -1;
+}
+
 /* Closes a zip stream */
 void closezip(ZIP* zip) {
 	/* release all */
 	free(zip->ent.name);
+	free(zip->index);
+	free(zip->index_names);
+	free(zip->name_hash);
+	free(zip->crc_hash);
 	free(zip->cd);
 	free(zip->ecd);
 	/* only if not suspended */
@@ -532,6 +653,64 @@ static int inflate_file(FILE* in_file, unsigned in_size, unsigned char* out_data
 	return 0;
 }
 
+/* Inflate a buffer
+   in:
+   in_data compressed data, followed by one spare byte for zlib
+   in_size size of the compressed data
+   out_size size of decompressed data
+   out:
+   out_data buffer for decompressed data
+   return:
+   ==0 ok
+*/
+static int inflate_buffer(unsigned char* in_data, unsigned in_size, unsigned char* out_data, unsigned out_size)
+{
+	int err;
+	z_stream d_stream; /* decompression stream */
+
+	d_stream.zalloc = 0;
+	d_stream.zfree = 0;
+	d_stream.opaque = 0;
+
+	/* add dummy byte at end of compressed data, see inflate_file() */
+	in_data[in_size] = 0;
+	d_stream.next_in  = in_data;
+	d_stream.avail_in = in_size + 1;
+
+	d_stream.next_out = out_data;
+	d_stream.avail_out = out_size;
+
+	err = inflateInit2(&d_stream, -MAX_WBITS);
+	if (err != Z_OK)
+	{
+		log_cb(RETRO_LOG_ERROR, LOGPRE "inflateInit error: %d\n", err);
+		return -1;
+	}
+
+	err = inflate(&d_stream, Z_FINISH);
+	if (err != Z_STREAM_END)
+	{
+		log_cb(RETRO_LOG_ERROR, LOGPRE "inflate error: %d\n", err);
+		inflateEnd(&d_stream);
+		return -1;
+	}
+
+	err = inflateEnd(&d_stream);
+	if (err != Z_OK)
+	{
+		log_cb(RETRO_LOG_ERROR, LOGPRE "inflateEnd error: %d\n", err);
+		return -1;
+	}
+
+	if (d_stream.avail_out > 0)
+	{
+		log_cb(RETRO_LOG_ERROR, LOGPRE "zip size mismatch. %i\n", d_stream.avail_out);
+		return -1;
+	}
+
+	return 0;
+}
+
 /* Read compressed data
    out:
 	data compressed data read
@@ -552,6 +731,30 @@ int readcompresszip(ZIP* zip, struct zipent* ent, char* data) {
 	return 0;
 }
 
+/* Check that a "Deflate" entry can be inflated
+   return:
+	==0 success
+	<0 error
+*/
+static int checkdeflatezip(ZIP* zip, struct zipent* ent) {
+	if (ent->version_needed_to_extract > 0x14) {
+		errormsg("Version too new", ERROR_UNSUPPORTED,zip->zip);
+		return -2;
+	}
+
+	if (ent->os_needed_to_extract != 0x00) {
+		errormsg("OS not supported", ERROR_UNSUPPORTED,zip->zip);
+		return -2;
+	}
+
+	if (ent->disk_number_start != zip->number_of_this_disk) {
+		errormsg("Cannot span disks", ERROR_UNSUPPORTED,zip->zip);
+		return -2;
+	}
+
+	return 0;
+}
+
 /* Read UNcompressed data
    out:
 	data UNcompressed data
@@ -572,20 +775,9 @@ int readuncompresszip(ZIP* zip, struct zipent* ent, char* data) {
 		return readcompresszip(zip,ent,data);
 	} else if (ent->compression_method == 0x0008) {
 		/* file is compressed using "Deflate" method */
-		if (ent->version_needed_to_extract > 0x14) {
-			errormsg("Version too new", ERROR_UNSUPPORTED,zip->zip);
-			return -2;
-		}
-
-		if (ent->os_needed_to_extract != 0x00) {
-			errormsg("OS not supported", ERROR_UNSUPPORTED,zip->zip);
-			return -2;
-		}
-
-		if (ent->disk_number_start != zip->number_of_this_disk) {
-			errormsg("Cannot span disks", ERROR_UNSUPPORTED,zip->zip);
-			return -2;
-		}
+		int err = checkdeflatezip(zip,ent);
+		if (err!=0)
+			return err;
 
 		/* read compressed data */
 		if (seekcompresszip(zip,ent)!=0) {
@@ -613,94 +805,129 @@ int readuncompresszip(ZIP* zip, struct zipent* ent, char* data) {
 /* Use the zip cache */
 #define ZIP_CACHE
 
+/* Held around everything that touches the cache or an open ZIP, when ROMs
+   are loaded from several threads */
+static struct osd_lock* zip_lock;
+
+/* Make the zip functions safe to call from several threads
+   in:
+     threaded !=0 before starting the threads, ==0 after they are done
+*/
+void unzip_set_threaded(int threaded) {
+	if (threaded && !zip_lock)
+		zip_lock = osd_lock_alloc();
+	else if (!threaded && zip_lock) {
+		osd_lock_free(zip_lock);
+		zip_lock = 0;
+	}
+}
+
 #ifdef ZIP_CACHE
 
-/* ZIP cache entries */
-#define ZIP_CACHE_MAX 5
+/* The cache is bounded by the memory held by the parsed directories, not
+   by a number of archives, so a clone, its parent, the BIOS and the samples
+   zip all stay resident through the load. File handles are kept open too,
+   up to a limit, until unzip_cache_suspend() */
+#define ZIP_CACHE_MAX_SIZE		(4 * 1024 * 1024)
+#define ZIP_CACHE_MAX_HANDLES	8
 
-/* ZIP cache buffer LRU ( Last Recently Used )
-     zip_cache_map[0] is the newer
-     zip_cache_map[ZIP_CACHE_MAX-1] is the older
+/* ZIP cache list LRU ( Last Recently Used ), linked through cache_next
+     zip_cache_first is the newer
+     the last one is the older
 */
-static ZIP* zip_cache_map[ZIP_CACHE_MAX];
+static ZIP* zip_cache_first;
+static size_t zip_cache_size;
+
+/* Memory held by an open zip */
+static size_t zip_memory(ZIP* zip) {
+	size_t size = sizeof(ZIP) + zip->ecd_length + zip->size_of_cent_dir + strlen(zip->zip) + 1;
+	if (zip->index)
+		size += zip->total_entries_cent_dir * sizeof(struct zipent) + zip->size_of_cent_dir +
+			2 * (zip->hash_mask + 1) * sizeof(int);
+	return size;
+}
 
-static ZIP* cache_openzip(int pathtype, int pathindex, const char* zipfile) {
-	ZIP* zip;
-	unsigned i;
+/* Unlink a zip from the cache list */
+static void cache_unlink(ZIP* zip) {
+	ZIP** link;
 
-	/* search in the cache buffer */
-	for(i=0;i<ZIP_CACHE_MAX;++i) {
-		if (zip_cache_map[i] && zip_cache_map[i]->pathtype == pathtype && zip_cache_map[i]->pathindex == pathindex && strcmp(zip_cache_map[i]->zip,zipfile)==0) {
-			/* found */
-			unsigned j;
+	for (link = &zip_cache_first; *link; link = &(*link)->cache_next)
+		if (*link == zip) {
+			*link = zip->cache_next;
+			zip->cache_next = 0;
+			zip_cache_size -= zip->cache_size;
+			return;
+		}
+}
 
-/*
-			log_cb(RETRO_LOG_ERROR, LOGPRE "Zip cache HIT  for %s\n", zipfile);
-*/
+/* Close the oldest zips until the cache fits, and the oldest handles until
+   few enough are open; the newest zip is always kept */
+static void cache_trim(void) {
+	ZIP* zip;
+	unsigned handles = 0;
+
+	while (zip_cache_size > ZIP_CACHE_MAX_SIZE && zip_cache_first->cache_next) {
+		for (zip = zip_cache_first; zip->cache_next; zip = zip->cache_next)
+			;
+		log_trace(FILEIO, (RETRO_LOG_DEBUG, LOGPRE "Zip cache evicting %s\n", zip->zip));
+		cache_unlink(zip);
+		closezip(zip);
+	}
 
-			/* reset the zip directory */
-			rewindzip( zip_cache_map[i] );
+	for (zip = zip_cache_first; zip; zip = zip->cache_next)
+		if (zip->fp && ++handles > ZIP_CACHE_MAX_HANDLES)
+			suspendzip(zip);
+}
 
-			/* store */
-			zip = zip_cache_map[i];
+static ZIP* cache_openzip(int pathtype, int pathindex, const char* zipfile) {
+	ZIP* zip;
 
-			/* shift */
-			for(j=i;j>0;--j)
-				zip_cache_map[j] = zip_cache_map[j-1];
+	/* search in the cache list */
+	for (zip = zip_cache_first; zip; zip = zip->cache_next) {
+		if (zip->pathtype == pathtype && zip->pathindex == pathindex && strcmp(zip->zip,zipfile)==0) {
+			/* found */
+			log_trace(FILEIO, (RETRO_LOG_DEBUG, LOGPRE "Zip cache HIT  for %s\n", zipfile));
 
-			/* set the first entry */
-			zip_cache_map[0] = zip;
+			/* reset the zip directory */
+			rewindzip(zip);
+
+			/* move to the front */
+			if (zip != zip_cache_first) {
+				cache_unlink(zip);
+				zip->cache_next = zip_cache_first;
+				zip_cache_first = zip;
+				zip_cache_size += zip->cache_size;
+			}
 
-			return zip_cache_map[0];
+			return zip;
 		}
 	}
 	/* not found */
 
-/*
-	log_cb(RETRO_LOG_ERROR, LOGPRE "Zip cache FAIL for %s\n", zipfile);
-*/
+	log_trace(FILEIO, (RETRO_LOG_DEBUG, LOGPRE "Zip cache FAIL for %s\n", zipfile));
 
-	/* open the zip */
+	/* open the zip, and index it now so its size is known */
 	zip = openzip( pathtype, pathindex, zipfile );
 	if (!zip)
 		return 0;
-
-	/* close the oldest entry */
-	if (zip_cache_map[ZIP_CACHE_MAX-1]) {
-		/* close last zip */
-		closezip(zip_cache_map[ZIP_CACHE_MAX-1]);
-		/* reset the entry */
-		zip_cache_map[ZIP_CACHE_MAX-1] = 0;
+	if (buildindex(zip) != 0) {
+		closezip(zip);
+		return 0;
 	}
 
-	/* shift */
-	for(i=ZIP_CACHE_MAX-1;i>0;--i)
-		zip_cache_map[i] = zip_cache_map[i-1];
+	/* add it at the front, and make room for it */
+	zip->cache_size = zip_memory(zip);
+	zip->cache_next = zip_cache_first;
+	zip_cache_first = zip;
+	zip_cache_size += zip->cache_size;
+	cache_trim();
 
-	/* set the first entry */
-	zip_cache_map[0] = zip;
-
-	return zip_cache_map[0];
+	return zip;
 }
 
 static void cache_closezip(ZIP* zip) {
-	unsigned i;
-
-	/* search in the cache buffer */
-	for(i=0;i<ZIP_CACHE_MAX;++i) {
-		if (zip_cache_map[i]==zip) {
-			/* close zip */
-			closezip(zip);
-
-			/* reset cache entry */
-			zip_cache_map[i] = 0;
-			return;
-
-		}
-	}
-	/* not found */
-
-	/* close zip */
+	/* remove from the cache list, if it's there, and close */
+	cache_unlink(zip);
 	closezip(zip);
 }
 
@@ -708,23 +935,31 @@ static void cache_closezip(ZIP* zip) {
    the user opens up an audit for a game we should reread the zip */
 void unzip_cache_clear()
 {
-	unsigned i;
+	osd_lock_acquire(zip_lock);
 
-	/* search in the cache buffer for any zip info and clear it */
-	for(i=0;i<ZIP_CACHE_MAX;++i) {
-		if (zip_cache_map[i] != NULL) {
-			/* close zip */
-			closezip(zip_cache_map[i]);
+	/* close every zip in the cache */
+	while (zip_cache_first)
+		cache_closezip(zip_cache_first);
 
-			/* reset cache entry */
-			zip_cache_map[i] = 0;
-/*			return; */
+	osd_lock_release(zip_lock);
+}
 
-		}
-	}
+/* Close the file handles held by the cache, keeping the directories; they
+   are reopened as needed */
+void unzip_cache_suspend(void)
+{
+	ZIP* zip;
+
+	osd_lock_acquire(zip_lock);
+
+	for (zip = zip_cache_first; zip; zip = zip->cache_next)
+		suspendzip(zip);
+
+	osd_lock_release(zip_lock);
 }
 
-#define cache_suspendzip(a) suspendzip(a)
+/* handles stay open, cache_trim() limits how many */
+#define cache_suspendzip(a)
 
 #else
 
@@ -732,7 +967,8 @@ void unzip_cache_clear()
 #define cache_closezip(a) closezip(a)
 #define cache_suspendzip(a) closezip(a)
 
-#define unzip_cache_clear()
+void unzip_cache_clear(void) { }
+void unzip_cache_suspend(void) { }
 
 #endif
 
@@ -759,49 +995,159 @@ static int equal_filename(const char* zipfile, const char* file) {
 	return !*s1 && !*s2;
 }
 
+/* Look up an entry by name in the index
+   return:
+     ==-1 not found
+     >=0 position of the first matching entry in the directory
+*/
+static int find_by_name(ZIP* zip, const char* filename) {
+	unsigned slot;
+
+	for (slot = hash_filename(filename) & zip->hash_mask; zip->name_hash[slot] >= 0; slot = (slot + 1) & zip->hash_mask)
+		if (equal_filename(zip->index[zip->name_hash[slot]].name, filename))
+			return zip->name_hash[slot];
+	return -1;
+}
+
+/* Look up an entry by CRC in the index
+   return:
+     ==-1 not found
+     >=0 position of the first matching entry in the directory
+*/
+static int find_by_crc(ZIP* zip, UINT32 crc) {
+	unsigned slot;
+
+	for (slot = crc & zip->hash_mask; zip->crc_hash[slot] >= 0; slot = (slot + 1) & zip->hash_mask)
+		if (zip->index[zip->crc_hash[slot]].crc32 == crc)
+			return zip->crc_hash[slot];
+	return -1;
+}
+
+/* NS981003: support for "load by CRC", the filename is the CRC as "%08x"
+   return:
+     ==0 not a CRC
+     !=0 success, *crc valid
+*/
+static int filename_crc(const char* filename, UINT32* crc) {
+	unsigned i;
+
+	*crc = 0;
+	for (i = 0; i < 8; ++i) {
+		char c = filename[i];
+		if (c >= '0' && c <= '9')
+			*crc = (*crc << 4) | (c - '0');
+		else if (c >= 'a' && c <= 'f')
+			*crc = (*crc << 4) | (c - 'a' + 10);
+		else
+			return 0;
+	}
+	return filename[8] == 0;
+}
+
 /* Pass the path to the zipfile and the name of the file within the zipfile.
    buf will be set to point to the uncompressed image of that zipped file.
-   length will be set to the length of the uncompressed data. */
-int /* error */ load_zipped_file (int pathtype, int pathindex, const char* zipfile, const char* filename, unsigned char** buf, unsigned int* length) {
+   length will be set to the length of the uncompressed data.
+   crc will be set to the CRC-32 the zip directory records for it.
+   mapped will be set if buf is mapped from the zip (stored entries), it
+   must then be released with osd_unmap_file() rather than free(). */
+int /* error */ load_zipped_file (int pathtype, int pathindex, const char* zipfile, const char* filename, unsigned char** buf, unsigned int* length, unsigned int* crc, int* mapped) {
 	ZIP* zip;
-	struct zipent* ent;
+	struct zipent ent;
+	char* compressed = 0;
+	UINT32 namecrc;
+	int found, err;
+
+	*mapped = 0;
+
+	osd_lock_acquire(zip_lock);
 
 	zip = cache_openzip(pathtype, pathindex, zipfile);
-	if (!zip)
+	if (!zip) {
+		osd_lock_release(zip_lock);
 		return -1;
+	}
 
-	while (readzip(zip)) {
-		/* NS981003: support for "load by CRC" */
-		char crc[9];
+	if (buildindex(zip) != 0) {
+		cache_closezip(zip);
+		osd_lock_release(zip_lock);
+		return -1;
+	}
 
-		ent = &(zip->ent);
+	/* the first entry matching either the name or the CRC, like a directory scan */
+	found = find_by_name(zip, filename);
+	if (filename_crc(filename, &namecrc) && namecrc) {
+		int bycrc = find_by_crc(zip, namecrc);
+		if (bycrc >= 0 && (found < 0 || bycrc < found))
+			found = bycrc;
+	}
 
-		sprintf(crc,"%08x",ent->crc32);
-		if (equal_filename(ent->name, filename) ||
-				(ent->crc32 && !strcmp(crc, filename)))
-		{
-			*length = ent->uncompressed_size;
-			*buf = (unsigned char*)malloc( *length );
-			if (!*buf) {
-				if (!gUnzipQuiet)
-					log_cb(RETRO_LOG_ERROR, LOGPRE "load_zipped_file(): Unable to allocate %d bytes of RAM\n",*length);
-				cache_closezip(zip);
-				return -1;
-			}
+	if (found < 0) {
+		cache_suspendzip(zip);
+		osd_lock_release(zip_lock);
+		return -1;
+	}
 
-			if (readuncompresszip(zip, ent, (char*)*buf)!=0) {
-				free(*buf);
-				cache_closezip(zip);
-				return -1;
-			}
+	/* copy the entry, the zip can leave the cache once it is unlocked */
+	ent = zip->index[found];
+
+	*length = ent.uncompressed_size;
+	*crc = ent.crc32;
 
+	/* a stored entry is mapped straight from the zip where the platform allows */
+	if (ent.compression_method == 0x0000 && ent.compressed_size == ent.uncompressed_size &&
+			seekcompresszip(zip, &ent) == 0) {
+		*buf = osd_map_file(zip->fp, ftell(zip->fp), *length);
+		if (*buf) {
+			*mapped = 1;
 			cache_suspendzip(zip);
+			osd_lock_release(zip_lock);
 			return 0;
 		}
 	}
 
+	*buf = (unsigned char*)malloc( *length );
+	if (!*buf) {
+		if (!gUnzipQuiet)
+			log_cb(RETRO_LOG_ERROR, LOGPRE "load_zipped_file(): Unable to allocate %d bytes of RAM\n",*length);
+		cache_closezip(zip);
+		osd_lock_release(zip_lock);
+		return -1;
+	}
+
+	/* deflated data is only read while locked and inflated afterwards, so
+	   several threads can decompress at once */
+	if (ent.compression_method == 0x0008) {
+		err = checkdeflatezip(zip, &ent);
+		if (err == 0) {
+			compressed = (char*)malloc(ent.compressed_size + 1);
+			err = compressed ? readcompresszip(zip, &ent, compressed) : -1;
+		}
+	}
+	else
+		err = readuncompresszip(zip, &ent, (char*)*buf);
+
+	if (err != 0) {
+		free(compressed);
+		free(*buf);
+		cache_closezip(zip);
+		osd_lock_release(zip_lock);
+		return -1;
+	}
+
 	cache_suspendzip(zip);
-	return -1;
+	osd_lock_release(zip_lock);
+
+	if (compressed) {
+		err = inflate_buffer((unsigned char*)compressed, ent.compressed_size, *buf, *length);
+		free(compressed);
+		if (err != 0) {
+			errormsg("Inflating compressed data", ERROR_CORRUPT, zipfile);
+			free(*buf);
+			return -1;
+		}
+	}
+
+	return 0;
 }
 
 /*	Pass the path to the zipfile and the name of the file within the zipfile.
@@ -809,43 +1155,36 @@ int /* error */ load_zipped_file (int pathtype, int pathindex, const char* zipfi
 /*  The caller can preset sum to the expected checksum to enable "load by CRC" */
 int /* error */ checksum_zipped_file (int pathtype, int pathindex, const char *zipfile, const char *filename, unsigned int *length, unsigned int *sum) {
 	ZIP* zip;
-	struct zipent* ent;
+	int found;
+
+	osd_lock_acquire(zip_lock);
 
 	zip = cache_openzip(pathtype, pathindex, zipfile);
-	if (!zip)
+	if (!zip) {
+		osd_lock_release(zip_lock);
 		return -1;
-
-	while (readzip(zip)) {
-		ent = &(zip->ent);
-
-		if (equal_filename(ent->name, filename))
-		{
-			*length = ent->uncompressed_size;
-			*sum = ent->crc32;
-			cache_suspendzip(zip);
-			return 0;
-		}
 	}
 
-	cache_suspendzip(zip);
-
-	/* NS981003: support for "load by CRC" */
-	zip = cache_openzip(pathtype, pathindex, zipfile);
-	if (!zip)
+	if (buildindex(zip) != 0) {
+		cache_closezip(zip);
+		osd_lock_release(zip_lock);
 		return -1;
+	}
 
-	while (readzip(zip)) {
-		ent = &(zip->ent);
+	/* by name first, then NS981003: support for "load by CRC" */
+	found = find_by_name(zip, filename);
+	if (found < 0 && *sum)
+		found = find_by_crc(zip, *sum);
 
-		if (*sum && ent->crc32 == *sum)
-		{
-			*length = ent->uncompressed_size;
-			*sum = ent->crc32;
-			cache_suspendzip(zip);
-			return 0;
-		}
+	if (found >= 0) {
+		*length = zip->index[found].uncompressed_size;
+		*sum = zip->index[found].crc32;
+		cache_suspendzip(zip);
+		osd_lock_release(zip_lock);
+		return 0;
 	}
 
 	cache_suspendzip(zip);
+	osd_lock_release(zip_lock);
 	return -1;
 }
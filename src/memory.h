@@ -114,6 +114,20 @@ struct ExtMemory
     UINT8 *			data;
 };
 
+/* ----- direct data access ----- */
+/* a run of RAM, ROM or bank memory that data reads or writes can reach */
+/* with one range check instead of the lookup tables; kept per CPU */
+#define MEMORY_DIRECT_SLOTS		4						/* runs kept for each of reads and writes */
+#define MEMORY_DIRECT_PAGES		256						/* 1st level pages a run extends over in each direction */
+
+struct memory_direct
+{
+	offs_t			min;			/* first address of the run */
+	offs_t			span;			/* number of addresses a 32-bit access can start at; 0 if empty */
+	UINT8 *			base;			/* base[address] is the memory at address */
+	UINT8			entry;			/* lookup table entry the run belongs to */
+};
+
 
 
 /***************************************************************************
@@ -677,7 +691,9 @@ void     cpu_setopbase##abits              (offs_t pc);
 
 #define DECLARE_MEM_HANDLERS_16BIT_BE(abits) \
 DECLARE_HANDLERS_16BIT_BE(mem, abits) \
-void     cpu_setopbase##abits##bew         (offs_t pc);
+void     cpu_setopbase##abits##bew         (offs_t pc);					\
+UINT8 *  cpu_setdirectread##abits##bew     (offs_t offset);				\
+UINT8 *  cpu_setdirectwrite##abits##bew    (offs_t offset);
 
 #define DECLARE_MEM_HANDLERS_16BIT_LE(abits) \
 DECLARE_HANDLERS_16BIT_LE(mem, abits) \
@@ -810,11 +826,17 @@ void		memory_set_context(int activecpu);
 void		memory_set_unmap_value(data32_t value);
 
 /* ----- dynamic bank handlers ----- */
+void		memory_set_bankptr(int bank, void *base);
 void		memory_set_bankhandler_r(int bank, offs_t offset, mem_read_handler handler);
 void		memory_set_bankhandler_w(int bank, offs_t offset, mem_write_handler handler);
 
 /* ----- opcode base control ---- */
 opbase_handler memory_set_opbase_handler(int cpunum, opbase_handler function);
+void		memory_invalidate_opcodes(int cpunum, offs_t start, offs_t end);
+int			memory_get_stale_opcodes(int cpunum, offs_t *start, offs_t *end);
+
+/* ----- direct data access control ---- */
+void		memory_direct_invalidate(int bank);
 
 /* ----- separate opcode/data encryption helpers ---- */
 void		memory_set_opcode_base(int cpunum, void *base);
@@ -858,6 +880,8 @@ extern offs_t			OP_MEM_MAX;			/* opcode memory maximum */
 extern UINT8 *			cpu_bankbase[];		/* array of bank bases */
 extern UINT8 *			readmem_lookup;		/* pointer to the readmem lookup table */
 extern offs_t			mem_amask;			/* memory address mask */
+extern struct memory_direct memory_direct_read[];	/* current CPU's direct read runs */
+extern struct memory_direct memory_direct_write[];	/* current CPU's direct write runs */
 extern struct ExtMemory	ext_memory[];		/* externally-allocated memory */
 
 
@@ -930,18 +954,24 @@ do {																					\
 /* ----- forces the next branch to generate a call to the opbase handler ----- */
 #define catch_nextBranch()			(opcode_entry = 0xff)
 
+/* ----- direct data access ----- */
+/* returns base such that base[offset] is the memory at the (masked, aligned) */
+/* offset, or NULL if it isn't in one of the current CPU's runs; the runs are */
+/* filled by cpu_setdirectreadXX()/cpu_setdirectwriteXX() */
+static INLINE UINT8 *memory_direct_lookup(const struct memory_direct *direct, offs_t offset)
+{
+	int i;
+	for (i = 0; i < MEMORY_DIRECT_SLOTS; i++)
+		if ((offs_t)(offset - direct[i].min) < direct[i].span)
+			return direct[i].base;
+	return NULL;
+}
+
 /* ----- bank switching macro ----- */
 #define cpu_setbank(bank, base) 														\
 do {																					\
 	if (bank >= STATIC_BANK1 && bank <= STATIC_BANKMAX)									\
-	{																					\
-		cpu_bankbase[bank] = (UINT8 *)(base);											\
-		if (opcode_entry == bank && cpu_getactivecpu() >= 0)							\
-		{																				\
-			opcode_entry = 0xff;														\
-			activecpu_set_op_base(activecpu_get_pc_byte());											\
-		}																				\
-	}																					\
+		memory_set_bankptr(bank, base);													\
 } while (0)
 
 
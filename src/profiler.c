@@ -1,3 +1,309 @@
+/***************************************************************************
+
+	profiler.c
+
+	Hot-path profiler. The profiler_mark() calls scattered through the
+	core are always compiled in; while the profiler is off each one is a
+	single test of profiler_active. When it is on, time between marks is
+	accumulated per section (exclusive of nested sections) and every
+	frame is closed out into a small ring buffer, and optionally written
+	to a CSV or JSON lines trace in the save folder.
+
+***************************************************************************/
+
 #include "driver.h"
 #include "osd_cpu.h"
+#include "fileio.h"
+#include "log.h"
+
+
+#define FILO_DEPTH		16
+
+
+int profiler_active;
+
+static int profiler_mode;
+
+/* FILO list of the sections currently open */
+static int FILO_type[FILO_DEPTH];
+static cycles_t FILO_start[FILO_DEPTH];
+static int FILO_length;
+
+/* the frame being collected, and the completed ones */
+static struct profiler_frame current;
+static struct profiler_frame history[PROFILER_HISTORY];
+static UINT32 frames_completed;
+
+static mame_file *trace_file;
+
+static const char *profiler_names[PROFILER_TOTAL] =
+{
+	"cpu1",
+	"cpu2",
+	"cpu3",
+	"cpu4",
+	"cpu5",
+	"cpu6",
+	"cpu7",
+	"cpu8",
+	"memread",
+	"memwrite",
+	"video",
+	"drawgfx",
+	"copybitmap",
+	"tilemap_draw",
+	"tilemap_draw_roz",
+	"tilemap_update",
+	"artwork",
+	"blit",
+	"sound",
+	"mixer",
+	"timer_callback",
+	"hiscore",
+	"input",
+	"extra",
+	"user1",
+	"user2",
+	"user3",
+	"user4",
+	"profiler",
+	"idle"
+};
+
+
+
+/*-------------------------------------------------
+	profiler__mark - open or close a section
+-------------------------------------------------*/
+
+void profiler__mark(int type)
+{
+	cycles_t curr_cycles;
+
+	if (type >= PROFILER_CPU1 && type <= PROFILER_CPU8)
+		current.context_switches++;
+
+	curr_cycles = osd_profiling_ticks();
+
+	if (type != PROFILER_END)
+	{
+		if (FILO_length >= FILO_DEPTH)
+		{
+			log_cb(RETRO_LOG_ERROR, LOGPRE "Profiler error: FILO buffer overflow\n");
+			return;
+		}
+
+		/* charge the section we are nested in up to now */
+		if (FILO_length > 0)
+			current.count[FILO_type[FILO_length - 1]] += curr_cycles - FILO_start[FILO_length - 1];
+
+		FILO_type[FILO_length] = type;
+		FILO_start[FILO_length] = curr_cycles;
+		FILO_length++;
+	}
+	else
+	{
+		if (FILO_length <= 0)
+		{
+			log_cb(RETRO_LOG_ERROR, LOGPRE "Profiler error: FILO buffer underflow\n");
+			return;
+		}
+
+		FILO_length--;
+		current.count[FILO_type[FILO_length]] += curr_cycles - FILO_start[FILO_length];
+
+		/* resume the section we were nested in */
+		if (FILO_length > 0)
+			FILO_start[FILO_length - 1] = curr_cycles;
+	}
+}
+
+
+
+/*-------------------------------------------------
+	trace output
+-------------------------------------------------*/
+
+static void trace_open(int mode)
+{
+	char filename[256];
+	char line[1024];
+	int len, i;
+
+	snprintf(filename, sizeof(filename), "%s.%s", Machine->gamedrv->name, (mode == PROFILER_MODE_CSV) ? "csv" : "json");
+	trace_file = mame_fopen(NULL, filename, FILETYPE_PROFILE, 1);
+	if (!trace_file)
+	{
+		log_cb(RETRO_LOG_WARN, LOGPRE "Profiler: unable to create trace file %s\n", filename);
+		return;
+	}
+	log_cb(RETRO_LOG_INFO, LOGPRE "Profiler: writing trace to %s\n", filename);
+
+	/* CSV gets a header row; JSON lines are self-describing */
+	if (mode == PROFILER_MODE_CSV)
+	{
+		len = snprintf(line, sizeof(line), "frame,context_switches,total");
+		for (i = 0; i < PROFILER_TOTAL; i++)
+			len += snprintf(&line[len], sizeof(line) - len, ",%s", profiler_names[i]);
+		len += snprintf(&line[len], sizeof(line) - len, "\n");
+		mame_fwrite(trace_file, line, len);
+	}
+}
+
+
+static void trace_write(const struct profiler_frame *frame)
+{
+	char line[2048];
+	int len, i;
+
+	if (profiler_mode == PROFILER_MODE_CSV)
+	{
+		len = snprintf(line, sizeof(line), "%u,%u,%llu", frame->frame, frame->context_switches, (unsigned long long)frame->total);
+		for (i = 0; i < PROFILER_TOTAL; i++)
+			len += snprintf(&line[len], sizeof(line) - len, ",%llu", (unsigned long long)frame->count[i]);
+		len += snprintf(&line[len], sizeof(line) - len, "\n");
+	}
+	else
+	{
+		/* only sections that were entered this frame are listed */
+		len = snprintf(line, sizeof(line), "{\"frame\":%u,\"context_switches\":%u,\"total\":%llu,\"sections\":{",
+				frame->frame, frame->context_switches, (unsigned long long)frame->total);
+		for (i = 0; i < PROFILER_TOTAL; i++)
+			if (frame->count[i])
+				len += snprintf(&line[len], sizeof(line) - len, "%s\"%s\":%llu",
+						(line[len - 1] == '{') ? "" : ",", profiler_names[i], (unsigned long long)frame->count[i]);
+		len += snprintf(&line[len], sizeof(line) - len, "}}\n");
+	}
+
+	mame_fwrite(trace_file, line, len);
+}
+
+
+
+/*-------------------------------------------------
+	profiler_start - begin collecting in the
+	mode selected by the core option
+-------------------------------------------------*/
+
+void profiler_start(void)
+{
+	profiler_mode = options.profiler;
+	if (profiler_mode == PROFILER_MODE_OFF)
+		return;
+
+	memset(&current, 0, sizeof(current));
+	memset(history, 0, sizeof(history));
+	frames_completed = 0;
+	FILO_length = 0;
+
+	if (profiler_mode == PROFILER_MODE_CSV || profiler_mode == PROFILER_MODE_JSON)
+		trace_open(profiler_mode);
+
+	profiler_active = 1;
+}
+
+
+
+/*-------------------------------------------------
+	profiler_stop - stop collecting and close
+	the trace, if any
+-------------------------------------------------*/
+
+void profiler_stop(void)
+{
+	profiler_active = 0;
+	profiler_mode = PROFILER_MODE_OFF;
+	FILO_length = 0;
+
+	if (trace_file)
+	{
+		mame_fclose(trace_file);
+		trace_file = NULL;
+	}
+}
+
+
+
+/*-------------------------------------------------
+	profiler_frame_begin - called at the top of
+	each emulated frame; anything not covered by
+	a more specific section counts as extra
+-------------------------------------------------*/
+
+void profiler_frame_begin(void)
+{
+	/* follow changes to the core option */
+	if (options.profiler != profiler_mode)
+	{
+		profiler_stop();
+		profiler_start();
+	}
+
+	profiler_mark(PROFILER_EXTRA);
+}
+
+
+
+/*-------------------------------------------------
+	profiler_frame_end - close out the frame into
+	the ring buffer and the trace
+-------------------------------------------------*/
+
+void profiler_frame_end(void)
+{
+	struct profiler_frame *frame;
+	int i;
+
+	if (!profiler_active)
+		return;
+
+	profiler_mark(PROFILER_END);
+
+	/* anything still open is charged up to now and carried into the next frame */
+	if (FILO_length > 0)
+	{
+		cycles_t curr_cycles = osd_profiling_ticks();
+		current.count[FILO_type[FILO_length - 1]] += curr_cycles - FILO_start[FILO_length - 1];
+		FILO_start[FILO_length - 1] = curr_cycles;
+	}
+
+	current.frame = frames_completed;
+	current.total = 0;
+	for (i = 0; i < PROFILER_TOTAL; i++)
+		current.total += current.count[i];
+
+	frame = &history[frames_completed++ & (PROFILER_HISTORY - 1)];
+	*frame = current;
+	memset(&current, 0, sizeof(current));
+
+	if (trace_file)
+		trace_write(frame);
+}
+
+
+
+/*-------------------------------------------------
+	profiler_get_frame - return a completed frame
+	from the ring buffer, or NULL
+-------------------------------------------------*/
+
+const struct profiler_frame *profiler_get_frame(int age)
+{
+	if (age < 0 || age >= PROFILER_HISTORY || (UINT32)age >= frames_completed)
+		return NULL;
+	return &history[(frames_completed - 1 - age) & (PROFILER_HISTORY - 1)];
+}
+
+
+
+/*-------------------------------------------------
+	profiler_get_name - section name as used in
+	the trace output
+-------------------------------------------------*/
 
+const char *profiler_get_name(int type)
+{
+	if (type < 0 || type >= PROFILER_TOTAL)
+		return NULL;
+	return profiler_names[type];
+}
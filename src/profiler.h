@@ -42,6 +42,28 @@ enum {
 };
 
 
+/* profiler modes, selected through the core option */
+enum {
+	PROFILER_MODE_OFF = 0,	/* marks are compiled in but return immediately */
+	PROFILER_MODE_ON,		/* collect per-frame counts into the ring buffer */
+	PROFILER_MODE_CSV,		/* as above, plus one CSV row per frame in the save folder */
+	PROFILER_MODE_JSON		/* as above, plus one JSON object per line per frame */
+};
+
+/* number of completed frames kept in the ring buffer; must be a power of 2 */
+#define PROFILER_HISTORY	64
+
+/* per-frame record; counts are exclusive (nested sections are not counted */
+/* twice) and expressed in osd_profiling_ticks() units */
+struct profiler_frame
+{
+	UINT32		frame;						/* frame number since the profiler was started */
+	UINT32		context_switches;			/* number of times a CPU was entered */
+	UINT64		total;						/* sum of all the counts below */
+	UINT64		count[PROFILER_TOTAL];
+};
+
+
 /*
 To start profiling a certain section, e.g. video:
 profiler_mark(PROFILER_VIDEO);
@@ -50,19 +72,30 @@ to end profiling the current section:
 profiler_mark(PROFILER_END);
 
 the profiler handles a FILO list so calls may be nested.
+
+The marks are always compiled in; while the profiler is off they cost a
+single test of profiler_active.
 */
 
-#ifdef MAME_DEBUG
-#define profiler_mark(type) profiler__mark(type)
-#else
-#define profiler_mark(type)
-#endif
+extern int profiler_active;
+
+#define profiler_mark(type)					\
+	do										\
+	{										\
+		if (profiler_active)				\
+			profiler__mark(type);			\
+	} while (0)
 
 void profiler__mark(int type);
 
-/* functions called by usrintf.c */
+/* called by the core */
 void profiler_start(void);
 void profiler_stop(void);
-void profiler_show(struct mame_bitmap *bitmap);
+void profiler_frame_begin(void);
+void profiler_frame_end(void);
+
+/* ring buffer access; age 0 is the most recently completed frame */
+const struct profiler_frame *profiler_get_frame(int age);
+const char *profiler_get_name(int type);
 
 #endif	/* PROFILER_H */
@@ -13,6 +13,14 @@
 #include <limits.h>
 #include <assert.h>
 
+#if defined(MIXER_USE_CLIPPING) && defined(__SSE2__)
+#include <emmintrin.h>
+#define MIXER_PACK_SSE2
+#elif defined(MIXER_USE_CLIPPING) && (defined(__ARM_NEON__) || defined(__ARM_NEON))
+#include <arm_neon.h>
+#define MIXER_PACK_NEON
+#endif
+
 /***************************************************************************/
 /* Options */
 
@@ -101,8 +109,8 @@ static unsigned accum_base;
 static int left_accum[ACCUMULATOR_SAMPLES];
 static int right_accum[ACCUMULATOR_SAMPLES];
 
-/* 16-bit mix buffers */
-static INT16 mix_buffer[ACCUMULATOR_SAMPLES*2]; /* *2 for stereo */
+/* 16-bit interleaved stereo output, handed to the OSD layer as is */
+static INT16 mix_buffer[ACCUMULATOR_SAMPLES*2];
 
 /* global sample tracking */
 static unsigned samples_this_frame;
@@ -671,7 +679,8 @@ int mixer_sh_start(void)
 	memset(left_accum, 0, sizeof(left_accum));
 	memset(right_accum, 0, sizeof(right_accum));
 
-	samples_this_frame = osd_start_audio_stream(is_stereo);
+	/* the output is always interleaved stereo; mono is duplicated while packing */
+	samples_this_frame = osd_start_audio_stream(1);
 
 	mixer_sound_enabled = 1;
 
@@ -730,6 +739,60 @@ void mixer_update_channel(struct mixer_channel_data *channel, int total_sample_c
 	}
 }
 
+/***************************************************************************
+	mixer_pack - clip a run of 32-bit accumulators to 16-bit interleaved
+	stereo and zero them behind us; for mono, left and right are the same
+	accumulator
+***************************************************************************/
+
+static void mixer_pack(INT16 *mix, int *left, int *right, int count)
+{
+	int sample;
+
+#if defined(MIXER_PACK_SSE2)
+	const __m128i zero = _mm_setzero_si128();
+
+	/* packs_epi32 saturates exactly like MAME_CLAMP_SAMPLE */
+	for ( ; count >= 4; count -= 4, left += 4, right += 4, mix += 8)
+	{
+		__m128i l = _mm_loadu_si128((const __m128i *)left);
+		__m128i r = _mm_loadu_si128((const __m128i *)right);
+		__m128i lo = _mm_unpacklo_epi32(l, r);
+		__m128i hi = _mm_unpackhi_epi32(l, r);
+		_mm_storeu_si128((__m128i *)mix, _mm_packs_epi32(lo, hi));
+		_mm_storeu_si128((__m128i *)left, zero);
+		_mm_storeu_si128((__m128i *)right, zero);
+	}
+#elif defined(MIXER_PACK_NEON)
+	const int32x4_t zero = vdupq_n_s32(0);
+
+	/* vqmovn_s32 saturates exactly like MAME_CLAMP_SAMPLE */
+	for ( ; count >= 4; count -= 4, left += 4, right += 4, mix += 8)
+	{
+		int32x4x2_t lr = vzipq_s32(vld1q_s32(left), vld1q_s32(right));
+		vst1q_s16(mix, vcombine_s16(vqmovn_s32(lr.val[0]), vqmovn_s32(lr.val[1])));
+		vst1q_s32(left, zero);
+		vst1q_s32(right, zero);
+	}
+#endif
+
+	/* whatever is left, or everything without SIMD */
+	for ( ; count > 0; count--)
+	{
+		sample = *left;
+		MAME_CLAMP_SAMPLE(sample);
+		*mix++ = sample;
+
+		sample = *right;
+		MAME_CLAMP_SAMPLE(sample);
+		*mix++ = sample;
+
+		*left++ = 0;
+		*right++ = 0;
+	}
+}
+
+
 /***************************************************************************
 	mixer_sh_update
 ***************************************************************************/
@@ -738,8 +801,8 @@ void mixer_sh_update(void)
 {
 	struct mixer_channel_data* channel;
 	unsigned accum_pos = accum_base;
-	INT16 *mix;
-	int sample;
+	INT16 *mix = mix_buffer;
+	int remaining;
 	int i;
 
 	profiler_mark(PROFILER_MIXER);
@@ -756,50 +819,19 @@ void mixer_sh_update(void)
 			channel->samples_available -= samples_this_frame;
 	}
 
-	/* copy the mono 32-bit data to a 16-bit buffer, clipping along the way */
-	if (!is_stereo)
-	{
-		mix = mix_buffer;
-		for (i = 0; i < samples_this_frame; i++)
-		{
-			/* fetch and clip the sample */
-			sample = left_accum[accum_pos];
-         MAME_CLAMP_SAMPLE(sample);
-
-			/* store and zero out behind us */
-			*mix++ = sample;
-			left_accum[accum_pos] = 0;
-
-			/* advance to the next sample */
-			accum_pos = (accum_pos + 1) & ACCUMULATOR_MASK;
-		}
-	}
-
-	/* copy the stereo 32-bit data to a 16-bit buffer, clipping along the way */
-	else
+	/* convert the 32-bit accumulators to 16-bit stereo, clipping along the way; */
+	/* the accumulators are a ring, so this takes at most two runs */
+	for (remaining = samples_this_frame; remaining > 0; )
 	{
-		mix = mix_buffer;
-		for (i = 0; i < samples_this_frame; i++)
-		{
-			/* fetch and clip the left sample */
-			sample = left_accum[accum_pos];
-         MAME_CLAMP_SAMPLE(sample);
-
-			/* store and zero out behind us */
-			*mix++ = sample;
-			left_accum[accum_pos] = 0;
+		int count = ACCUMULATOR_SAMPLES - accum_pos;
+		if (count > remaining)
+			count = remaining;
 
-			/* fetch and clip the right sample */
-			sample = right_accum[accum_pos];
-         MAME_CLAMP_SAMPLE(sample);
+		mixer_pack(mix, &left_accum[accum_pos], is_stereo ? &right_accum[accum_pos] : &left_accum[accum_pos], count);
 
-			/* store and zero out behind us */
-			*mix++ = sample;
-			right_accum[accum_pos] = 0;
-
-			/* advance to the next sample */
-			accum_pos = (accum_pos + 1) & ACCUMULATOR_MASK;
-		}
+		mix += count * 2;
+		remaining -= count;
+		accum_pos = (accum_pos + count) & ACCUMULATOR_MASK;
 	}
 
 	/* play the result */
@@ -23,14 +23,6 @@ enum {
 	SS_MSB_FIRST = 0x02
 };
 
-/*#define VERBOSE*/
-
-#ifdef VERBOSE
-#define TRACE(x) do {x;} while(0)
-#else
-#define TRACE(x)
-#endif
-
 enum {MAX_INSTANCES = 25};
 
 enum {
@@ -45,7 +37,7 @@ enum {
 	SS_FLOAT
 };
 
-#ifdef VERBOSE
+#if TRACE_STATE
 static const char *ss_type[] =	{ "i8", "u8", "i16", "u16", "i32", "u32", "int", "dbl", "flt" };
 #endif
 static int		   ss_size[] =	{	 1,    1,	  2,	 2, 	4,	   4,	  4,	 8,     4 };
@@ -66,7 +58,6 @@ typedef struct ss_entry {
 	void *data;
 	unsigned size;
 	int tag;
-	unsigned offset;
 } ss_entry;
 
 typedef struct ss_module {
@@ -90,6 +81,42 @@ static int ss_current_tag;
 static unsigned char *ss_dump_array;
 static unsigned int ss_dump_size;
 
+/* The registry flattened into one array sorted by tag, so a save or load
+   of a tag is a single pass over a contiguous slice. Offsets still follow
+   the registry order, which is the file format. This, the image size and
+   the signature only change with the registry, so they are worked out
+   once and reused by every save, load and size query. */
+typedef struct ss_manifest_entry {
+	void *data;
+	unsigned int offset;
+	unsigned int bytes;
+	unsigned int size;
+	int type;
+	int tag;
+	const char *module;
+	int instance;
+	const char *name;
+} ss_manifest_entry;
+
+static int ss_layout_valid;
+static ss_manifest_entry *ss_manifest;
+static unsigned int ss_layout_size;
+static unsigned int ss_layout_entries;
+static int ss_layout_missing;
+static UINT32 ss_layout_signature;
+
+/* Delta saves: runs of changed bytes are written here instead of a full
+   image, as (offset, length, old ^ new) records. Runs are merged across
+   gaps shorter than SS_DELTA_GAP unchanged bytes. */
+enum {
+	SS_DELTA_HEADER = 6,
+	SS_DELTA_GAP = 8,
+	SS_DELTA_MAX_RUN = 0xffff
+};
+
+static unsigned char *ss_delta;
+static unsigned int ss_delta_size;
+
 
 static UINT32 ss_get_signature(void)
 {
@@ -141,6 +168,92 @@ static UINT32 ss_get_signature(void)
 	return signature;
 }
 
+static int ss_manifest_compare(const void *a, const void *b)
+{
+	const ss_manifest_entry *ea = a, *eb = b;
+	if(ea->tag != eb->tag)
+		return ea->tag < eb->tag ? -1 : 1;
+	return ea->offset < eb->offset ? -1 : ea->offset > eb->offset;
+}
+
+static void ss_layout(void)
+{
+	ss_module *m;
+	ss_manifest_entry *me;
+	unsigned int offset = 0x18;
+
+	if (ss_layout_valid)
+		return;
+
+	ss_layout_entries = 0;
+	for(m = ss_registry; m; m=m->next) {
+		int i;
+		for(i=0; i<MAX_INSTANCES; i++) {
+			ss_entry *e;
+			for(e = m->instances[i]; e; e=e->next)
+				ss_layout_entries++;
+		}
+	}
+
+	free(ss_manifest);
+	ss_manifest = malloc((ss_layout_entries ? ss_layout_entries : 1) * sizeof(*ss_manifest));
+	if (ss_manifest == NULL)
+	{
+		log_cb(RETRO_LOG_ERROR, LOGPRE "malloc failed in ss_layout\n");
+		ss_layout_entries = 0;
+		ss_layout_size = 0;
+		ss_layout_missing = 1;
+		return;
+	}
+
+	ss_layout_missing = 0;
+	me = ss_manifest;
+	for(m = ss_registry; m; m=m->next) {
+		int i;
+		for(i=0; i<MAX_INSTANCES; i++) {
+			ss_entry *e;
+			for(e = m->instances[i]; e; e=e->next) {
+				me->data     = e->data;
+				me->offset   = offset;
+				me->bytes    = ss_size[e->type]*e->size;
+				me->size     = e->size;
+				me->type     = e->type;
+				me->tag      = e->tag;
+				me->module   = m->name;
+				me->instance = i;
+				me->name     = e->name;
+				if(!e->data)
+					ss_layout_missing = 1;
+				offset += me->bytes;
+				me++;
+			}
+		}
+	}
+	qsort(ss_manifest, ss_layout_entries, sizeof(*ss_manifest), ss_manifest_compare);
+
+	ss_layout_size = offset;
+	ss_layout_signature = ss_get_signature();
+	ss_layout_valid = 1;
+}
+
+/* The slice of the manifest holding the current tag's entries */
+static ss_manifest_entry *ss_tag_entries(unsigned int *count)
+{
+	unsigned int lo = 0, hi = ss_layout_entries, end;
+
+	while(lo < hi) {
+		unsigned int mid = (lo + hi) / 2;
+		if(ss_manifest[mid].tag < ss_current_tag)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	for(end = lo; end < ss_layout_entries && ss_manifest[end].tag == ss_current_tag; end++)
+		;
+	*count = end - lo;
+	return ss_manifest + lo;
+}
+
 void state_save_reset(void)
 {
 	ss_func *f;
@@ -181,6 +294,12 @@ void state_save_reset(void)
 	ss_current_tag = 0;
 	ss_dump_array = 0;
 	ss_dump_size = 0;
+	ss_delta = 0;
+	ss_delta_size = 0;
+	ss_layout_valid = 0;
+	free(ss_manifest);
+	ss_manifest = 0;
+	ss_layout_entries = 0;
 }
 
 static ss_module *ss_get_module(const char *name)
@@ -231,8 +350,8 @@ static ss_entry *ss_register_entry(const char *module, int instance, const char
 	(*ep)->type   = type;
 	(*ep)->data   = data;
 	(*ep)->size   = size;
-	(*ep)->offset = 0;
 	(*ep)->tag	  = ss_current_tag;
+	ss_layout_valid = 0;
 	return *ep;
 }
 
@@ -382,65 +501,100 @@ static void ss_c8(unsigned char *data, unsigned size)
 /* __LIBRETRO__: Serialize helper*/
 size_t state_get_dump_size(void)
 {
-	ss_module *m;
-  
   if(Machine->gamedrv->flags & GAME_DOESNT_SERIALIZE)
   {
-    log_cb(RETRO_LOG_DEBUG, LOGPRE "Driver flagged GAME_DOESNT_SERIALIZE. Setting state_get_dump_size() to 0.\n");
+    log_trace(STATE, (RETRO_LOG_DEBUG, LOGPRE "Driver flagged GAME_DOESNT_SERIALIZE. Setting state_get_dump_size() to 0.\n"));
     return 0;
   }
-  
-	log_cb(RETRO_LOG_DEBUG, LOGPRE "Beginning save\n");
-	ss_dump_size = 0x18;
-	for(m = ss_registry; m; m=m->next) {
-		int i;
-		for(i=0; i<MAX_INSTANCES; i++) {
-			ss_entry *e;
-			for(e = m->instances[i]; e; e=e->next) {
-			    if(!e->data)
-			    {
-			        return 0;
-			    }
-				e->offset = ss_dump_size;
-				ss_dump_size += ss_size[e->type]*e->size;
-			}
-		}
-	}
 
-    return ss_dump_size;
+	ss_layout();
+	if(ss_layout_missing)
+		return 0;
+
+    return ss_layout_size;
 }
 
 void state_save_save_begin(void *array)
 {
-	ss_module *m;
-	log_cb(RETRO_LOG_DEBUG, LOGPRE "Beginning save\n");
-	ss_dump_size = 0x18;
-	for(m = ss_registry; m; m=m->next) {
-		int i;
-		for(i=0; i<MAX_INSTANCES; i++) {
-			ss_entry *e;
-			for(e = m->instances[i]; e; e=e->next) {
-				e->offset = ss_dump_size;
-				ss_dump_size += ss_size[e->type]*e->size;
-			}
-		}
-	}
+	log_trace(STATE, (RETRO_LOG_DEBUG, LOGPRE "Beginning save\n"));
+	ss_layout();
+	ss_dump_size = ss_layout_size;
+	ss_delta = 0;
+	ss_delta_size = 0;
 
-	log_cb(RETRO_LOG_DEBUG, LOGPRE "   total size %u\n", ss_dump_size);
+	log_trace(STATE, (RETRO_LOG_DEBUG, LOGPRE "   total size %u\n", ss_dump_size));
 	ss_dump_array = array;
 	if (ss_dump_array == NULL)
 	{
-		log_cb(RETRO_LOG_DEBUG, LOGPRE  "malloc failed in state_save_save_begin\n");
+		log_trace(STATE, (RETRO_LOG_DEBUG, LOGPRE  "malloc failed in state_save_save_begin\n"));
 	}
 }
 
+/* Append the runs where data differs from the snapshot to the delta,
+   then bring the snapshot up to date */
+static void ss_delta_block(unsigned int offset, const unsigned char *data, unsigned int size)
+{
+	unsigned char *snap = ss_dump_array + offset;
+	unsigned int pos = 0;
+
+	while(pos < size) {
+		unsigned int start, end, len, i;
+		unsigned char *d;
+
+		/* skip what hasn't changed, in big steps where possible */
+		while(pos + 64 <= size && !memcmp(snap + pos, data + pos, 64))
+			pos += 64;
+		while(pos + 8 <= size && !memcmp(snap + pos, data + pos, 8))
+			pos += 8;
+		while(pos < size && snap[pos] == data[pos])
+			pos++;
+		if(pos == size)
+			break;
+
+		/* the run ends at the last change before a long enough gap */
+		start = pos;
+		end = pos + 1;
+		for(pos = end; pos < size && pos - start < SS_DELTA_MAX_RUN; pos++) {
+			if(snap[pos] != data[pos])
+				end = pos + 1;
+			else if(pos - end >= SS_DELTA_GAP)
+				break;
+		}
+		pos = end;
+		len = end - start;
+
+		d = ss_delta + ss_delta_size;
+		d[0] = (offset + start);
+		d[1] = (offset + start) >> 8;
+		d[2] = (offset + start) >> 16;
+		d[3] = (offset + start) >> 24;
+		d[4] = len;
+		d[5] = len >> 8;
+		d += SS_DELTA_HEADER;
+		for(i=0; i<len; i++) {
+			d[i] = snap[start + i] ^ data[start + i];
+			snap[start + i] = data[start + i];
+		}
+		ss_delta_size += SS_DELTA_HEADER + len;
+	}
+}
+
+static void ss_save_block(unsigned int offset, const void *data, unsigned int size)
+{
+	if(ss_delta)
+		ss_delta_block(offset, data, size);
+	else
+		memcpy(ss_dump_array + offset, data, size);
+}
+
 int state_save_save_continue(void)
 {
-	ss_module *m;
+	ss_manifest_entry *e;
 	ss_func * f;
+	unsigned int n;
 	int count = 0;
-	log_cb(RETRO_LOG_DEBUG, LOGPRE "Saving tag %d\n", ss_current_tag);
-	log_cb(RETRO_LOG_DEBUG, LOGPRE "  calling pre-save functions\n");
+	log_trace(STATE, (RETRO_LOG_DEBUG, LOGPRE "Saving tag %d\n", ss_current_tag));
+	log_trace(STATE, (RETRO_LOG_DEBUG, LOGPRE "  calling pre-save functions\n"));
 	f = ss_prefunc_reg;
 	while(f) {
 		if(f->tag == ss_current_tag) {
@@ -449,32 +603,25 @@ int state_save_save_continue(void)
 		}
 		f = f->next;
 	}
-	log_cb(RETRO_LOG_DEBUG, LOGPRE "    %d functions called\n", count);
-	log_cb(RETRO_LOG_DEBUG, LOGPRE "  copying data\n");
-	for(m = ss_registry; m; m=m->next) {
-		int i;
-		for(i=0; i<MAX_INSTANCES; i++) {
-			ss_entry *e;
-			for(e = m->instances[i]; e; e=e->next)
-				if(e->tag == ss_current_tag) {
-				    if(!e->data) {
-				    	ss_dump_array = 0;
-                    	ss_dump_size = 0;
-                    	return 1;
-				    }
-					if(e->type == SS_INT) {
-						int v = *(int *)(e->data);
-						ss_dump_array[e->offset]   = v ;
-						ss_dump_array[e->offset+1] = v >> 8;
-						ss_dump_array[e->offset+2] = v >> 16;
-						ss_dump_array[e->offset+3] = v >> 24;
-						log_cb(RETRO_LOG_DEBUG, LOGPRE "    %s.%d.%s: %x..%x\n", m->name, i, e->name, e->offset, e->offset+3);
-					} else {
-						memcpy(ss_dump_array + e->offset, e->data, ss_size[e->type]*e->size);
-						log_cb(RETRO_LOG_DEBUG, LOGPRE "    %s.%d.%s: %x..%x\n", m->name, i, e->name, e->offset, e->offset+ss_size[e->type]*e->size-1);
-					}
-				}
-		}
+	log_trace(STATE, (RETRO_LOG_DEBUG, LOGPRE "    %d functions called\n", count));
+	log_trace(STATE, (RETRO_LOG_DEBUG, LOGPRE "  copying data\n"));
+	for(e = ss_tag_entries(&n); n; e++, n--) {
+	    if(!e->data) {
+	    	ss_dump_array = 0;
+        	ss_dump_size = 0;
+        	return 1;
+	    }
+		if(e->type == SS_INT) {
+			int v = *(int *)(e->data);
+			unsigned char bytes[4];
+			bytes[0] = v;
+			bytes[1] = v >> 8;
+			bytes[2] = v >> 16;
+			bytes[3] = v >> 24;
+			ss_save_block(e->offset, bytes, 4);
+		} else
+			ss_save_block(e->offset, e->data, e->bytes);
+		log_trace(STATE, (RETRO_LOG_DEBUG, LOGPRE "    %s.%d.%s: %x..%x\n", e->module, e->instance, e->name, e->offset, e->offset+e->bytes-1));
 	}
 	
 	return 0;
@@ -485,9 +632,9 @@ void state_save_save_finish(void)
 	UINT32 signature;
 	unsigned char flags = 0;
 
-	log_cb(RETRO_LOG_DEBUG, LOGPRE "Finishing save\n");
+	log_trace(STATE, (RETRO_LOG_DEBUG, LOGPRE "Finishing save\n"));
 
-	signature = ss_get_signature();
+	signature = ss_layout_signature;
 	if(!Machine->sample_rate)
 		flags |= SS_NO_SOUND;
 
@@ -512,13 +659,12 @@ void state_save_save_finish(void)
 
 int state_save_load_begin(void *array, size_t size)
 {
-	ss_module *m;
-	unsigned int offset = 0;
 	UINT32 signature, file_sig;
 
-	log_cb(RETRO_LOG_DEBUG, LOGPRE "Beginning load\n");
+	log_trace(STATE, (RETRO_LOG_DEBUG, LOGPRE "Beginning load\n"));
 
-	signature = ss_get_signature();
+	ss_layout();
+	signature = ss_layout_signature;
 
 	ss_dump_size = size;
 	ss_dump_array = array;
@@ -556,17 +702,6 @@ int state_save_load_begin(void *array, size_t size)
 			usrintf_showmessage("Warning: Game was saved with sound on, but sound is off.  Result may be interesting.");
 	}
 
-	offset = 0x18;
-	for(m = ss_registry; m; m=m->next) {
-		int i;
-		for(i=0; i<MAX_INSTANCES; i++) {
-			ss_entry *e;
-			for(e = m->instances[i]; e; e=e->next) {
-				e->offset = offset;
-				offset += ss_size[e->type]*e->size;
-			}
-		}
-	}
 	return 0;
 
  bad:
@@ -575,8 +710,9 @@ int state_save_load_begin(void *array, size_t size)
 
 int state_save_load_continue(void)
 {
-	ss_module *m;
+	ss_manifest_entry *e;
 	ss_func * f;
+	unsigned int n;
 	int count = 0;
 	int need_convert;
 
@@ -586,38 +722,30 @@ int state_save_load_continue(void)
 	need_convert = (ss_dump_array[9] & SS_MSB_FIRST) != 0;
 #endif
 
-	log_cb(RETRO_LOG_DEBUG, LOGPRE "Loading tag %d\n", ss_current_tag);
-	log_cb(RETRO_LOG_DEBUG, LOGPRE "  copying data\n");
-	for(m = ss_registry; m; m=m->next) {
-		int i;
-		for(i=0; i<MAX_INSTANCES; i++) {
-			ss_entry *e;
-			for(e = m->instances[i]; e; e=e->next)
-				if(e->tag == ss_current_tag) {
-					if(!e->data) {
-				    	ss_dump_array = 0;
-                    	ss_dump_size = 0;
-                    	return 1;
-				    }
-
-					if(e->type == SS_INT) {
-						int v;
-						v = ss_dump_array[e->offset]
-							| (ss_dump_array[e->offset+1] << 8)
-							| (ss_dump_array[e->offset+2] << 16)
-							| (ss_dump_array[e->offset+3] << 24);
-						log_cb(RETRO_LOG_DEBUG, LOGPRE "    %s.%d.%s: %x..%x\n", m->name, i, e->name, e->offset, e->offset+3);
-						*(int *)(e->data) = v;
-					} else {
-						memcpy(e->data, ss_dump_array + e->offset, ss_size[e->type]*e->size);
-						if (need_convert && ss_conv[e->type])
-							ss_conv[e->type](e->data, e->size);
-						log_cb(RETRO_LOG_DEBUG, LOGPRE "    %s.%d.%s: %x..%x\n", m->name, i, e->name, e->offset, e->offset+ss_size[e->type]*e->size-1);
-					}
-				}
+	log_trace(STATE, (RETRO_LOG_DEBUG, LOGPRE "Loading tag %d\n", ss_current_tag));
+	log_trace(STATE, (RETRO_LOG_DEBUG, LOGPRE "  copying data\n"));
+	for(e = ss_tag_entries(&n); n; e++, n--) {
+		if(!e->data) {
+	    	ss_dump_array = 0;
+        	ss_dump_size = 0;
+        	return 1;
+	    }
+
+		if(e->type == SS_INT) {
+			int v;
+			v = ss_dump_array[e->offset]
+				| (ss_dump_array[e->offset+1] << 8)
+				| (ss_dump_array[e->offset+2] << 16)
+				| (ss_dump_array[e->offset+3] << 24);
+			*(int *)(e->data) = v;
+		} else {
+			memcpy(e->data, ss_dump_array + e->offset, e->bytes);
+			if (need_convert && ss_conv[e->type])
+				ss_conv[e->type](e->data, e->size);
 		}
+		log_trace(STATE, (RETRO_LOG_DEBUG, LOGPRE "    %s.%d.%s: %x..%x\n", e->module, e->instance, e->name, e->offset, e->offset+e->bytes-1));
 	}
-	log_cb(RETRO_LOG_DEBUG, LOGPRE "  calling post-load functions\n");
+	log_trace(STATE, (RETRO_LOG_DEBUG, LOGPRE "  calling post-load functions\n"));
 	f = ss_postfunc_reg;
 	while(f) {
 		if(f->tag == ss_current_tag) {
@@ -626,28 +754,79 @@ int state_save_load_continue(void)
 		}
 		f = f->next;
 	}
-	log_cb(RETRO_LOG_DEBUG, LOGPRE "    %d functions called\n", count);
+	log_trace(STATE, (RETRO_LOG_DEBUG, LOGPRE "    %d functions called\n", count));
 	
 	return 0;
 }
 
 void state_save_load_finish(void)
 {
-	log_cb(RETRO_LOG_DEBUG, LOGPRE "Finishing load\n");
+	log_trace(STATE, (RETRO_LOG_DEBUG, LOGPRE "Finishing load\n"));
 	ss_dump_array = 0;
 	ss_dump_size = 0;
 }
 
+/* Rewind support. A delta save works like a normal one, but is given the
+   previous image instead of an empty buffer: only the changed runs are
+   written to the delta, and the image is updated in place. */
+size_t state_delta_max_size(void)
+{
+	ss_layout();
+	return ss_layout_size + SS_DELTA_HEADER * (ss_layout_size / SS_DELTA_GAP + 2 * ss_layout_entries);
+}
+
+void state_save_delta_begin(void *snapshot, void *delta)
+{
+	state_save_save_begin(snapshot);
+	ss_delta = delta;
+	ss_delta_size = 0;
+}
+
+size_t state_save_delta_finish(void)
+{
+	size_t size = ss_delta_size;
+
+	state_save_save_finish();
+	ss_delta = 0;
+	ss_delta_size = 0;
+	return size;
+}
+
+/* The records are XORs, so applying a delta to the image it produced
+   gives back the image it was taken against, and vice versa */
+int state_delta_apply(void *snapshot, size_t snapshot_size, const void *delta, size_t delta_size)
+{
+	unsigned char *snap = snapshot;
+	const unsigned char *d = delta;
+	const unsigned char *end = d + delta_size;
+
+	while(d < end) {
+		unsigned int offset, len, i;
+
+		if(end - d < SS_DELTA_HEADER)
+			return 1;
+		offset = d[0] | (d[1] << 8) | (d[2] << 16) | ((unsigned int)d[3] << 24);
+		len = d[4] | (d[5] << 8);
+		d += SS_DELTA_HEADER;
+		if(end - d < len || offset > snapshot_size || snapshot_size - offset < len)
+			return 1;
+		for(i=0; i<len; i++)
+			snap[offset + i] ^= d[i];
+		d += len;
+	}
+	return 0;
+}
+
 void state_save_dump_registry(void)
 {
-#ifdef VERBOSE
+#if TRACE_STATE
 	ss_module *m;
 	for(m = ss_registry; m; m=m->next) {
 		int i;
 		for(i=0; i<MAX_INSTANCES; i++) {
 			ss_entry *e;
 			for(e = m->instances[i]; e; e=e->next)
-				log_cb(RETRO_LOG_DEBUG, LOGPRE "%d %s.%d.%s: %s, %x\n", e->tag, m->name, i, e->name, ss_type[e->type], e->size);
+				log_trace(STATE, (RETRO_LOG_DEBUG, LOGPRE "%d %s.%d.%s: %s, %x\n", e->tag, m->name, i, e->name, ss_type[e->type], e->size));
 		}
 	}
 #endif
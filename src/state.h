@@ -43,6 +43,13 @@ int state_save_load_continue(void);
 void state_save_save_finish(void);
 void state_save_load_finish(void);
 
+/* Rewind: save into the previous image, writing only an XOR delta of */
+/* what changed; applying a delta to its image steps back one save */
+size_t state_delta_max_size(void);
+void state_save_delta_begin(void *snapshot, void *delta);
+size_t state_save_delta_finish(void);
+int state_delta_apply(void *snapshot, size_t snapshot_size, const void *delta, size_t delta_size);
+
 /* Display function */
 void state_save_dump_registry(void);
 
@@ -91,6 +91,12 @@ struct tilemap
 	UINT32 transparency_bitmap_pitch_row;
 	UINT8 *transparency_data, **transparency_data_row;
 
+	/* dirty tiles, one bit per cached tile and a summary bit per cached row, */
+	/* so tilemap_get_pixmap() only visits the rows and tiles that changed */
+	UINT32 *dirty_tiles;
+	UINT32 *dirty_rows;
+	UINT32 dirty_words_per_row;
+
 	struct tilemap *next; /* resource tracking */
 };
 
@@ -132,6 +138,7 @@ static void install_draw_handlers( struct tilemap *tilemap );
 static void tilemap_reset(void);
 
 static void update_tile_info( struct tilemap *tilemap, UINT32 cached_indx, UINT32 cached_col, UINT32 cached_row );
+static void mark_all_tiles_dirty_now( struct tilemap *tilemap );
 
 /***********************************************************************************/
 
@@ -1669,6 +1676,10 @@ struct tilemap *tilemap_create(
 		tilemap->transparency_data = malloc( num_tiles );
 		tilemap->transparency_data_row = malloc( sizeof(UINT8 *)*num_rows );
 
+		tilemap->dirty_words_per_row = (num_cols+31)/32;
+		tilemap->dirty_tiles = malloc( sizeof(UINT32)*tilemap->dirty_words_per_row*num_rows );
+		tilemap->dirty_rows = malloc( sizeof(UINT32)*((num_rows+31)/32) );
+
 		tilemap->pixmap = bitmap_alloc_depth( tilemap->cached_width, tilemap->cached_height, -16 );
 		tilemap->transparency_bitmap = bitmap_alloc_depth( tilemap->cached_width, tilemap->cached_height, -8 );
 
@@ -1677,6 +1688,7 @@ struct tilemap *tilemap_create(
 			tilemap->pixmap &&
 			tilemap->transparency_data &&
 			tilemap->transparency_data_row &&
+			tilemap->dirty_tiles && tilemap->dirty_rows &&
 			tilemap->transparency_bitmap &&
 			(mappings_create( tilemap )==0) )
 		{
@@ -1692,7 +1704,7 @@ struct tilemap *tilemap_create(
 			}
 			install_draw_handlers( tilemap );
 			mappings_update( tilemap );
-			memset( tilemap->transparency_data, TILE_FLAG_DIRTY, num_tiles );
+			mark_all_tiles_dirty_now( tilemap );
 			tilemap->next = first_tilemap;
 			first_tilemap = tilemap;
 			if( PenToPixel_Init( tilemap ) == 0 )
@@ -1727,6 +1739,8 @@ void tilemap_dispose( struct tilemap *tilemap )
 	free( tilemap->cached_colscroll );
 	free( tilemap->transparency_data );
 	free( tilemap->transparency_data_row );
+	free( tilemap->dirty_tiles );
+	free( tilemap->dirty_rows );
 	bitmap_free( tilemap->transparency_bitmap );
 	bitmap_free( tilemap->pixmap );
 	mappings_dispose( tilemap );
@@ -1809,7 +1823,12 @@ void tilemap_mark_tile_dirty( struct tilemap *tilemap, int memory_offset )
 		int cached_indx = tilemap->memory_offset_to_cached_indx[memory_offset];
 		if( cached_indx>=0 )
 		{
+			UINT32 row = cached_indx/tilemap->num_cached_cols;
+			UINT32 col = cached_indx%tilemap->num_cached_cols;
+
 			tilemap->transparency_data[cached_indx] = TILE_FLAG_DIRTY;
+			tilemap->dirty_tiles[row*tilemap->dirty_words_per_row + col/32] |= 1U << (col%32);
+			tilemap->dirty_rows[row/32] |= 1U << (row%32);
 			tilemap->all_tiles_clean = 0;
 		}
 	}
@@ -1833,6 +1852,27 @@ void tilemap_mark_all_tiles_dirty( struct tilemap *tilemap )
 	}
 }
 
+/* applies a pending tilemap_mark_all_tiles_dirty() */
+static void mark_all_tiles_dirty_now( struct tilemap *tilemap )
+{
+	UINT32 row,words;
+
+	memset( tilemap->transparency_data, TILE_FLAG_DIRTY, tilemap->num_tiles );
+
+	/* set the bits of every column, and nothing past the last one */
+	words = tilemap->dirty_words_per_row;
+	for( row=0; row<tilemap->num_cached_rows; row++ )
+	{
+		UINT32 *dirty = &tilemap->dirty_tiles[row*words];
+		memset( dirty, 0xff, sizeof(UINT32)*words );
+		if( tilemap->num_cached_cols%32 )
+			dirty[words-1] = (1U << (tilemap->num_cached_cols%32)) - 1;
+	}
+	memset( tilemap->dirty_rows, 0xff, sizeof(UINT32)*((tilemap->num_cached_rows+31)/32) );
+
+	tilemap->all_tiles_dirty = 0;
+}
+
 /***********************************************************************************/
 
 static void update_tile_info( struct tilemap *tilemap, UINT32 cached_indx, UINT32 col, UINT32 row )
@@ -1852,14 +1892,14 @@ profiler_mark(PROFILER_TILEMAP_UPDATE);
 	y0 = tilemap->cached_tile_height*row;
 
 	tilemap->transparency_data[cached_indx] = tilemap->draw_tile(tilemap,x0,y0,flags );
+	tilemap->dirty_tiles[row*tilemap->dirty_words_per_row + col/32] &= ~(1U << (col%32));
 
 profiler_mark(PROFILER_END);
 }
 
 struct mame_bitmap *tilemap_get_pixmap( struct tilemap * tilemap )
 {
-	UINT32 cached_indx = 0;
-	UINT32 row,col;
+	UINT32 row,col,word;
 
 	if (tilemap->all_tiles_clean == 0)
 	{
@@ -1867,24 +1907,34 @@ profiler_mark(PROFILER_TILEMAP_DRAW);
 
 		/* if the whole map is dirty, mark it as such */
 		if (tilemap->all_tiles_dirty)
-		{
-			memset( tilemap->transparency_data, TILE_FLAG_DIRTY, tilemap->num_tiles );
-			tilemap->all_tiles_dirty = 0;
-		}
+			mark_all_tiles_dirty_now( tilemap );
 
 		memset( &tile_info, 0x00, sizeof(tile_info) ); /* initialize defaults */
 
-		/* walk over cached rows/cols (better to walk screen coords) */
+		/* walk over the dirty cached rows, then their dirty cols; tiles */
+		/* redrawn by tilemap_draw() since they were marked are already clear */
 		for( row=0; row<tilemap->num_cached_rows; row++ )
 		{
-			for( col=0; col<tilemap->num_cached_cols; col++ )
+			UINT32 *dirty;
+
+			if( (tilemap->dirty_rows[row/32] & (1U << (row%32)))==0 )
+			{
+				/* skip the rest of a clean group of 32 */
+				if( tilemap->dirty_rows[row/32]==0 ) row |= 31;
+				continue;
+			}
+			tilemap->dirty_rows[row/32] &= ~(1U << (row%32));
+
+			dirty = &tilemap->dirty_tiles[row*tilemap->dirty_words_per_row];
+			for( word=0; word<tilemap->dirty_words_per_row; word++ )
 			{
-				if( tilemap->transparency_data[cached_indx] == TILE_FLAG_DIRTY )
+				while( dirty[word] )
 				{
-					update_tile_info( tilemap, cached_indx, col, row );
-				}
-				cached_indx++;
-			} /* next col */
+					for( col=0; (dirty[word] & (1U << col))==0; col++ ) ;
+					col += word*32;
+					update_tile_info( tilemap, row*tilemap->num_cached_cols + col, col, row ); /* clears the bit */
+				} /* next dirty col */
+			}
 		} /* next row */
 
 		tilemap->all_tiles_clean = 1;
@@ -2084,10 +2134,7 @@ profiler_mark(PROFILER_TILEMAP_DRAW);
 
 		/* if the whole map is dirty, mark it as such */
 		if (tilemap->all_tiles_dirty)
-		{
-			memset( tilemap->transparency_data, TILE_FLAG_DIRTY, tilemap->num_tiles );
-			tilemap->all_tiles_dirty = 0;
-		}
+			mark_all_tiles_dirty_now( tilemap );
 
 		/* priority_bitmap_pitch_row is tilemap-specific */
 		priority_bitmap_pitch_row = priority_bitmap_pitch_line*tilemap->cached_tile_height;
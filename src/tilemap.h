@@ -61,7 +61,7 @@ extern struct tile_info
 	const struct GfxElement *gfx = Machine->gfx[(GFX)]; \
 	int _code = (CODE) % gfx->total_elements; \
 	tile_info.tile_number = _code; \
-	tile_info.pen_data = gfx->gfxdata + _code*gfx->char_modulo; \
+	tile_info.pen_data = gfx_element_get_data(gfx,_code); \
 	tile_info.pal_data = &gfx->colortable[gfx->color_granularity * (COLOR)]; \
 	tile_info.pen_usage = gfx->pen_usage?gfx->pen_usage[_code]:0; \
 	tile_info.flags = FLAGS; \
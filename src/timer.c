@@ -28,14 +28,24 @@
 	  burn cycles, because the cores might need to adjust internal
 	  counters or timers.
 
+  Scheduler changes:
+	- timers are kept in a binary heap rather than a sorted list, and
+	  allocated in blocks with no fixed limit
+	- all scheduler time is fixed point (mame_time: seconds plus
+	  attoseconds) and absolute; the double based API converts at the
+	  boundary, so the nanosecond rounding slop is no longer needed
+
 ***************************************************************************/
 
+#include <math.h>
 #include "cpuintrf.h"
 #include "driver.h"
 #include "timer.h"
 
 
-#define MAX_TIMERS 256
+/* timers are allocated in blocks, so there is no fixed limit and a
+   mame_timer pointer stays valid until the next timer_init() */
+#define TIMER_BLOCK_SIZE	64
 
 
 
@@ -45,16 +55,24 @@
 
 struct _mame_timer
 {
-	struct _mame_timer *next;
-	struct _mame_timer *prev;
+	struct _mame_timer *next;		/* free list link */
 	void (*callback)(int);
 	int callback_param;
 	int tag;
+	int heap_index;					/* position in the heap, or -1 */
+	UINT32 sequence;				/* insertion order, breaks ties between equal expire times */
 	UINT8 enabled;
 	UINT8 temporary;
-	double period;
-	double start;
-	double expire;
+	mame_time period;
+	mame_time start;				/* absolute */
+	mame_time expire;				/* absolute */
+	mame_time key;					/* heap key: expire, or time_never if disabled */
+};
+
+struct timer_block
+{
+	struct timer_block *next;
+	mame_timer timers[TIMER_BLOCK_SIZE];
 };
 
 
@@ -66,41 +84,183 @@ struct _mame_timer
 /* conversion constants */
 double cycles_to_sec[MAX_CPU];
 double sec_to_cycles[MAX_CPU];
+subseconds_t subseconds_per_cycle[MAX_CPU];
+UINT32 cycles_per_second[MAX_CPU];
+
+/* useful times */
+mame_time time_zero = { 0, 0 };
+mame_time time_never = { MAX_SECONDS, 0 };
 
-/* list of active timers */
-static mame_timer timers[MAX_TIMERS];
-static mame_timer *timer_head;
+/* all allocated timers, and the free ones */
+static struct timer_block *timer_blocks;
+static int timer_block_count;
 static mame_timer *timer_free_head;
 static mame_timer *timer_free_tail;
 
+/* binary min-heap of scheduled timers; timer_heap[0] fires next */
+static mame_timer **timer_heap;
+static int timer_heap_count;
+static int timer_heap_size;
+static UINT32 timer_sequence;
+
 /* other internal states */
-static double global_offset;
+static mame_time global_basetime;
 static mame_timer *callback_timer;
 static int callback_timer_modified;
-static double callback_timer_expire_time;
+static mame_time callback_timer_expire_time;
 
 
 
 /*-------------------------------------------------
-	get_relative_time - return the current time
-	relative to the global_offset
+	double_to_mame_time/mame_time_to_double -
+	conversions for the double based API
 -------------------------------------------------*/
 
-static INLINE double get_relative_time(void)
+void double_to_mame_time(double time, mame_time *result)
 {
+	double whole;
+
+	/* anything at or beyond MAX_SECONDS (including TIME_NEVER) is never */
+	if (time >= (double)MAX_SECONDS)
+	{
+		*result = time_never;
+		return;
+	}
+
+	whole = floor(time);
+	result->seconds = (seconds_t)whole;
+	result->subseconds = (subseconds_t)((time - whole) * (double)MAX_SUBSECONDS);
+	if (result->subseconds >= MAX_SUBSECONDS)
+	{
+		result->subseconds -= MAX_SUBSECONDS;
+		result->seconds++;
+	}
+	else if (result->subseconds < 0)
+		result->subseconds = 0;
+}
+
+double mame_time_to_double(mame_time time)
+{
+	if (time.seconds >= MAX_SECONDS)
+		return TIME_NEVER;
+	return (double)time.seconds + (double)time.subseconds * (1.0 / (double)MAX_SUBSECONDS);
+}
+
+
+
+/*-------------------------------------------------
+	timer_set_cpu_clock - set the conversion
+	constants for a CPU's effective clock
+-------------------------------------------------*/
+
+void timer_set_cpu_clock(int cpunum, double clock)
+{
+	UINT32 hz;
+
+	/* a stopped or out-of-range clock can't be converted; clamp it */
+	if (!(clock >= 1.0))
+	{
+		log_cb(RETRO_LOG_WARN, LOGPRE "CPU #%d clock %f out of range, using 1Hz\n", cpunum, clock);
+		clock = 1.0;
+	}
+	else if (clock > 4294967295.0)
+	{
+		log_cb(RETRO_LOG_WARN, LOGPRE "CPU #%d clock %f out of range, using 4294967295Hz\n", cpunum, clock);
+		clock = 4294967295.0;
+	}
+
+	sec_to_cycles[cpunum] = clock;
+	cycles_to_sec[cpunum] = 1.0 / clock;
+
+	/* both fixed-point constants come from the same whole-Hz rate */
+	hz = (UINT32)(clock + 0.5);
+	cycles_per_second[cpunum] = hz;
+	subseconds_per_cycle[cpunum] = MAX_SUBSECONDS / (subseconds_t)hz;
+}
+
+
+
+/*-------------------------------------------------
+	get_current_time - return the current time
+	from the perspective of the caller
+-------------------------------------------------*/
+
+static INLINE mame_time get_current_time(void)
+{
+	mame_time result;
 	int activecpu;
 
 	/* if we're executing as a particular CPU, use its local time as a base */
 	activecpu = cpu_getactivecpu();
 	if (activecpu >= 0)
-		return cpunum_get_localtime(activecpu);
+	{
+		cpunum_get_localtime(activecpu, &result);
+		return result;
+	}
 	
 	/* if we're currently in a callback, use the timer's expiration time as a base */
 	if (callback_timer)
 		return callback_timer_expire_time;
 	
-	/* otherwise, return 0 */
-	return 0;
+	/* otherwise, the global time */
+	return global_basetime;
+}
+
+
+
+/*-------------------------------------------------
+	timer_free_list_add - put a timer at the tail
+	of the free list, so entries are reused in
+	the order they were released
+-------------------------------------------------*/
+
+static INLINE void timer_free_list_add(mame_timer *timer)
+{
+	timer->tag = -1;
+	timer->heap_index = -1;
+	timer->next = NULL;
+	if (timer_free_tail)
+		timer_free_tail->next = timer;
+	else
+		timer_free_head = timer;
+	timer_free_tail = timer;
+}
+
+
+
+/*-------------------------------------------------
+	timer_new_block - grow the pool by one block,
+	and the heap so it can hold every timer
+-------------------------------------------------*/
+
+static int timer_new_block(void)
+{
+	int size = (timer_block_count + 1) * TIMER_BLOCK_SIZE;
+	struct timer_block *block;
+	int i;
+
+	/* make room in the heap first, so inserting can never fail */
+	if (size > timer_heap_size)
+	{
+		mame_timer **heap = realloc(timer_heap, size * sizeof(*heap));
+		if (!heap)
+			return 0;
+		timer_heap = heap;
+		timer_heap_size = size;
+	}
+
+	block = malloc(sizeof(*block));
+	if (!block)
+		return 0;
+	memset(block, 0, sizeof(*block));
+
+	block->next = timer_blocks;
+	timer_blocks = block;
+	timer_block_count++;
+
+	for (i = 0; i < TIMER_BLOCK_SIZE; i++)
+		timer_free_list_add(&block->timers[i]);
+	return 1;
 }
 
 
@@ -113,9 +273,14 @@ static INLINE mame_timer *timer_new(void)
 {
 	mame_timer *timer;
 
-	/* remove an empty entry */
-	if (!timer_free_head)
+	/* grow the pool if we're out of entries */
+	if (!timer_free_head && !timer_new_block())
+	{
+		log_cb(RETRO_LOG_ERROR, LOGPRE "Out of memory allocating timers!\n");
 		return NULL;
+	}
+
+	/* remove an empty entry */
 	timer = timer_free_head;
 	timer_free_head = timer->next;
 	if (!timer_free_head)
@@ -127,91 +292,121 @@ static INLINE mame_timer *timer_new(void)
 
 
 /*-------------------------------------------------
-	timer_list_insert - insert a new timer into
-	the list at the appropriate location
+	timer_heap_before - return true if timer a
+	should fire before timer b
 -------------------------------------------------*/
 
-static INLINE void timer_list_insert(mame_timer *timer)
+static INLINE int timer_heap_before(const mame_timer *a, const mame_timer *b)
 {
-	double expire = timer->enabled ? timer->expire : TIME_NEVER;
-	mame_timer *t, *lt = NULL;
+	int diff = compare_mame_times(a->key, b->key);
 
-	/* sanity checks for the debug build */
-	#ifdef MAME_DEBUG
-	{
-		int tnum = 0;
+	/* two equal entries need to fire in the order they were inserted */
+	if (diff)
+		return diff < 0;
+	return (INT32)(a->sequence - b->sequence) < 0;
+}
 
-		/* loop over the timer list */
-		for (t = timer_head; t; t = t->next, tnum++)
-		{
-			if (t == timer)
-				log_cb(RETRO_LOG_ERROR, LOGPRE "This timer is already inserted in the list!\n");
-			if (tnum == MAX_TIMERS-1)
-				log_cb(RETRO_LOG_ERROR, LOGPRE "Timer list is full!\n");
-		}
-	}
-	#endif
 
-	/* loop over the timer list */
-	for (t = timer_head; t; lt = t, t = t->next)
+
+/*-------------------------------------------------
+	timer_heap_sift_up/down - restore the heap
+	order around one entry
+-------------------------------------------------*/
+
+static INLINE void timer_heap_sift_up(int index)
+{
+	mame_timer *timer = timer_heap[index];
+
+	while (index > 0)
 	{
-		/* if the current list entry expires after us, we should be inserted before it */
-		/* note that due to floating point rounding, we need to allow a bit of slop here */
-		/* because two equal entries -- within rounding precision -- need to sort in */
-		/* the order they were inserted into the list */
-		if ((t->expire - expire) > TIME_IN_NSEC(1))
-		{
-			/* link the new guy in before the current list entry */
-			timer->prev = t->prev;
-			timer->next = t;
+		int parent = (index - 1) / 2;
+		if (!timer_heap_before(timer, timer_heap[parent]))
+			break;
+		timer_heap[index] = timer_heap[parent];
+		timer_heap[index]->heap_index = index;
+		index = parent;
+	}
+	timer_heap[index] = timer;
+	timer->heap_index = index;
+}
 
-			if (t->prev)
-				t->prev->next = timer;
-			else
-				timer_head = timer;
-			t->prev = timer;
-			return;
-		}
+static INLINE void timer_heap_sift_down(int index)
+{
+	mame_timer *timer = timer_heap[index];
+
+	for (;;)
+	{
+		int child = index * 2 + 1;
+		if (child >= timer_heap_count)
+			break;
+		if (child + 1 < timer_heap_count && timer_heap_before(timer_heap[child + 1], timer_heap[child]))
+			child++;
+		if (!timer_heap_before(timer_heap[child], timer))
+			break;
+		timer_heap[index] = timer_heap[child];
+		timer_heap[index]->heap_index = index;
+		index = child;
 	}
+	timer_heap[index] = timer;
+	timer->heap_index = index;
+}
 
-	/* need to insert after the last one */
-	if (lt)
-		lt->next = timer;
-	else
-		timer_head = timer;
-	timer->prev = lt;
-	timer->next = NULL;
+
+
+/*-------------------------------------------------
+	timer_list_insert - insert a new timer into
+	the heap at the appropriate location
+-------------------------------------------------*/
+
+static INLINE void timer_list_insert(mame_timer *timer)
+{
+	/* sanity checks for the debug build */
+	#ifdef MAME_DEBUG
+	if (timer->heap_index >= 0)
+		log_cb(RETRO_LOG_ERROR, LOGPRE "This timer is already inserted in the list!\n");
+	#endif
+
+	timer->key = timer->enabled ? timer->expire : time_never;
+	timer->sequence = timer_sequence++;
+
+	/* timer_new_block() keeps the heap as large as the pool */
+	timer_heap[timer_heap_count] = timer;
+	timer_heap_sift_up(timer_heap_count++);
 }
 
 
 
 /*-------------------------------------------------
 	timer_list_remove - remove a timer from the
-	linked list
+	heap
 -------------------------------------------------*/
 
 static INLINE void timer_list_remove(mame_timer *timer)
 {
+	int index = timer->heap_index;
+	mame_timer *last;
+
 	/* sanity checks for the debug build */
 	#ifdef MAME_DEBUG
+	if (index < 0 || index >= timer_heap_count || timer_heap[index] != timer)
 	{
-		mame_timer *t;
-		int tnum = 0;
-
-		/* loop over the timer list */
-		for (t = timer_head; t && t != timer; t = t->next, tnum++) ;
-		if (t == NULL)
-			printf ("timer not found in list");
+		log_cb(RETRO_LOG_ERROR, LOGPRE "timer not found in list\n");
+		return;
 	}
 	#endif
 
-	/* remove it from the list */
-	if (timer->prev)
-		timer->prev->next = timer->next;
+	timer->heap_index = -1;
+
+	/* move the last entry into the hole and let it find its place */
+	last = timer_heap[--timer_heap_count];
+	if (last == timer)
+		return;
+	timer_heap[index] = last;
+	last->heap_index = index;
+	if (index > 0 && timer_heap_before(last, timer_heap[(index - 1) / 2]))
+		timer_heap_sift_up(index);
 	else
-		timer_head = timer->next;
-	if (timer->next)
-		timer->next->prev = timer->prev;
+		timer_heap_sift_down(index);
 }
 
 
@@ -222,26 +417,27 @@ static INLINE void timer_list_remove(mame_timer *timer)
 
 void timer_init(void)
 {
+	struct timer_block *block;
 	int i;
 
 	/* we need to wait until the first call to timer_cyclestorun before using real CPU times */
-	global_offset = 0.0;
+	global_basetime = time_zero;
 	callback_timer = NULL;
 	callback_timer_modified = 0;
 
-	/* reset the timers */
-	memset(timers, 0, sizeof(timers));
+	/* empty the heap */
+	timer_heap_count = 0;
+	timer_sequence = 0;
 
-	/* initialize the lists */
-	timer_head = NULL;
-	timer_free_head = &timers[0];
-	for (i = 0; i < MAX_TIMERS-1; i++)
+	/* put every timer we already have back on the free list; blocks are */
+	/* kept for the next machine rather than freed */
+	timer_free_head = timer_free_tail = NULL;
+	for (block = timer_blocks; block; block = block->next)
 	{
-		timers[i].tag = -1;
-		timers[i].next = &timers[i+1];
+		memset(block->timers, 0, sizeof(block->timers));
+		for (i = 0; i < TIMER_BLOCK_SIZE; i++)
+			timer_free_list_add(&block->timers[i]);
 	}
-	timers[MAX_TIMERS-1].next = NULL;
-	timer_free_tail = &timers[MAX_TIMERS-1];
 }
 
 
@@ -254,64 +450,65 @@ void timer_init(void)
 void timer_free(void)
 {
 	int tag = get_resource_tag();
-	mame_timer *timer, *next;
+	struct timer_block *block;
+	int i;
 
-	/* scan the list */
-	for (timer = timer_head; timer != NULL; timer = next)
-	{
-		/* prefetch the next timer in case we remove this one */
-		next = timer->next;
+	/* scan the whole pool; free entries are tagged -1 and never match */
+	for (block = timer_blocks; block; block = block->next)
+		for (i = 0; i < TIMER_BLOCK_SIZE; i++)
+			if (block->timers[i].tag == tag)
+				timer_remove(&block->timers[i]);
+}
 
-		/* if this tag matches, remove it */
-		if (timer->tag == tag)
-			timer_remove(timer);
-	}
+
+
+/*-------------------------------------------------
+	mame_timer_next_fire_time - return the
+	absolute time when the next timer fires
+-------------------------------------------------*/
+
+void mame_timer_next_fire_time(mame_time *result)
+{
+	*result = timer_heap[0]->key;
 }
 
 
 
 /*-------------------------------------------------
-	timer_time_until_next_timer - return the
-	amount of time until the next timer fires
+	mame_timer_get_time - return the global time
 -------------------------------------------------*/
 
-double timer_time_until_next_timer(void)
+void mame_timer_get_time(mame_time *result)
 {
-	double time = get_relative_time();
-	return timer_head->expire - time;
+	*result = global_basetime;
 }
 
 
 
 /*-------------------------------------------------
-	timer_adjust_global_time - adjust the global
-	time; this is also where we fire the timers
+	mame_timer_set_global_time - advance the
+	global time; this is also where we fire the
+	timers
 -------------------------------------------------*/
 
-void timer_adjust_global_time(double delta)
+void mame_timer_set_global_time(mame_time newbase)
 {
 	mame_timer *timer;
 
-	/* add the delta to the global offset */
-	global_offset += delta;
-
-	/* scan the list and adjust the times */
-	for (timer = timer_head; timer != NULL; timer = timer->next)
-	{
-		timer->start -= delta;
-		timer->expire -= delta;
-	}
+	/* timer times are absolute, so nothing else needs to move */
+	global_basetime = newbase;
 
-	log_cb(RETRO_LOG_DEBUG, LOGPRE "timer_adjust_global_time: delta=%.9f head->expire=%.9f\n", delta, timer_head->expire);
+	log_trace(TIMER, (RETRO_LOG_DEBUG, LOGPRE "mame_timer_set_global_time: base=%.9f head->expire=%.9f\n", mame_time_to_double(newbase), mame_time_to_double(timer_heap[0]->key)));
 
 	/* now process any timers that are overdue */
-	while (timer_head->expire < TIME_IN_NSEC(1))
+	while (compare_mame_times(timer_heap[0]->key, global_basetime) <= 0)
 	{
-		int was_enabled = timer_head->enabled;
+		int was_enabled;
 
 		/* if this is a one-shot timer, disable it now */
-		timer = timer_head;
-		if (timer->period == 0)
+		timer = timer_heap[0];
+		was_enabled = timer->enabled;
+		if (timer->period.seconds == 0 && timer->period.subseconds == 0)
 			timer->enabled = 0;
 
 		/* set the global state of which callback we're in */
@@ -322,7 +519,7 @@ void timer_adjust_global_time(double delta)
 		/* call the callback */
 		if (was_enabled && timer->callback)
 		{
-			log_cb(RETRO_LOG_DEBUG, LOGPRE "Timer %08X fired (expire=%.9f)\n", (UINT32)timer, timer->expire);
+			log_trace(TIMER, (RETRO_LOG_DEBUG, LOGPRE "Timer %08X fired (expire=%.9f)\n", (UINT32)timer, mame_time_to_double(timer->expire)));
 			profiler_mark(PROFILER_TIMER_CALLBACK);
 			(*timer->callback)(timer->callback_param);
 			profiler_mark(PROFILER_END);
@@ -342,7 +539,7 @@ void timer_adjust_global_time(double delta)
 			else
 			{
 				timer->start = timer->expire;
-				timer->expire += timer->period;
+				timer->expire = add_mame_times(timer->expire, timer->period);
 
 				timer_list_remove(timer);
 				timer_list_insert(timer);
@@ -360,7 +557,7 @@ void timer_adjust_global_time(double delta)
 
 mame_timer *timer_alloc(void (*callback)(int))
 {
-	double time = get_relative_time();
+	mame_time time = get_current_time();
 	mame_timer *timer = timer_new();
 
 	/* fail if we can't allocate a new entry */
@@ -373,11 +570,11 @@ mame_timer *timer_alloc(void (*callback)(int))
 	timer->enabled = 0;
 	timer->temporary = 0;
 	timer->tag = get_resource_tag();
-	timer->period = 0;
+	timer->period = time_zero;
 
 	/* compute the time of the next firing and insert into the list */
 	timer->start = time;
-	timer->expire = TIME_NEVER;
+	timer->expire = time_never;
 	timer_list_insert(timer);
 
 	/* return a handle */
@@ -387,14 +584,14 @@ mame_timer *timer_alloc(void (*callback)(int))
 
 
 /*-------------------------------------------------
-	timer_adjust - adjust the time when this
+	mame_timer_adjust - adjust the time when this
 	timer will fire, and whether or not it will
 	fire periodically
 -------------------------------------------------*/
 
-void timer_adjust(mame_timer *which, double duration, int param, double period)
+static void mame_timer_adjust(mame_timer *which, mame_time duration, int param, mame_time period)
 {
-	double time = get_relative_time();
+	mame_time time = get_current_time();
 
 	/* if this is the callback timer, mark it modified */
 	if (which == callback_timer)
@@ -406,7 +603,7 @@ void timer_adjust(mame_timer *which, double duration, int param, double period)
 
 	/* set the start and expire times */
 	which->start = time;
-	which->expire = time + duration;
+	which->expire = add_mame_times(time, duration);
 	which->period = period;
 
 	/* remove and re-insert the timer in its new order */
@@ -414,11 +611,20 @@ void timer_adjust(mame_timer *which, double duration, int param, double period)
 	timer_list_insert(which);
 
 	/* if this was inserted as the head, abort the current timeslice and resync */
-  log_cb(RETRO_LOG_DEBUG, LOGPRE "timer_adjust %08X to expire @ %.9f\n", (UINT32)which, which->expire);
-	if (which == timer_head && cpu_getexecutingcpu() >= 0)
+  log_trace(TIMER, (RETRO_LOG_DEBUG, LOGPRE "timer_adjust %08X to expire @ %.9f\n", (UINT32)which, mame_time_to_double(which->expire)));
+	if (which == timer_heap[0] && cpu_getexecutingcpu() >= 0)
 		activecpu_abort_timeslice();
 }
 
+void timer_adjust(mame_timer *which, double duration, int param, double period)
+{
+	mame_time mduration, mperiod;
+
+	double_to_mame_time(duration, &mduration);
+	double_to_mame_time(period, &mperiod);
+	mame_timer_adjust(which, mduration, param, mperiod);
+}
+
 
 
 /*-------------------------------------------------
@@ -469,8 +675,11 @@ void timer_set(double duration, int param, void (*callback)(int))
 
 void timer_reset(mame_timer *which, double duration)
 {
+	mame_time mduration;
+
 	/* adjust the timer */
-	timer_adjust(which, duration, which->callback_param, which->period);
+	double_to_mame_time(duration, &mduration);
+	mame_timer_adjust(which, mduration, which->callback_param, which->period);
 }
 
 
@@ -488,19 +697,15 @@ void timer_remove(mame_timer *which)
 		return;
 	}
 
+	/* if this is the callback timer, don't let the caller reschedule it */
+	if (which == callback_timer)
+		callback_timer_modified = 1;
+
 	/* remove it from the list */
 	timer_list_remove(which);
 
-	/* mark it as dead */
-	which->tag = -1;
-
-	/* free it up by adding it back to the free list */
-	if (timer_free_tail)
-		timer_free_tail->next = which;
-	else
-		timer_free_head = which;
-	which->next = NULL;
-	timer_free_tail = which;
+	/* mark it as dead and free it up by adding it back to the free list */
+	timer_free_list_add(which);
 }
 
 
@@ -533,8 +738,7 @@ int timer_enable(mame_timer *which, int enable)
 
 double timer_timeelapsed(mame_timer *which)
 {
-	double time = get_relative_time();
-	return time - which->start;
+	return mame_time_to_double(sub_mame_times(get_current_time(), which->start));
 }
 
 
@@ -546,8 +750,7 @@ double timer_timeelapsed(mame_timer *which)
 
 double timer_timeleft(mame_timer *which)
 {
-	double time = get_relative_time();
-	return which->expire - time;
+	return mame_time_to_double(sub_mame_times(which->expire, get_current_time()));
 }
 
 
@@ -558,7 +761,7 @@ double timer_timeleft(mame_timer *which)
 
 double timer_get_time(void)
 {
-	return global_offset + get_relative_time();
+	return mame_time_to_double(get_current_time());
 }
 
 
@@ -570,7 +773,7 @@ double timer_get_time(void)
 
 double timer_starttime(mame_timer *which)
 {
-	return global_offset + which->start;
+	return mame_time_to_double(which->start);
 }
 
 
@@ -582,5 +785,5 @@ double timer_starttime(mame_timer *which)
 
 double timer_firetime(mame_timer *which)
 {
-	return global_offset + which->expire;
+	return mame_time_to_double(which->expire);
 }
@@ -32,10 +32,115 @@ extern double sec_to_cycles[];
 typedef struct _mame_timer mame_timer;
 
 
+
+/*-------------------------------------------------
+	fixed point time
+
+	The scheduler keeps time as whole seconds plus
+	attoseconds (1e-18 s), so the CPU and timer
+	bookkeeping is done in integer math and does not
+	drift over long sessions. The double based API
+	above is still what drivers use; values are
+	converted at that boundary only.
+-------------------------------------------------*/
+
+typedef INT32 seconds_t;
+typedef INT64 subseconds_t;
+
+typedef struct
+{
+	seconds_t		seconds;
+	subseconds_t	subseconds;		/* always 0 <= subseconds < MAX_SUBSECONDS */
+} mame_time;
+
+#define MAX_SECONDS				((seconds_t)1000000000)
+#define MAX_SUBSECONDS			((subseconds_t)1000000000 * (subseconds_t)1000000000)
+
+extern mame_time time_zero;
+extern mame_time time_never;
+
+/* per-CPU cycle lengths, kept in step with cycles_to_sec[] */
+extern subseconds_t subseconds_per_cycle[];
+extern UINT32 cycles_per_second[];
+
+void double_to_mame_time(double time, mame_time *result);
+double mame_time_to_double(mame_time time);
+
+static INLINE mame_time add_mame_times(mame_time a, mame_time b)
+{
+	mame_time result;
+
+	/* anything involving never is never */
+	if (a.seconds >= MAX_SECONDS || b.seconds >= MAX_SECONDS)
+		return time_never;
+
+	result.seconds = a.seconds + b.seconds;
+	result.subseconds = a.subseconds + b.subseconds;
+	if (result.subseconds >= MAX_SUBSECONDS)
+	{
+		result.subseconds -= MAX_SUBSECONDS;
+		result.seconds++;
+	}
+	return result;
+}
+
+static INLINE mame_time sub_mame_times(mame_time a, mame_time b)
+{
+	mame_time result;
+
+	if (a.seconds >= MAX_SECONDS)
+		return time_never;
+
+	/* seconds may go negative; subseconds stay normalized */
+	result.seconds = a.seconds - b.seconds;
+	result.subseconds = a.subseconds - b.subseconds;
+	if (result.subseconds < 0)
+	{
+		result.subseconds += MAX_SUBSECONDS;
+		result.seconds--;
+	}
+	return result;
+}
+
+static INLINE int compare_mame_times(mame_time a, mame_time b)
+{
+	if (a.seconds != b.seconds)
+		return (a.seconds < b.seconds) ? -1 : 1;
+	if (a.subseconds != b.subseconds)
+		return (a.subseconds < b.subseconds) ? -1 : 1;
+	return 0;
+}
+
+/* the length of a number of cycles, without going through floating point */
+static INLINE mame_time cycles_to_mame_time(int cpunum, INT64 cycles)
+{
+	mame_time result;
+	INT64 seconds = cycles / cycles_per_second[cpunum];
+
+	cycles -= seconds * cycles_per_second[cpunum];
+	if (cycles < 0)
+	{
+		cycles += cycles_per_second[cpunum];
+		seconds--;
+	}
+	result.seconds = (seconds_t)seconds;
+	result.subseconds = cycles * subseconds_per_cycle[cpunum];
+	return result;
+}
+
+/* whole cycles that fit in a duration, truncated like TIME_TO_CYCLES */
+static INLINE INT64 mame_time_to_cycles(int cpunum, mame_time time)
+{
+	return (INT64)time.seconds * cycles_per_second[cpunum] + time.subseconds / subseconds_per_cycle[cpunum];
+}
+
+
 void timer_init(void);
 void timer_free(void);
-double timer_time_until_next_timer(void);
-void timer_adjust_global_time(double delta);
+void timer_set_cpu_clock(int cpunum, double clock);
+void mame_timer_next_fire_time(mame_time *result);
+void mame_timer_get_time(mame_time *result);
+void mame_timer_set_global_time(mame_time newbase);
 mame_timer *timer_alloc(void (*callback)(int));
 void timer_adjust(mame_timer *which, double duration, int param, double period);
 void timer_pulse(double period, int param, void (*callback)(int));
@@ -51,6 +51,18 @@ typedef struct _ZIP {
 
 	struct zipent ent; /* buffer for readzip */
 
+	/* central directory index, built on the first lookup */
+	struct zipent* index; /* all entries in directory order */
+	char* index_names; /* names of the index entries */
+	unsigned index_count;
+	unsigned hash_mask; /* hash table size - 1 */
+	int* name_hash; /* index by lowercase basename, -1 for empty slots */
+	int* crc_hash; /* index by CRC32, -1 for empty slots */
+
+	/* zip cache */
+	struct _ZIP* cache_next; /* next older zip in the cache */
+	size_t cache_size; /* memory held, as counted against the cache bound */
+
 	/* end_of_cent_dir */
 	UINT32	end_of_cent_dir_sig;
 	UINT16	number_of_this_disk;
@@ -125,11 +137,21 @@ int readuncompresszip(ZIP* zip, struct zipent* ent, char* data);
 
 /* public functions */
 int /* error */ load_zipped_file (int pathtype, int pathindex, const char *zipfile, const char *filename,
-	unsigned char **buf, unsigned int *length);
+	unsigned char **buf, unsigned int *length, unsigned int *crc, int *mapped);
 int /* error */ checksum_zipped_file (int pathtype, int pathindex, const char *zipfile, const char *filename, unsigned int *length, unsigned int *sum);
 
+/* Close everything in the zip cache */
 void unzip_cache_clear(void);
 
+/* Close the file handles held by the zip cache, keeping the parsed
+   directories; call once loading is done */
+void unzip_cache_suspend(void);
+
+/* Serialize access to the zip cache so load_zipped_file() and
+   checksum_zipped_file() can be called from several threads; call with
+   !=0 before starting them and with 0 once they are done */
+void unzip_set_threaded(int threaded);
+
 /* public globals */
 extern int	gUnzipQuiet;	/* flag controls error messages */
 
@@ -339,7 +339,7 @@ static void NeoMVSDrawGfxLine(UINT16 **line,const struct GfxElement *gfx,
 	code %= no_of_tiles;
 
 	/* Check for total transparency, no need to draw */
-	if ((gfx->pen_usage[code] & ~1) == 0)
+	if ((gfx_element_get_pen_usage(gfx,code) & ~1) == 0)
 		return;
 
 	fspr += code*128 + 8*yoffs;
@@ -455,7 +455,6 @@ VIDEO_UPDATE( neogeo )
 	int tileno,tileatr,t1,t2,t3;
 	char fullmode = 0;
 	void **line=bitmap->line;
-	unsigned int *pen_usage;
 	struct GfxElement *gfx=Machine->gfx[2]; /* Save constant struct dereference */
 
 profiler_mark(PROFILER_VIDEO);
@@ -598,7 +597,6 @@ profiler_mark(PROFILER_VIDEO);
 
 	/* Save some struct de-refs */
 	gfx = Machine->gfx[fix_bank];
-	pen_usage=gfx->pen_usage;
 
 	/* Character foreground */
 	/* thanks to Mr K for the garou & kof2000 banking info */
@@ -649,7 +647,7 @@ profiler_mark(PROFILER_VIDEO);
 					}
 
 
-					if ((pen_usage[byte1] & ~1) == 0) continue;
+					if ((gfx_element_get_pen_usage(gfx,byte1) & ~1) == 0) continue;
 
 					drawgfx(bitmap,gfx,
 							byte1,
@@ -670,7 +668,7 @@ profiler_mark(PROFILER_VIDEO);
 					int byte2 = byte1 >> 12;
 					byte1 = byte1 & 0xfff;
 
-					if ((pen_usage[byte1] & ~1) == 0) continue;
+					if ((gfx_element_get_pen_usage(gfx,byte1) & ~1) == 0) continue;
 
 					drawgfx(bitmap,gfx,
 							byte1,
@@ -8,9 +8,19 @@
 **
 **#################################################################################################*/
 
+#if defined(__x86_64__) || defined(__amd64__)
+/* MAP_ANONYMOUS is hidden by -D_XOPEN_SOURCE=500 */
+#define _DEFAULT_SOURCE
+#define _DARWIN_C_SOURCE
+#endif
+
 #include "driver.h"
 #include "x86drc.h"
 
+#ifdef DRC_X64
+#include <sys/mman.h>
+#endif
+
 #define LOG_DISPATCHES		0
 
 
@@ -24,12 +34,53 @@ static UINT16 fp_control[4] = { 0x23f, 0x63f, 0xa3f, 0xe3f };
 static void append_entry_point(struct drccore *drc);
 static void append_recompile(struct drccore *drc);
 static void append_out_of_cycles(struct drccore *drc);
+#ifdef DRC_X64
+static void append_call_thunk(struct drccore *drc);
+#endif
 
 #if LOG_DISPATCHES
 static void log_dispatch(struct drccore *drc);
 #endif
 
 
+#ifdef DRC_X64
+/*------------------------------------------------------------------
+	alloc_near_core - map executable memory
+	close enough to the core's static data that
+	generated code can address it RIP-relative
+------------------------------------------------------------------*/
+
+static void *alloc_near_core(size_t size)
+{
+	const FPTR anchor = (FPTR)&fp_control[0];
+	const FPTR step = 64 << 20;
+	FPTR offset;
+
+	/* ask for addresses moving away from the core in both directions */
+	for (offset = step; offset < ((FPTR)1 << 30); offset += step)
+	{
+		int dir;
+		for (dir = 0; dir < 2; dir++)
+		{
+			FPTR hint = dir ? anchor + offset : anchor - offset - size;
+			void *base = mmap((void *)(hint & ~(FPTR)0xffff), size, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			INT64 lo, hi;
+
+			if (base == MAP_FAILED)
+				continue;
+			lo = (INT64)((FPTR)base - anchor);
+			hi = lo + (INT64)size;
+			if (lo > -((INT64)1 << 30) && hi < ((INT64)1 << 30))
+				return base;
+			munmap(base, size);
+		}
+	}
+	return NULL;
+}
+#endif
+
+
+
 /*###################################################################################################
 **	EXTERNAL INTERFACES
 **#################################################################################################*/
@@ -45,12 +96,27 @@ struct drccore *drc_init(UINT8 cpunum, struct drcconfig *config)
 	struct drccore *drc;
 
 	/* allocate memory */
+#ifdef DRC_X64
+	/* the structure and the cache share one mapping, so that both the */
+	/* structure's fields and the core's statics are in reach of the code */
+	size_t header = (sizeof(*drc) + 63) & ~63;
+	drc = alloc_near_core(header + config->cache_size);
+	if (!drc)
+	{
+		log_cb(RETRO_LOG_ERROR, LOGPRE "drc_init: unable to map the code cache near the core\n");
+		return NULL;
+	}
+	memset(drc, 0, sizeof(*drc));
+	drc->alloc_size = header + config->cache_size;
+#else
 	drc = malloc(sizeof(*drc));
 	if (!drc)
 		return NULL;
 	memset(drc, 0, sizeof(*drc));
+#endif
 
 	/* copy in relevant data from the config */
+	drc->cpunum       = cpunum;
 	drc->pcptr        = config->pcptr;
 	drc->icountptr    = config->icountptr;
 	drc->esiptr       = config->esiptr;
@@ -62,24 +128,39 @@ struct drccore *drc_init(UINT8 cpunum, struct drcconfig *config)
 	drc->fpcw_curr    = fp_control[0];
 
 	/* allocate cache */
+#ifdef DRC_X64
+	drc->cache_base = (UINT8 *)drc + header;
+#else
 	drc->cache_base = malloc(config->cache_size);
 	if (!drc->cache_base)
-		return NULL;
+		goto error;
+#endif
 	drc->cache_end = drc->cache_base + config->cache_size;
 	drc->cache_danger = drc->cache_end - 65536;
 
+#ifdef DRC_X64
+	/* the core's statics are addressed RIP-relative from all over the cache */
+	if ((config->pcptr && !drc_in_reach(drc, config->pcptr)) ||
+		(config->icountptr && !drc_in_reach(drc, config->icountptr)) ||
+		(config->esiptr && !drc_in_reach(drc, config->esiptr)))
+	{
+		log_cb(RETRO_LOG_ERROR, LOGPRE "drc_init: the core's data is out of reach of the code cache\n");
+		goto error;
+	}
+#endif
+
 	/* compute shifts and masks */
 	drc->l1bits = effective_address_bits/2;
 	drc->l2bits = effective_address_bits - drc->l1bits;
 	drc->l1shift = config->lsbs_to_ignore + drc->l2bits;
 	drc->l2mask = ((1 << drc->l2bits) - 1) << config->lsbs_to_ignore;
-	drc->l2scale = 4 >> config->lsbs_to_ignore;
+	drc->l2scale = sizeof(void *) >> config->lsbs_to_ignore;
 
 	/* allocate lookup tables */
 	drc->lookup_l1 = malloc(sizeof(*drc->lookup_l1) * (1 << drc->l1bits));
 	drc->lookup_l2_recompile = malloc(sizeof(*drc->lookup_l2_recompile) * (1 << drc->l2bits));
 	if (!drc->lookup_l1 || !drc->lookup_l2_recompile)
-		return NULL;
+		goto error;
 	memset(drc->lookup_l1, 0, sizeof(*drc->lookup_l1) * (1 << drc->l1bits));
 	memset(drc->lookup_l2_recompile, 0, sizeof(*drc->lookup_l2_recompile) * (1 << drc->l2bits));
 
@@ -89,11 +170,22 @@ struct drccore *drc_init(UINT8 cpunum, struct drcconfig *config)
 	drc->tentative_count_max = config->max_instructions;
 	drc->tentative_list = malloc(drc->tentative_count_max * sizeof(*drc->tentative_list));
 	if (!drc->sequence_list || !drc->tentative_list)
-		return NULL;
+		goto error;
+
+	/* allocate the block list; sequences average well over 256 bytes, so the */
+	/* cache normally fills first, and recompile_code resets it either way */
+	drc->block_count_max = config->cache_size / 256;
+	drc->block_list = malloc(drc->block_count_max * sizeof(*drc->block_list));
+	if (!drc->block_list)
+		goto error;
 
 	/* seed the cache */
 	drc_cache_reset(drc);
 	return drc;
+
+error:
+	drc_exit(drc);
+	return NULL;
 }
 
 
@@ -103,12 +195,21 @@ struct drccore *drc_init(UINT8 cpunum, struct drcconfig *config)
 
 void drc_cache_reset(struct drccore *drc)
 {
+	offs_t stale_start, stale_end;
 	int i;
 
 	/* reset the cache and add the basics */
 	drc->cache_top = drc->cache_base;
+	drc->block_count = 0;
+
+	/* whatever was invalidated so far went with the old cache */
+	memory_get_stale_opcodes(drc->cpunum, &stale_start, &stale_end);
 
 	/* append the core entry points to the fresh cache */
+#ifdef DRC_X64
+	drc->call_thunk = drc->cache_top;
+	append_call_thunk(drc);
+#endif
 	drc->entry_point = (void (*)(void))drc->cache_top;
 	append_entry_point(drc);
 	drc->out_of_cycles = drc->cache_top;
@@ -146,6 +247,15 @@ void drc_cache_reset(struct drccore *drc)
 
 void drc_execute(struct drccore *drc)
 {
+#ifdef DRC_X64
+	/* a halted CPU just burns its cycles */
+	if (drc->out_of_reach)
+	{
+		*drc->icountptr = 0;
+		return;
+	}
+#endif
+	drc_sync_opcodes(drc);
 	(*drc->entry_point)();
 }
 
@@ -159,13 +269,17 @@ void drc_exit(struct drccore *drc)
 	int i;
 
 	/* free the cache */
+#ifndef DRC_X64
 	if (drc->cache_base)
 		free(drc->cache_base);
+#endif
 
-	/* free all the l2 tables allocated */
-	for (i = 0; i < (1 << drc->l1bits); i++)
-		if (drc->lookup_l1[i] != drc->lookup_l2_recompile)
-			free(drc->lookup_l1[i]);
+	/* free all the l2 tables allocated; the l1 table is only */
+	/* initialized once both tables exist */
+	if (drc->lookup_l1 && drc->lookup_l2_recompile)
+		for (i = 0; i < (1 << drc->l1bits); i++)
+			if (drc->lookup_l1[i] != drc->lookup_l2_recompile)
+				free(drc->lookup_l1[i]);
 
 	/* free the l1 table */
 	if (drc->lookup_l1)
@@ -180,9 +294,15 @@ void drc_exit(struct drccore *drc)
 		free(drc->sequence_list);
 	if (drc->tentative_list)
 		free(drc->tentative_list);
+	if (drc->block_list)
+		free(drc->block_list);
 
 	/* and the drc itself */
+#ifdef DRC_X64
+	munmap(drc, drc->alloc_size);
+#else
 	free(drc);
+#endif
 }
 
 
@@ -193,7 +313,8 @@ void drc_exit(struct drccore *drc)
 void drc_begin_sequence(struct drccore *drc, UINT32 pc)
 {
 	UINT32 l1index = pc >> drc->l1shift;
-	UINT32 l2index = ((pc & drc->l2mask) * drc->l2scale) / 4;
+	UINT32 l2index = ((pc & drc->l2mask) * drc->l2scale) / sizeof(void *);
+	struct drcblock *block;
 
 	/* reset the sequence and tentative counts */
 	drc->sequence_count = 0;
@@ -209,6 +330,11 @@ void drc_begin_sequence(struct drccore *drc, UINT32 pc)
 		memcpy(drc->lookup_l1[l1index], drc->lookup_l2_recompile, sizeof(*drc->lookup_l2_recompile) * (1 << drc->l2bits));
 	}
 
+	/* code here already means its verification failed: the opcode */
+	/* changed, so every other sequence covering it is stale too */
+	if (drc->lookup_l1[l1index][l2index] != drc->recompile)
+		drc_invalidate_range(drc, pc, pc);
+
 	/* nuke any previous link to this instruction */
 	if (drc->lookup_l1[l1index][l2index] != drc->recompile)
 	{
@@ -220,17 +346,27 @@ void drc_begin_sequence(struct drccore *drc, UINT32 pc)
 
 	/* note the current location for this instruction */
 	drc->lookup_l1[l1index][l2index] = drc->cache_top;
+
+	/* and start a block for it; recompile_code made room */
+	block = &drc->block_list[drc->block_count++];
+	block->start = block->end = pc;
+	block->code = drc->cache_top;
 }
 
 
 /*------------------------------------------------------------------
-	drc_end_sequence
+	drc_end_sequence - lastpc is the last PC the
+	sequence's code depends on, including any
+	delay slot
 ------------------------------------------------------------------*/
 
-void drc_end_sequence(struct drccore *drc)
+void drc_end_sequence(struct drccore *drc, UINT32 lastpc)
 {
 	int i, j;
 
+	/* record the span */
+	drc->block_list[drc->block_count - 1].end = lastpc;
+
 	/* fix up any internal links */
 	for (i = 0; i < drc->tentative_count; i++)
 		for (j = 0; j < drc->sequence_count; j++)
@@ -269,17 +405,82 @@ void drc_register_code_at_cache_top(struct drccore *drc, UINT32 pc)
 void *drc_get_code_at_pc(struct drccore *drc, UINT32 pc)
 {
 	UINT32 l1index = pc >> drc->l1shift;
-	UINT32 l2index = ((pc & drc->l2mask) * drc->l2scale) / 4;
+	UINT32 l2index = ((pc & drc->l2mask) * drc->l2scale) / sizeof(void *);
 	return (drc->lookup_l1[l1index][l2index] != drc->recompile) ? drc->lookup_l1[l1index][l2index] : NULL;
 }
 
 
+/*------------------------------------------------------------------
+	drc_invalidate_range - drop every sequence
+	covering a PC between start and end; the code
+	stays in the cache until it is next reset, but
+	is only reached again through the dispatcher
+------------------------------------------------------------------*/
+
+void drc_invalidate_range(struct drccore *drc, UINT32 start, UINT32 end)
+{
+	UINT32 i = 0;
+
+	while (i < drc->block_count)
+	{
+		struct drcblock *block = &drc->block_list[i];
+		if (block->start <= end && block->end >= start)
+		{
+			UINT32 l1index = block->start >> drc->l1shift;
+			UINT32 l2index = ((block->start & drc->l2mask) * drc->l2scale) / sizeof(void *);
+			UINT8 *cache_save = drc->cache_top;
+
+			/* branches back to the start inside the sequence go to the dispatcher */
+			drc->cache_top = block->code;
+			_jmp(drc->dispatch);
+			drc->cache_top = cache_save;
+
+			/* and so does everything else, unless a newer sequence took over */
+			if (drc->lookup_l1[l1index][l2index] == block->code)
+				drc->lookup_l1[l1index][l2index] = drc->recompile;
+
+			*block = drc->block_list[--drc->block_count];
+		}
+		else
+			i++;
+	}
+}
+
+
+/*------------------------------------------------------------------
+	drc_sync_opcodes - drop the sequences covering
+	opcodes the memory system has invalidated
+	since the last call, such as those of a bank
+	that was switched; safe to call from C code
+	the cache calls out to
+------------------------------------------------------------------*/
+
+void drc_sync_opcodes(struct drccore *drc)
+{
+	offs_t start, end;
+
+	if (memory_get_stale_opcodes(drc->cpunum, &start, &end))
+		drc_invalidate_range(drc, start, end);
+}
+
+
 /*------------------------------------------------------------------
 	drc_append_verify_code
 ------------------------------------------------------------------*/
 
 void drc_append_verify_code(struct drccore *drc, void *code, UINT8 length)
 {
+#ifdef DRC_X64
+	/* the code itself may be anywhere in the address space */
+	_mov_r64_imm(REG_R10, code);									/* mov	r10,pc*/
+	if (length >= 4)
+		_cmp_m32bd_imm(REG_R10, 0, *(UINT32 *)code);				/* cmp	[r10],opcode*/
+	else if (length >= 2)
+		_cmp_m16bd_imm(REG_R10, 0, *(UINT16 *)code);				/* cmp	[r10],opcode*/
+	else
+		_cmp_m8bd_imm(REG_R10, 0, *(UINT8 *)code);					/* cmp	[r10],opcode*/
+	_jcc(COND_NE, drc->recompile);									/* jne	recompile*/
+#else
 	if (length >= 4)
 	{
 		_cmp_m32abs_imm(code, *(UINT32 *)code);						/* cmp	[pc],opcode*/
@@ -295,6 +496,7 @@ void drc_append_verify_code(struct drccore *drc, void *code, UINT8 length)
 		_cmp_m8abs_imm(code, *(UINT8 *)code);						/* cmp	[pc],opcode*/
 		_jcc(COND_NE, drc->recompile);								/* jne	recompile*/
 	}
+#endif
 }
 
 
@@ -380,13 +582,18 @@ void drc_append_standard_epilogue(struct drccore *drc, INT32 cycles, INT32 pcdel
 void drc_append_dispatcher(struct drccore *drc)
 {
 #if LOG_DISPATCHES
-	_push_imm(drc);													/* push	drc*/
+	_push_ptr(drc);													/* push	drc*/
 	drc_append_save_call_restore(drc, (void *)log_dispatch, 4);		/* call	log_dispatch*/
 #endif
 	_mov_r32_r32(REG_EAX, REG_EDI);									/* mov	eax,edi*/
 	_shr_r32_imm(REG_EAX, drc->l1shift);							/* shr	eax,l1shift*/
 	_mov_r32_r32(REG_EDX, REG_EDI);									/* mov	edx,edi*/
+#ifdef DRC_X64
+	_mov_r64_imm(REG_R10, drc->lookup_l1);							/* mov	r10,l1lookup*/
+	_mov_r64_m64bisd(REG_EAX, REG_R10, REG_EAX, 8, 0);				/* mov	rax,[r10+rax*8]*/
+#else
 	_mov_r32_m32isd(REG_EAX, REG_EAX, 4, drc->lookup_l1);			/* mov	eax,[eax*4 + l1lookup]*/
+#endif
 	_and_r32_imm(REG_EDX, drc->l2mask);								/* and	edx,l2mask*/
 	_jmp_m32bisd(REG_EAX, REG_EDX, drc->l2scale, 0);				/* jmp	[eax+edx*l2scale]*/
 }
@@ -399,6 +606,20 @@ void drc_append_dispatcher(struct drccore *drc)
 void drc_append_fixed_dispatcher(struct drccore *drc, UINT32 newpc)
 {
 	void **base = drc->lookup_l1[newpc >> drc->l1shift];
+#ifdef DRC_X64
+	/* the lookup tables may be anywhere in the address space */
+	if (base == drc->lookup_l2_recompile)
+	{
+		_mov_r64_imm(REG_R10, &drc->lookup_l1[newpc >> drc->l1shift]);	/* mov	r10,&l1lookup[newpc >> l1shift]*/
+		_mov_r64_m64bd(REG_EAX, REG_R10, 0);							/* mov	rax,[r10]*/
+		_jmp_m32bd(REG_EAX, (newpc & drc->l2mask) * drc->l2scale);		/* jmp	[rax+(newpc & l2mask)*l2scale]*/
+	}
+	else
+	{
+		_mov_r64_imm(REG_R10, (UINT8 *)base + (newpc & drc->l2mask) * drc->l2scale);/* mov	r10,&l2lookup[newpc & l2mask]*/
+		_jmp_m64bd(REG_R10, 0);											/* jmp	[r10]*/
+	}
+#else
 	if (base == drc->lookup_l2_recompile)
 	{
 		_mov_r32_m32abs(REG_EAX, &drc->lookup_l1[newpc >> drc->l1shift]);/* mov	eax,[(newpc >> l1shift)*4 + l1lookup]*/
@@ -406,6 +627,7 @@ void drc_append_fixed_dispatcher(struct drccore *drc, UINT32 newpc)
 	}
 	else
 		_jmp_m32abs((UINT8 *)base + (newpc & drc->l2mask) * drc->l2scale);	/* jmp	[eax+(newpc & l2mask)*l2scale]*/
+#endif
 }
 
 
@@ -433,7 +655,12 @@ void drc_append_tentative_fixed_dispatcher(struct drccore *drc, UINT32 newpc)
 
 void drc_append_set_fp_rounding(struct drccore *drc, UINT8 regindex)
 {
+#ifdef DRC_X64
+	_mov_r64_imm(REG_R10, &fp_control[0]);							/* mov	r10,fp_control*/
+	_fldcw_m16bisd(REG_R10, regindex, 2, 0);						/* fldcw [r10 + reg*2]*/
+#else
 	_fldcw_m16isd(regindex, 2, &fp_control[0]);						/* fldcw [fp_control + reg*2]*/
+#endif
 	_fnstcw_m16abs(&drc->fpcw_curr);								/* fnstcw [fpcw_curr]*/
 }
 
@@ -461,6 +688,48 @@ void drc_append_restore_fp_rounding(struct drccore *drc)
 
 
 
+/*------------------------------------------------------------------
+	drc_in_reach - true if generated code can
+	address the given host memory directly
+------------------------------------------------------------------*/
+
+int drc_in_reach(struct drccore *drc, void *addr)
+{
+#ifdef DRC_X64
+	INT64 lo = (UINT8 *)addr - drc->cache_end - 16;
+	INT64 hi = (UINT8 *)addr - drc->cache_base;
+	return (lo == (INT32)lo && hi == (INT32)hi);
+#else
+	return 1;
+#endif
+}
+
+
+
+#ifdef DRC_X64
+/*------------------------------------------------------------------
+	drc_rip_disp - displacement for a RIP-relative
+	operand at the cache top, followed by an
+	immediate of immsize bytes
+------------------------------------------------------------------*/
+
+INT32 drc_rip_disp(struct drccore *drc, void *addr, int immsize)
+{
+	INT64 delta = (UINT8 *)addr - (drc->cache_top + 4 + immsize);
+	if (delta != (INT32)delta)
+	{
+		/* the sequence being compiled must never run; recompile_code halts the CPU */
+		if (!drc->out_of_reach)
+			log_cb(RETRO_LOG_ERROR, LOGPRE "drc_rip_disp: %p is out of reach of the cache, halting the CPU\n", addr);
+		drc->out_of_reach = 1;
+		return 0;
+	}
+	return (INT32)delta;
+}
+#endif
+
+
+
 /*------------------------------------------------------------------
 	drc_dasm
 
@@ -531,7 +800,12 @@ void drc_dasm(FILE *f, unsigned pc, void *begin, void *end)
 
 static void append_entry_point(struct drccore *drc)
 {
+#ifdef DRC_X64
+	_push_r64(REG_EBX);												/* push	rbx*/
+	_push_r64(REG_EBP);												/* push	rbp*/
+#else
 	_pushad();														/* pushad*/
+#endif
 	if (drc->uses_fp)
 	{
 		_fnstcw_m16abs(&drc->fpcw_save);							/* fstcw [fpcw_save]*/
@@ -544,15 +818,46 @@ static void append_entry_point(struct drccore *drc)
 }
 
 
+#ifdef DRC_X64
+/*------------------------------------------------------------------
+	halt_dispatch - point every lookup at the
+	exit, so code that couldn't address one of
+	its operands never runs; drc_execute won't
+	enter the cache again either
+------------------------------------------------------------------*/
+
+static void halt_dispatch(struct drccore *drc)
+{
+	int i, j;
+
+	for (i = 0; i < (1 << drc->l2bits); i++)
+		drc->lookup_l2_recompile[i] = drc->out_of_cycles;
+	for (i = 0; i < (1 << drc->l1bits); i++)
+		if (drc->lookup_l1[i] != drc->lookup_l2_recompile)
+			for (j = 0; j < (1 << drc->l2bits); j++)
+				drc->lookup_l1[i][j] = drc->out_of_cycles;
+}
+#endif
+
+
 /*------------------------------------------------------------------
 	recompile_code
 ------------------------------------------------------------------*/
 
 static void recompile_code(struct drccore *drc)
 {
-	if (drc->cache_top >= drc->cache_danger)
+	if (drc->cache_top >= drc->cache_danger || drc->block_count >= drc->block_count_max)
 		drc_cache_reset(drc);
+#ifdef DRC_X64
+	if (drc->out_of_reach)
+		return;
+#endif
+	drc_sync_opcodes(drc);
 	(*drc->cb_recompile)(drc);
+#ifdef DRC_X64
+	if (drc->out_of_reach)
+		halt_dispatch(drc);
+#endif
 }
 
 
@@ -562,7 +867,7 @@ static void recompile_code(struct drccore *drc)
 
 static void append_recompile(struct drccore *drc)
 {
-	_push_imm(drc);													/* push	drc*/
+	_push_ptr(drc);													/* push	drc*/
 	drc_append_save_call_restore(drc, (void *)recompile_code, 4);	/* call	recompile_code*/
 	drc_append_dispatcher(drc);										/* dispatch*/
 }
@@ -580,9 +885,49 @@ static void append_out_of_cycles(struct drccore *drc)
 		_fnclex();													/* fnclex*/
 		_fldcw_m16abs(&drc->fpcw_save);								/* fldcw [fpcw_save]*/
 	}
+#ifdef DRC_X64
+	_pop_r64(REG_EBP);												/* pop	rbp*/
+	_pop_r64(REG_EBX);												/* pop	rbx*/
+#else
 	_popad();														/* popad*/
+#endif
+	_ret();															/* ret*/
+}
+
+
+#ifdef DRC_X64
+/*------------------------------------------------------------------
+	append_call_thunk
+
+	Generated code pushes arguments in 8-byte
+	slots and calls with the target in R11; move
+	the first four into System V registers, keep
+	RSI/RDI, which the 32-bit code treats as
+	preserved, and split a 64-bit result into
+	EDX:EAX
+------------------------------------------------------------------*/
+
+static void append_call_thunk(struct drccore *drc)
+{
+	_push_r64(REG_EBP);												/* push	rbp*/
+	_mov_r64_r64(REG_EBP, REG_ESP);									/* mov	rbp,rsp*/
+	_push_r64(REG_ESI);												/* push	rsi*/
+	_push_r64(REG_EDI);												/* push	rdi*/
+	_mov_r64_m64bd(REG_EDI, REG_EBP, 16);							/* mov	rdi,[rbp+16]*/
+	_mov_r64_m64bd(REG_ESI, REG_EBP, 24);							/* mov	rsi,[rbp+24]*/
+	_mov_r64_m64bd(REG_EDX, REG_EBP, 32);							/* mov	rdx,[rbp+32]*/
+	_mov_r64_m64bd(REG_ECX, REG_EBP, 40);							/* mov	rcx,[rbp+40]*/
+	_and_r64_imm(REG_ESP, -16);										/* and	rsp,-16*/
+	_call_r64(REG_R11);												/* call	r11*/
+	_mov_r64_r64(REG_EDX, REG_EAX);									/* mov	rdx,rax*/
+	_shr_r64_imm(REG_EDX, 32);										/* shr	rdx,32*/
+	_lea_r64_m64bd(REG_ESP, REG_EBP, -16);							/* lea	rsp,[rbp-16]*/
+	_pop_r64(REG_EDI);												/* pop	rdi*/
+	_pop_r64(REG_ESI);												/* pop	rsi*/
+	_pop_r64(REG_EBP);												/* pop	rbp*/
 	_ret();															/* ret*/
 }
+#endif
 
 
 /*------------------------------------------------------------------
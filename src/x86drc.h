@@ -12,6 +12,16 @@
 #define __DRCCORE_H__
 
 
+/* x86-64 hosts run the same 32-bit code; the differences are confined to */
+/* absolute addressing, the stack and calls out to C, all handled here */
+#if defined(__x86_64__) || defined(__amd64__)
+#ifdef _WIN32
+#error "the x86-64 DRC only supports the System V calling convention"
+#endif
+#define DRC_X64
+#endif
+
+
 /*###################################################################################################
 **	TYPE DEFINITIONS
 **#################################################################################################*/
@@ -23,6 +33,14 @@ struct pc_ptr_pair
 	UINT8 *		target;
 };
 
+/* PC span of a compiled sequence */
+struct drcblock
+{
+	UINT32		start;					/* PC the sequence is entered at */
+	UINT32		end;					/* last PC the sequence covers */
+	UINT8 *		code;					/* code the sequence was compiled to */
+};
+
 /* core interface structure for the drc common code */
 struct drccore
 {
@@ -43,11 +61,18 @@ struct drccore
 	void *		out_of_cycles;			/* pointer to out of cycles jump point */
 	void *		recompile;				/* pointer to recompile jump point */
 	void *		dispatch;				/* pointer to dispatch jump point */
+#ifdef DRC_X64
+	void *		call_thunk;				/* pointer to the C call thunk */
+	size_t		alloc_size;				/* size of the mapping holding this structure and the cache */
+	UINT8		out_of_reach;			/* set when an operand couldn't be addressed; the CPU is halted */
+#endif
 
 	UINT32 *	pcptr;					/* pointer to where the PC is stored */
 	UINT32 *	icountptr;				/* pointer to where the icount is stored */
 	UINT32 *	esiptr;					/* pointer to where the volatile data in ESI is stored */
 
+	UINT8		cpunum;					/* CPU whose code is cached */
+
 	UINT8		uses_fp;				/* true if we need the FP unit */
 	UINT8		uses_sse;				/* true if we need the SSE unit */
 	UINT16		fpcw_curr;				/* current FPU control word */
@@ -61,6 +86,9 @@ struct drccore
 	struct pc_ptr_pair *tentative_list;	/* PC/pointer sets for tentative branches */
 	UINT32		tentative_count;		/* number of tentative branches */
 	UINT32		tentative_count_max;	/* max number of tentative branches */
+	struct drcblock *block_list;		/* every sequence in the cache */
+	UINT32		block_count;			/* number of sequences in the cache */
+	UINT32		block_count_max;		/* max number of sequences before the cache is reset */
 
 	void 		(*cb_reset)(struct drccore *drc);		/* callback when the cache is reset */
 	void 		(*cb_recompile)(struct drccore *drc);	/* callback when code needs to be recompiled */
@@ -100,8 +128,8 @@ struct linkdata
 **#################################################################################################*/
 
 /* useful macros for accessing hi/lo portions of 64-bit values */
-#define LO(x)		(&(((UINT32 *)(x))[0]))
-#define HI(x)		(&(((UINT32 *)(x))[1]))
+#define LO(x)		((UINT32 *)(x) + 0)
+#define HI(x)		((UINT32 *)(x) + 1)
 
 extern const UINT8 scale_lookup[];
 
@@ -147,6 +175,11 @@ extern const UINT8 scale_lookup[];
 #define REG_XMM6	6
 #define REG_XMM7	7
 
+#ifdef DRC_X64
+#define REG_R10		10			/* scratch registers for the x86-64 glue; */
+#define REG_R11		11			/* never live across generated 32-bit code */
+#endif
+
 #define NO_BASE		5
 
 #define COND_A		7
@@ -197,6 +230,7 @@ extern const UINT8 scale_lookup[];
 #define OP1(x)		do { *drc->cache_top++ = (UINT8)(x); } while (0)
 #define OP2(x)		do { *(UINT16 *)drc->cache_top = (UINT16)(x); drc->cache_top += 2; } while (0)
 #define OP4(x)		do { *(UINT32 *)drc->cache_top = (UINT32)(x); drc->cache_top += 4; } while (0)
+#define OP8(x)		do { *(UINT64 *)drc->cache_top = (UINT64)(x); drc->cache_top += 8; } while (0)
 
 
 
@@ -209,19 +243,38 @@ extern const UINT8 scale_lookup[];
 do { OP1(0xc0 | (((reg) & 7) << 3) | ((rm) & 7)); } while (0)
 
 /* op  reg,[addr]*/
-#define MODRM_MABS(reg, addr)	\
+/* on x86-64 this is [rip+disp], which needs the size of any immediate that follows */
+#ifdef DRC_X64
+#define MODRM_MABS_IMM(reg, addr, immsize)	\
+do { OP1(0x05 | (((reg) & 7) << 3)); OP4(drc_rip_disp(drc, (void *)(addr), immsize)); } while (0)
+#else
+#define MODRM_MABS_IMM(reg, addr, immsize)	\
 do { OP1(0x05 | (((reg) & 7) << 3)); OP4(addr); } while (0)
+#endif
+
+#define MODRM_MABS(reg, addr)	\
+	MODRM_MABS_IMM(reg, addr, 0)
 
 /* op  reg,[base+disp]*/
+/* on x86-64 stack slots are 8 bytes, so ESP-relative displacements, */
+/* which are always written in 32-bit slots, are doubled */
+#ifdef DRC_X64
+#define MODRM_MBD(reg, base, disp) \
+	MODRM_MBD_RAW(reg, base, ((base) == REG_ESP) ? (INT32)(disp) * 2 : (INT32)(disp))
+#else
 #define MODRM_MBD(reg, base, disp) \
+	MODRM_MBD_RAW(reg, base, disp)
+#endif
+
+#define MODRM_MBD_RAW(reg, base, disp) \
 do {														\
-	if ((UINT32)(disp) == 0 && (base) != REG_ESP && (base) != REG_EBP) \
+	if ((UINT32)(disp) == 0 && ((base) & 7) != REG_ESP && ((base) & 7) != REG_EBP) \
 	{														\
 		OP1(0x00 | (((reg) & 7) << 3) | ((base) & 7));		\
 	}														\
 	else if ((INT8)(INT32)(disp) == (INT32)(disp))			\
 	{														\
-		if ((base) == REG_ESP)								\
+		if (((base) & 7) == REG_ESP)						\
 		{													\
 			OP1(0x44 | (((reg) & 7) << 3));					\
 			OP1(0x24);										\
@@ -235,7 +288,7 @@ do {														\
 	}														\
 	else													\
 	{														\
-		if ((base) == REG_ESP)								\
+		if (((base) & 7) == REG_ESP)						\
 		{													\
 			OP1(0x84 | (((reg) & 7) << 3));					\
 			OP1(0x24);										\
@@ -289,6 +342,14 @@ do { OP1(0x50+(reg)); } while (0)
 #define _push_imm(imm) \
 do { OP1(0x68); OP4(imm); } while (0)
 
+#ifdef DRC_X64
+#define _push_ptr(ptr) \
+do { _mov_r64_imm(REG_R10, ptr); _push_r64(REG_R10); } while (0)
+#else
+#define _push_ptr(ptr) \
+do { _push_imm(ptr); } while (0)
+#endif
+
 #define _push_m32abs(addr) \
 do { OP1(0xff); MODRM_MABS(6, addr); } while (0)
 
@@ -380,7 +441,7 @@ do { OP1(0x8b); MODRM_MBISD(dreg, base, indx, scale, disp); } while (0)
 
 
 #define _mov_m8abs_imm(addr, imm) \
-do { OP1(0xc6); MODRM_MABS(0, addr); OP1(imm); } while (0)
+do { OP1(0xc6); MODRM_MABS_IMM(0, addr, 1); OP1(imm); } while (0)
 
 #define _mov_m8abs_r8(addr, sreg) \
 do { OP1(0x88); MODRM_MABS(sreg, addr); } while (0)
@@ -397,7 +458,7 @@ do { OP1(0x88); MODRM_MBISD(sreg, base, indx, scale, disp); } while (0)
 
 
 #define _mov_m16abs_imm(addr, imm) \
-do { OP1(0x66); OP1(0xc7); MODRM_MABS(0, addr); OP2(imm); } while (0)
+do { OP1(0x66); OP1(0xc7); MODRM_MABS_IMM(0, addr, 2); OP2(imm); } while (0)
 
 #define _mov_m16abs_r16(addr, sreg) \
 do { OP1(0x66); OP1(0x89); MODRM_MABS(sreg, addr); } while (0)
@@ -409,7 +470,7 @@ do { OP1(0x66); OP1(0x89); MODRM_MBD(sreg, base, disp); } while (0)
 
 
 #define _mov_m32abs_imm(addr, imm) \
-do { OP1(0xc7); MODRM_MABS(0, addr); OP4(imm); } while (0)
+do { OP1(0xc7); MODRM_MABS_IMM(0, addr, 4); OP4(imm); } while (0)
 
 #define _mov_m32bisd_imm(base, indx, scale, addr, imm) \
 do { OP1(0xc7); MODRM_MBISD(0, base, indx, scale, addr); OP4(imm); } while (0)
@@ -599,8 +660,13 @@ do {												\
 	}												\
 } while (0)
 
+#ifdef DRC_X64
+#define _add_r32_imm(dreg, imm) \
+do { if ((dreg) == REG_ESP) { OP1(0x48); _arith_r32_imm_common(0, dreg, (imm) * 2); } else _arith_r32_imm_common(0, dreg, imm); } while (0)
+#else
 #define _add_r32_imm(dreg, imm) \
 do { _arith_r32_imm_common(0, dreg, imm); } while (0)
+#endif
 
 #define _adc_r32_imm(dreg, imm) \
 do { _arith_r32_imm_common(2, dreg, imm); } while (0)
@@ -614,8 +680,13 @@ do { _arith_r32_imm_common(3, dreg, imm); } while (0)
 #define _and_r32_imm(dreg, imm) \
 do { _arith_r32_imm_common(4, dreg, imm); } while (0)
 
+#ifdef DRC_X64
+#define _sub_r32_imm(dreg, imm) \
+do { if ((dreg) == REG_ESP) { OP1(0x48); _arith_r32_imm_common(5, dreg, (imm) * 2); } else _arith_r32_imm_common(5, dreg, imm); } while (0)
+#else
 #define _sub_r32_imm(dreg, imm) \
 do { _arith_r32_imm_common(5, dreg, imm); } while (0)
+#endif
 
 #define _xor_r32_imm(dreg, imm) \
 do { _arith_r32_imm_common(6, dreg, imm); } while (0)
@@ -636,11 +707,11 @@ do { OP1(0x23); MODRM_REG(dreg, sreg); } while (0)
 do {												\
 	if ((INT8)(imm) == (INT32)(imm))				\
 	{												\
-		OP1(0x83); MODRM_MABS(reg, addr); OP1(imm);	\
+		OP1(0x83); MODRM_MABS_IMM(reg, addr, 1); OP1(imm);\
 	}												\
 	else											\
 	{												\
-		OP1(0x81); MODRM_MABS(reg, addr); OP4(imm);	\
+		OP1(0x81); MODRM_MABS_IMM(reg, addr, 4); OP4(imm);\
 	}												\
 } while (0)
 
@@ -669,7 +740,7 @@ do { _arith_m32abs_imm_common(6, addr, imm); } while (0)
 do { _arith_m32abs_imm_common(7, addr, imm); } while (0)
 
 #define _test_m32abs_imm(addr, imm) \
-do { OP1(0xf7); MODRM_MABS(0, addr); OP4(imm); } while (0)
+do { OP1(0xf7); MODRM_MABS_IMM(0, addr, 4); OP4(imm); } while (0)
 
 
 
@@ -693,6 +764,15 @@ do { _arith_m32bd_imm_common(0, base, disp, imm); } while (0)
 #define _and_r32_m32bd(dreg, base, disp) \
 do { OP1(0x23); MODRM_MBD(dreg, base, disp); } while (0)
 
+/* and  dreg,[table+indx] for a table in host memory */
+#ifdef DRC_X64
+#define _and_r32_m32tbl(dreg, indx, table) \
+do { _mov_r64_imm(REG_R10, table); OP1(0x41); OP1(0x23); MODRM_MBISD(dreg, REG_R10, indx, 1, 0); } while (0)
+#else
+#define _and_r32_m32tbl(dreg, indx, table) \
+do { _and_r32_m32bd(dreg, indx, table); } while (0)
+#endif
+
 
 
 #define _imul_r32(reg) \
@@ -743,11 +823,11 @@ do {												\
 	OP1(0x66);										\
 	if ((INT8)(imm) == (INT16)(imm))				\
 	{												\
-		OP1(0x83); MODRM_MABS(reg, addr); OP1(imm);	\
+		OP1(0x83); MODRM_MABS_IMM(reg, addr, 1); OP1(imm);\
 	}												\
 	else											\
 	{												\
-		OP1(0x81); MODRM_MABS(reg, addr); OP2(imm);	\
+		OP1(0x81); MODRM_MABS_IMM(reg, addr, 2); OP2(imm);\
 	}												\
 } while (0)
 
@@ -773,12 +853,12 @@ do { _arith_m16abs_imm_common(6, addr, imm); } while (0)
 do { _arith_m16abs_imm_common(7, addr, imm); } while (0)
 
 #define _test_m16abs_imm(addr, imm) \
-do { OP1(0xf7); MODRM_MABS(0, addr); OP2(imm); } while (0)
+do { OP1(0xf7); MODRM_MABS_IMM(0, addr, 2); OP2(imm); } while (0)
 
 
 
 #define _arith_m8abs_imm_common(reg, addr, imm)		\
-do { OP1(0x80); MODRM_MABS(reg, addr); OP1(imm); } while (0)
+do { OP1(0x80); MODRM_MABS_IMM(reg, addr, 1); OP1(imm); } while (0)
 
 #define _add_m8abs_imm(addr, imm) \
 do { _arith_m8abs_imm_common(0, addr, imm); } while (0)
@@ -802,7 +882,7 @@ do { _arith_m8abs_imm_common(6, addr, imm); } while (0)
 do { _arith_m8abs_imm_common(7, addr, imm); } while (0)
 
 #define _test_m8abs_imm(addr, imm) \
-do { OP1(0xf6); MODRM_MABS(0, addr); OP1(imm); } while (0)
+do { OP1(0xf6); MODRM_MABS_IMM(0, addr, 1); OP1(imm); } while (0)
 
 #define _and_m16bd_r16(base, disp, sreg) \
 do { OP1(0x66); OP1(0x21); MODRM_MBD(sreg, base, disp); } while (0)
@@ -974,12 +1054,19 @@ do { OP1(0xeb); OP1(0x00); (link)->target = drc->cache_top; (link)->size = 1; }
 do { OP1(0xe9); OP4(0x00); (link)->target = drc->cache_top; (link)->size = 4; } while (0)
 
 #define _jmp(target) \
-do { OP1(0xe9); OP4((UINT32)(target) - ((UINT32)drc->cache_top + 4)); } while (0)
+do { OP1(0xe9); OP4((UINT8 *)(target) - (drc->cache_top + 4)); } while (0)
 
 
 
+/* on x86-64, C functions are reached through the call thunk, which moves */
+/* the pushed arguments into registers; R11 holds the real target */
+#ifdef DRC_X64
+#define _call(target) \
+do { _mov_r64_imm(REG_R11, target); OP1(0xe8); OP4((UINT8 *)drc->call_thunk - (drc->cache_top + 4)); } while (0)
+#else
 #define _call(target) \
-do { if (drc->uses_fp) OP1(0xe8); OP4((UINT32)(target) - ((UINT32)drc->cache_top + 4)); } while (0)
+do { OP1(0xe8); OP4((UINT8 *)(target) - (drc->cache_top + 4)); } while (0)
+#endif
 
 
 
@@ -1110,6 +1197,64 @@ do { OP1(0x66); OP1(0x0f); OP1(0xef); MODRM_REG(r1, r2); } while (0)
 
 
 
+/*###################################################################################################
+**	X86-64 EMITTERS
+**#################################################################################################*/
+
+#ifdef DRC_X64
+
+#define REX(w, reg, indx, base) \
+do { OP1(0x40 | ((w) << 3) | ((((reg) >> 3) & 1) << 2) | ((((indx) >> 3) & 1) << 1) | (((base) >> 3) & 1)); } while (0)
+
+#define _push_r64(reg) \
+do { if ((reg) & 8) OP1(0x41); OP1(0x50 + ((reg) & 7)); } while (0)
+
+#define _pop_r64(reg) \
+do { if ((reg) & 8) OP1(0x41); OP1(0x58 + ((reg) & 7)); } while (0)
+
+#define _mov_r64_imm(dreg, imm) \
+do { REX(1, 0, 0, dreg); OP1(0xb8 + ((dreg) & 7)); OP8(imm); } while (0)
+
+#define _mov_r64_r64(dreg, sreg) \
+do { REX(1, dreg, 0, sreg); OP1(0x8b); MODRM_REG(dreg, sreg); } while (0)
+
+#define _mov_r64_m64bd(dreg, base, disp) \
+do { REX(1, dreg, 0, base); OP1(0x8b); MODRM_MBD_RAW(dreg, base, disp); } while (0)
+
+#define _mov_r64_m64bisd(dreg, base, indx, scale, disp) \
+do { REX(1, dreg, indx, base); OP1(0x8b); MODRM_MBISD(dreg, base, indx, scale, disp); } while (0)
+
+#define _lea_r64_m64bd(dreg, base, disp) \
+do { REX(1, dreg, 0, base); OP1(0x8d); MODRM_MBD_RAW(dreg, base, disp); } while (0)
+
+#define _and_r64_imm(dreg, imm) \
+do { REX(1, 0, 0, dreg); _arith_r32_imm_common(4, dreg, imm); } while (0)
+
+#define _shr_r64_imm(dreg, imm) \
+do { REX(1, 0, 0, dreg); OP1(0xc1); MODRM_REG(5, dreg); OP1(imm); } while (0)
+
+#define _cmp_m8bd_imm(base, disp, imm) \
+do { REX(0, 0, 0, base); OP1(0x80); MODRM_MBD_RAW(7, base, disp); OP1(imm); } while (0)
+
+#define _cmp_m16bd_imm(base, disp, imm) \
+do { OP1(0x66); REX(0, 0, 0, base); OP1(0x81); MODRM_MBD_RAW(7, base, disp); OP2(imm); } while (0)
+
+#define _cmp_m32bd_imm(base, disp, imm) \
+do { REX(0, 0, 0, base); OP1(0x81); MODRM_MBD_RAW(7, base, disp); OP4(imm); } while (0)
+
+#define _fldcw_m16bisd(base, indx, scale, disp) \
+do { REX(0, 0, indx, base); OP1(0xd9); MODRM_MBISD(5, base, indx, scale, disp); } while (0)
+
+#define _jmp_m64bd(base, disp) \
+do { REX(0, 0, 0, base); OP1(0xff); MODRM_MBD_RAW(4, base, disp); } while (0)
+
+#define _call_r64(reg) \
+do { REX(0, 0, 0, reg); OP1(0xff); MODRM_REG(2, reg); } while (0)
+
+#endif
+
+
+
 /*###################################################################################################
 **	FUNCTION PROTOTYPES
 **#################################################################################################*/
@@ -1122,9 +1267,11 @@ void drc_exit(struct drccore *drc);
 
 /* code management */
 void drc_begin_sequence(struct drccore *drc, UINT32 pc);
-void drc_end_sequence(struct drccore *drc);
+void drc_end_sequence(struct drccore *drc, UINT32 lastpc);
 void drc_register_code_at_cache_top(struct drccore *drc, UINT32 pc);
 void *drc_get_code_at_pc(struct drccore *drc, UINT32 pc);
+void drc_invalidate_range(struct drccore *drc, UINT32 start, UINT32 end);
+void drc_sync_opcodes(struct drccore *drc);
 
 /* standard appendages */
 void drc_append_dispatcher(struct drccore *drc);
@@ -1140,6 +1287,12 @@ void drc_append_set_fp_rounding(struct drccore *drc, UINT8 regindex);
 void drc_append_set_temp_fp_rounding(struct drccore *drc, UINT8 rounding);
 void drc_append_restore_fp_rounding(struct drccore *drc);
 
+#ifdef DRC_X64
+/* x86-64 addressing */
+INT32 drc_rip_disp(struct drccore *drc, void *addr, int immsize);
+#endif
+int drc_in_reach(struct drccore *drc, void *addr);
+
 /* disassembling drc code */
 void drc_dasm(FILE *f, unsigned pc, void *begin, void *end);
 